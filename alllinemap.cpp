@@ -13,6 +13,11 @@
 
 #include <iomanip>
 #include <time.h>
+#include <unordered_map>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 AllLine::MapData
 AllLine::generate(Communicator *comm, ShapeGraph &map,
@@ -103,11 +108,40 @@ void AllLine::generate(Communicator *comm, ShapeGraph &map, AllLine::MapData &ma
         comm->CommPostMessage(Communicator::NUM_RECORDS, mapData.polygons.vertexPossibles.size());
     }
 
+    // The open vertices are handled one at a time, largest first, as the lines, connections and
+    // open vertices added depend on which vertices have been handled before. Most of the work
+    // however is finding the vertices visible from each, which does not, so whenever the next
+    // vertex has no links yet, the links of all the open vertices without them are made at once
     std::set<AxialVertex> openvertices;
     openvertices.insert(vertex);
+    std::map<AxialVertexKey, std::vector<AxialVertexLink>> vertexLinks;
     while (!openvertices.empty()) {
-        mapData.polygons.makeAxialLines(openvertices, axiallines, preaxialdata,
+        auto linksIt = vertexLinks.find(*openvertices.rbegin());
+        if (linksIt == vertexLinks.end()) {
+            std::vector<const AxialVertex *> pending;
+            for (const auto &openvertex : openvertices) {
+                if (vertexLinks.find(openvertex) == vertexLinks.end()) {
+                    pending.push_back(&openvertex);
+                }
+            }
+            std::vector<std::vector<AxialVertexLink>> pendingLinks(pending.size());
+            auto n = static_cast<int>(pending.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+            for (int i = 0; i < n; i++) {
+                pendingLinks[static_cast<size_t>(i)] =
+                    mapData.polygons.makeVertexLinks(*pending[static_cast<size_t>(i)]);
+            }
+            for (size_t i = 0; i < pending.size(); i++) {
+                vertexLinks.emplace(*pending[i], std::move(pendingLinks[i]));
+            }
+            linksIt = vertexLinks.find(*openvertices.rbegin());
+        }
+        mapData.polygons.addVertexLinks(openvertices, linksIt->second, axiallines, preaxialdata,
                                         mapData.polyConnections, mapData.radialLines);
+        vertexLinks.erase(linksIt);
         count++;
         //
         if (comm) {
@@ -120,25 +154,70 @@ void AllLine::generate(Communicator *comm, ShapeGraph &map, AllLine::MapData &ma
         }
     }
 
+    // the radial lines are only sorted once at the end, keeping the first of any duplicates
+    std::stable_sort(mapData.radialLines.begin(), mapData.radialLines.end());
+    mapData.radialLines.erase(std::unique(mapData.radialLines.begin(), mapData.radialLines.end()),
+                              mapData.radialLines.end());
+
     if (comm) {
         comm->CommPostMessage(Communicator::CURRENT_STEP, 3);
         comm->CommPostMessage(Communicator::CURRENT_RECORD, 0);
     }
 
-    // cut out duplicates:
+    // cut out duplicates: every line takes over the key vertices of any later line with both
+    // ends within the tolerance of its own. Lines are hashed by the cell their start falls into,
+    // with cells as large as the tolerance, so only lines in the neighbouring cells are compared
+    double maxdim = std::max(region.width(), region.height());
+    double tolerance = maxdim * TOLERANCE_B;
+    double cellSize = tolerance > 0.0 ? tolerance : 1.0;
+    auto cellOf = [&](const Point2f &p) {
+        return std::make_pair(
+            static_cast<int64_t>(std::floor((p.x - region.bottomLeft.x) / cellSize)),
+            static_cast<int64_t>(std::floor((p.y - region.bottomLeft.y) / cellSize)));
+    };
+    auto cellHash = [](int64_t x, int64_t y) {
+        return static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(y);
+    };
+    std::unordered_map<uint64_t, std::vector<size_t>> startCells;
+    for (size_t k = 0; k < axiallines.size(); k++) {
+        auto [x, y] = cellOf(axiallines[k].start());
+        startCells[cellHash(x, y)].push_back(k);
+    }
+    std::vector<bool> duplicate(axiallines.size(), false);
     for (size_t j = 0; j < axiallines.size(); j++) {
-        for (size_t k = axiallines.size() - 1; k > j; k--) {
-            double maxdim = std::max(region.width(), region.height());
-            if (axiallines[j].start().approxeq(axiallines[k].start(), maxdim * TOLERANCE_B) &&
-                axiallines[j].end().approxeq(axiallines[k].end(), maxdim * TOLERANCE_B)) {
-                for (int preaxiali : preaxialdata[k]) {
-                    preaxialdata[j].insert(preaxiali);
+        if (duplicate[j]) {
+            continue;
+        }
+        auto [x, y] = cellOf(axiallines[j].start());
+        for (int64_t dx = -1; dx <= 1; dx++) {
+            for (int64_t dy = -1; dy <= 1; dy++) {
+                auto cell = startCells.find(cellHash(x + dx, y + dy));
+                if (cell == startCells.end()) {
+                    continue;
+                }
+                for (size_t k : cell->second) {
+                    if (k <= j || duplicate[k]) {
+                        continue;
+                    }
+                    if (axiallines[j].start().approxeq(axiallines[k].start(), tolerance) &&
+                        axiallines[j].end().approxeq(axiallines[k].end(), tolerance)) {
+                        preaxialdata[j].insert(preaxialdata[k].begin(), preaxialdata[k].end());
+                        duplicate[k] = true;
+                    }
                 }
-                preaxialdata.erase(preaxialdata.begin() + static_cast<int>(k));
-                axiallines.erase(axiallines.begin() + static_cast<int>(k));
             }
         }
     }
+    size_t kept = 0;
+    for (size_t k = 0; k < axiallines.size(); k++) {
+        if (!duplicate[k]) {
+            axiallines[kept] = axiallines[k];
+            preaxialdata[kept] = std::move(preaxialdata[k]);
+            kept++;
+        }
+    }
+    axiallines.resize(kept);
+    preaxialdata.resize(kept);
 
     region.grow(0.99); // <- this paired with crop code below to prevent error
     map.init(axiallines.size(),
@@ -289,8 +368,7 @@ std::tuple<ShapeGraph, ShapeGraph> AllLine::extractFewestLineMaps(Communicator *
     // make new lines here (assumes line map has only lines
     for (int sk = 0; sk < static_cast<int>(map.getAllShapes().size()); sk++) {
         if (!minimiser.removed(sk)) {
-            linesM.push_back(genlib::getMapAtIndex(map.getAllShapes(), static_cast<size_t>(sk))
-                                 ->second.getLine());
+            linesM.push_back(map.getShapeRefFromIndex(static_cast<size_t>(sk))->second.getLine());
         }
     }
 
@@ -329,21 +407,49 @@ void AllLine::makeDivisions(ShapeGraph &map, const std::vector<PolyConnector> &p
         comm->CommPostMessage(Communicator::NUM_RECORDS, polyconnections.size());
     }
 
-    long double tolerance = sqrt(TOLERANCE_A); // * polyconnections[i].line.length();
+    // the divisions only ever grow, so the lines cut by each poly connection are found in
+    // parallel and added to them afterwards
+    std::vector<std::map<RadialKey, std::set<int>>::iterator> connIters;
+    std::vector<int> connindices;
     for (size_t i = 0; i < polyconnections.size(); i++) {
-        PixelRefVector pixels = map.pixelateLine(polyconnections[i].line);
-        std::vector<size_t> testedshapes;
         auto connIter = radialdivisions.find(polyconnections[i].key);
         if (connIter == radialdivisions.end()) {
             throw genlib::RuntimeException("Connection not found when making divisions");
         }
-        auto connindex = static_cast<int>(std::distance(radialdivisions.begin(), connIter));
+        connIters.push_back(connIter);
+    }
+    {
+        // the index of each division in the map, without walking the map for each connection
+        std::map<RadialKey, int> divisionIndices;
+        int index = 0;
+        for (auto &division : radialdivisions) {
+            divisionIndices.emplace_hint(divisionIndices.end(), division.first, index++);
+        }
+        for (auto &connIter : connIters) {
+            connindices.push_back(divisionIndices[connIter->first]);
+        }
+    }
+
+    long double tolerance = sqrt(TOLERANCE_A); // * polyconnections[i].line.length();
+    std::vector<std::vector<int>> cutShapes(polyconnections.size());
+    size_t count = 0;
+    auto n = static_cast<int>(polyconnections.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int ii = 0; ii < n; ii++) {
+        auto i = static_cast<size_t>(ii);
+        PixelRefVector pixels = map.pixelateLine(polyconnections[i].line);
+        std::vector<size_t> testedshapes;
+        int connindex = connindices[i];
         for (size_t j = 0; j < pixels.size(); j++) {
             PixelRef pix = pixels[j];
             const auto &shapes = map.getShapesAtPixel(pix);
             for (const ShapeRef &shape : shapes) {
-                auto iter = genlib::findBinary(testedshapes, shape.shapeRef);
-                if (iter != testedshapes.end()) {
+                auto iter = std::lower_bound(testedshapes.begin(), testedshapes.end(),
+                                             static_cast<size_t>(shape.shapeRef));
+                if (iter != testedshapes.end() && *iter == shape.shapeRef) {
                     continue;
                 }
                 testedshapes.insert(iter, shape.shapeRef);
@@ -361,26 +467,14 @@ void AllLine::makeDivisions(ShapeGraph &map, const std::vector<PolyConnector> &p
                     case 0:
                         break;
                     case 2: {
-                        auto index = static_cast<int>(genlib::findIndexFromKey(
-                            axialdividers, static_cast<int>(shape.shapeRef)));
-                        if (index != static_cast<int>(shape.shapeRef)) {
-                            throw 1; // for the code to work later this can't be true!
-                        }
-                        axialdividers[index].insert(connindex);
-                        connIter->second.insert(static_cast<int>(shape.shapeRef));
+                        cutShapes[i].push_back(static_cast<int>(shape.shapeRef));
                     } break;
                     case 1: {
-                        auto index = static_cast<int>(genlib::findIndexFromKey(
-                            axialdividers, static_cast<int>(shape.shapeRef)));
-                        if (index != static_cast<int>(shape.shapeRef)) {
-                            throw 1; // for the code to work later this can't be true!
-                        }
                         //
                         // this makes sure actually crosses between the line and the
                         // openspace properly
                         if (radiallines[static_cast<size_t>(connindex)].cuts(line)) {
-                            axialdividers[index].insert(connindex);
-                            connIter->second.insert(static_cast<int>(shape.shapeRef));
+                            cutShapes[i].push_back(static_cast<int>(shape.shapeRef));
                         }
                     } break;
                     default:
@@ -389,13 +483,45 @@ void AllLine::makeDivisions(ShapeGraph &map, const std::vector<PolyConnector> &p
                 }
             }
         }
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
+
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+        count++; // <- increment count
+
+#if defined(_OPENMP)
+        // comm updates only from the main thread
+        if (omp_get_thread_num() == 0)
+#endif
+            if (comm) {
+                if (qtimer(atime, 500)) {
+                    if (comm->IsCancelled()) {
+                        throw Communicator::CancelledException();
+                    }
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
             }
+    }
+
+    // the axial dividers are indexed by shape ref, so the shape refs have to run from 0 up
+    std::vector<bool> dividerIndexed(axialdividers.size(), false);
+    {
+        int index = 0;
+        for (auto &divider : axialdividers) {
+            if (divider.first == index && static_cast<size_t>(index) < dividerIndexed.size()) {
+                dividerIndexed[static_cast<size_t>(index)] = true;
+            }
+            index++;
+        }
+    }
+    for (size_t i = 0; i < polyconnections.size(); i++) {
+        for (int shapeRef : cutShapes[i]) {
+            if (shapeRef < 0 || static_cast<size_t>(shapeRef) >= dividerIndexed.size() ||
+                !dividerIndexed[static_cast<size_t>(shapeRef)]) {
+                throw 1; // for the code to work later this can't be true!
+            }
+            axialdividers[shapeRef].insert(connindices[i]);
+            connIters[i]->second.insert(shapeRef);
         }
     }
 }
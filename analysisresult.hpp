@@ -4,8 +4,6 @@
 
 #pragma once
 
-#include "genlib/simplematrix.hpp"
-
 #include "latticemap.hpp"
 #include "shapegraph.hpp"
 #include "shapemap.hpp"
@@ -29,6 +27,7 @@ struct AnalysisResult {
         auto colIt = std::find(m_newAttributes.begin(), m_newAttributes.end(), attribute);
         if (colIt == m_newAttributes.end()) {
             m_newAttributes.push_back(attribute);
+            resizeColumns();
         }
     }
     const std::vector<std::string> &getAttributes() const { return m_newAttributes; }
@@ -42,30 +41,127 @@ struct AnalysisResult {
         return static_cast<size_t>(std::distance(m_newAttributes.begin(), iter));
     }
 
-    double getValue(size_t row, size_t column) { return m_attributeDatata(row, column); }
+    double getValue(size_t row, size_t column) const {
+        checkIndex(row, column);
+        if (m_floatPrecision) {
+            const auto &values = m_floatColumns[column];
+            return values.empty() ? m_defaultValue : static_cast<double>(values[row]);
+        }
+        const auto &values = m_columns[column];
+        return values.empty() ? m_defaultValue : values[row];
+    }
     void setValue(size_t row, size_t column, double value) {
-        m_attributeDatata(row, column) = value;
+        checkIndex(row, column);
+        if (m_floatPrecision) {
+            columnValues(m_floatColumns, column)[row] = static_cast<float>(value);
+        } else {
+            columnValues(m_columns, column)[row] = value;
+        }
     }
     void incrValue(size_t row, size_t column, double value = 1) {
-        m_attributeDatata(row, column) += value;
+        checkIndex(row, column);
+        if (m_floatPrecision) {
+            columnValues(m_floatColumns, column)[row] += static_cast<float>(value);
+        } else {
+            columnValues(m_columns, column)[row] += value;
+        }
     }
 
+    /**
+     * @param floatPrecision store the values as float rather than double, halving the memory
+     * taken by the result. The values end up as float in the attribute tables in any case
+     */
     AnalysisResult(std::vector<std::string> &&attributeNames = std::vector<std::string>(),
-                   size_t rowCount = 0, double defValue = -1.0f)
-        : _padding0(0), _padding1(0), m_newAttributes(attributeNames),
-          m_attributeDatata(genlib::RowMatrix<double>(rowCount, attributeNames.size())),
-          m_newShapeMaps(), m_newLatticeMaps(), m_newShapeGraphs() {
-        m_attributeDatata.initialiseValues(defValue);
+                   size_t rowCount = 0, double defValue = -1.0f, bool floatPrecision = false)
+        : _padding0(0), _padding1(0), m_newAttributes(attributeNames), m_rowCount(rowCount),
+          m_defaultValue(defValue), m_columns(), m_floatColumns(), m_newShapeMaps(),
+          m_newLatticeMaps(), m_newShapeGraphs(), m_floatPrecision(floatPrecision),
+          _padding2(0), _padding3(0) {
+        resizeColumns();
     }
+    AnalysisResult(AnalysisResult &&) = default;
+    AnalysisResult &operator=(AnalysisResult &&) = default;
+    AnalysisResult(const AnalysisResult &) = delete;
+    AnalysisResult &operator=(const AnalysisResult &) = delete;
 
-    genlib::RowMatrix<double> getAttributeData() const { return m_attributeDatata; }
+    size_t getRowCount() const { return m_rowCount; }
+
+    /**
+     * @brief Whether a column has been written to. Columns that have not hold the default value
+     * in every row and take no memory
+     */
+    bool hasColumnValues(size_t column) const {
+        checkColumn(column);
+        return m_floatPrecision ? !m_floatColumns[column].empty() : !m_columns[column].empty();
+    }
+
+    /**
+     * @brief Move the values of a column out of the result, leaving the column unwritten
+     * @return one value for each row, the default value if the column was never written to
+     */
+    std::vector<float> takeColumnValues(size_t column) {
+        checkColumn(column);
+        std::vector<float> values;
+        if (m_floatPrecision) {
+            values = std::move(m_floatColumns[column]);
+            m_floatColumns[column].clear();
+        } else if (!m_columns[column].empty()) {
+            values.assign(m_columns[column].begin(), m_columns[column].end());
+            std::vector<double>().swap(m_columns[column]);
+        }
+        if (values.empty()) {
+            values.assign(m_rowCount, static_cast<float>(m_defaultValue));
+        }
+        return values;
+    }
 
   protected:
     std::vector<std::string> m_newAttributes = std::vector<std::string>();
-    genlib::RowMatrix<double> m_attributeDatata;
+    size_t m_rowCount;
+    double m_defaultValue;
+    // the values by column, each column allocated when first written to, in double or float
+    // depending on the precision asked for
+    std::vector<std::vector<double>> m_columns;
+    std::vector<std::vector<float>> m_floatColumns;
     std::vector<ShapeMap> m_newShapeMaps;
     std::vector<LatticeMap> m_newLatticeMaps;
     std::vector<ShapeGraph> m_newShapeGraphs;
+    bool m_floatPrecision;
+
+  private:
+    [[maybe_unused]] unsigned _padding2 : 3 * 8;
+    [[maybe_unused]] unsigned _padding3 : 4 * 8;
+
+    void checkColumn(size_t column) const {
+        if (column >= m_newAttributes.size()) {
+            throw std::out_of_range("column out of range");
+        }
+    }
+
+    void checkIndex(size_t row, size_t column) const {
+        if (row >= m_rowCount) {
+            throw std::out_of_range("row out of range");
+        }
+        checkColumn(column);
+    }
+
+    template <typename T>
+    std::vector<T> &columnValues(std::vector<std::vector<T>> &columns, size_t column) {
+        auto &values = columns[column];
+        if (values.empty()) {
+            values.assign(m_rowCount, static_cast<T>(m_defaultValue));
+        }
+        return values;
+    }
+
+  protected:
+    void resizeColumns() {
+        if (m_floatPrecision) {
+            m_floatColumns.resize(m_newAttributes.size());
+        } else {
+            m_columns.resize(m_newAttributes.size());
+        }
+    }
 };
 
 struct AppendableAnalysisResult : public AnalysisResult {
@@ -85,5 +181,11 @@ struct AppendableAnalysisResult : public AnalysisResult {
         }
         m_newAttributes.insert(m_newAttributes.end(), other.getAttributes().begin(),
                                other.getAttributes().end());
+        resizeColumns();
     }
 };
+
+// Step depth helper: the column of a named set of origins (the plain column if unnamed)
+inline std::string getOriginSetColumn(const std::string &column, const std::string &originSetName) {
+    return originSetName.empty() ? column : column + " " + originSetName;
+}
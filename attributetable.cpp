@@ -5,11 +5,14 @@
 #include "attributetable.hpp"
 
 #include "displayparams.hpp"
+#include "layermanagerimpl.hpp"
 
+#include "genlib/mappedfile.hpp"
 #include "genlib/readwritehelpers.hpp"
 #include "genlib/stringutils.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 #include <sstream>
 
@@ -74,6 +77,14 @@ size_t AttributeColumnImpl::read(std::istream &stream) {
     return static_cast<size_t>(physicalColumn);
 }
 
+void AttributeColumnImpl::skip(std::istream &stream) {
+    dXstring::skipString(stream);
+    stream.seekg(sizeof(float) * 2 + sizeof(double) + sizeof(int) + sizeof(bool) * 2 +
+                     sizeof(DisplayParams),
+                 std::ios::cur);
+    dXstring::skipString(stream);
+}
+
 void AttributeColumnImpl::write(std::ostream &stream, int physicalCol) {
     dXstring::writeString(stream, m_name);
     auto smin = static_cast<float>(stats.min);
@@ -90,66 +101,71 @@ void AttributeColumnImpl::write(std::ostream &stream, int physicalCol) {
 
 // AttributeRow implementation
 float AttributeRowImpl::getValue(const std::string &column) const {
-    return getValue(m_colManager.getColumnIndex(column));
+    return getValue(m_table.getColumnIndex(column));
 }
 
 float AttributeRowImpl::getValue(size_t index) const {
     checkIndex(index);
-    return m_data[index];
+    return m_table.m_columnValues[index][m_row];
 }
 
 float AttributeRowImpl::getNormalisedValue(size_t index) const {
     checkIndex(index);
-    auto &colStats = m_colManager.getColumn(index).getStats();
+    auto &colStats = m_table.getColumn(index).getStats();
     if (colStats.max == colStats.min) {
         return 0.5f;
     }
-    return m_data[index] < 0
-               ? -1.0f
-               : static_cast<float>((m_data[index] - colStats.min) / (colStats.max - colStats.min));
+    float value = m_table.m_columnValues[index][m_row];
+    return value < 0 ? -1.0f
+                     : static_cast<float>((value - colStats.min) / (colStats.max - colStats.min));
 }
 
 AttributeRow &AttributeRowImpl::setValue(const std::string &column, float value) {
-    return setValue(m_colManager.getColumnIndex(column), value);
+    return setValue(m_table.getColumnIndex(column), value);
 }
 
 AttributeRow &AttributeRowImpl::setValue(size_t index, float value) {
     checkIndex(index);
-    float oldVal = m_data[index];
-    m_data[index] = value;
+    float &data = m_table.m_columnValues[index][m_row];
+    float oldVal = data;
+    data = value;
     if (oldVal < 0.0f) {
         oldVal = 0.0f;
     }
-    m_colManager.getColumn(index).updateStats(value, oldVal);
+    m_table.m_columns[index].updateStats(value, oldVal);
+    m_table.recordChange(index, m_row);
     return *this;
 }
 
-void AttributeRowImpl::addColumn() { m_data.push_back(-1); }
-
-void AttributeRowImpl::removeColumn(size_t index) {
-    checkIndex(index);
-    m_data.erase(m_data.begin() + static_cast<int>(index));
-}
-
 void AttributeRowImpl::read(std::istream &stream) {
     stream.read(reinterpret_cast<char *>(&m_layerKey), sizeof(m_layerKey));
-    dXreadwrite::readIntoVector(stream, m_data);
+    std::vector<float> data;
+    dXreadwrite::readIntoVector(stream, data);
+    size_t numColumns = std::min(data.size(), m_table.m_columnValues.size());
+    for (size_t i = 0; i < numColumns; i++) {
+        m_table.m_columnValues[i][m_row] = data[i];
+    }
 }
 
 void AttributeRowImpl::write(std::ostream &stream) {
     stream.write(reinterpret_cast<const char *>(&m_layerKey), sizeof(m_layerKey));
-    dXreadwrite::writeVector(stream, m_data);
+    std::vector<float> data;
+    data.reserve(m_table.m_columnValues.size());
+    for (const auto &values : m_table.m_columnValues) {
+        data.push_back(values[m_row]);
+    }
+    dXreadwrite::writeVector(stream, data);
 }
 
 void AttributeRowImpl::checkIndex(size_t index) const {
-    if (index >= m_data.size()) {
+    if (index >= m_table.m_columnValues.size() || m_row >= m_table.m_rowsByIndex.size()) {
         throw std::out_of_range("AttributeColumn index out of range");
     }
 }
 
 AttributeRow &AttributeRowImpl::incrValue(size_t index, float value) {
     checkIndex(index);
-    float val = m_data[index];
+    float val = m_table.m_columnValues[index][m_row];
     if (val < 0) {
         setValue(index, value);
     } else {
@@ -159,7 +175,7 @@ AttributeRow &AttributeRowImpl::incrValue(size_t index, float value) {
 }
 
 AttributeRow &AttributeRowImpl::incrValue(const std::string &colName, float value) {
-    return incrValue(m_colManager.getColumnIndex(colName), value);
+    return incrValue(m_table.getColumnIndex(colName), value);
 }
 
 AttributeRow &AttributeTable::getRow(const AttributeKey &key) {
@@ -207,9 +223,7 @@ AttributeRow &AttributeTable::addRow(const AttributeKey &key) {
     if (iter != m_rows.end()) {
         throw new std::invalid_argument("Duplicate key");
     }
-    auto res = m_rows.insert(
-        std::make_pair(key, std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this))));
-    return *res.first->second;
+    return addRowInternal(key);
 }
 
 void AttributeTable::removeRow(const AttributeKey &key) {
@@ -217,7 +231,21 @@ void AttributeTable::removeRow(const AttributeKey &key) {
     if (iter == m_rows.end()) {
         throw new std::invalid_argument("Row does not exist");
     }
+    // keep the columns dense by moving the last row into the place of the removed one
+    size_t rowIdx = iter->second->m_row;
+    size_t lastIdx = m_rowsByIndex.size() - 1;
+    for (auto &values : m_columnValues) {
+        values[rowIdx] = values[lastIdx];
+        values.pop_back();
+    }
+    m_rowsByIndex[rowIdx] = m_rowsByIndex[lastIdx];
+    m_rowsByIndex[rowIdx]->second->m_row = rowIdx;
+    m_rowsByIndex.pop_back();
+    if (rowIdx != lastIdx) {
+        m_rowsInKeyOrder = false;
+    }
     m_rows.erase(iter);
+    m_layoutVersion++;
 }
 
 AttributeColumn &AttributeTable::getColumn(size_t index) {
@@ -238,9 +266,9 @@ size_t AttributeTable::insertOrResetColumn(const std::string &columnName,
     // it exists - we need to reset it
     m_columns[iter->second].stats = AttributeColumnStats();
     m_columns[iter->second].setLock(false);
-    for (auto &row : m_rows) {
-        row.second->setValue(iter->second, -1.0f);
-    }
+    auto &values = m_columnValues[iter->second];
+    std::fill(values.begin(), values.end(), -1.0f);
+    recordReset(iter->second);
     return iter->second;
 }
 
@@ -278,9 +306,9 @@ void AttributeTable::removeColumn(size_t colIndex) {
         }
     }
     m_columns.erase(m_columns.begin() + static_cast<int>(colIndex));
-    for (auto &row : m_rows) {
-        row.second->removeColumn(colIndex);
-    }
+    m_columnValues.erase(m_columnValues.begin() + static_cast<int>(colIndex));
+    m_columnChanges.erase(m_columnChanges.begin() + static_cast<int>(colIndex));
+    m_layoutVersion++;
 }
 
 void AttributeTable::renameColumn(const std::string &oldName, const std::string &newName) {
@@ -314,21 +342,103 @@ void AttributeTable::read(std::istream &stream, LayerManager &layerManager) {
     for (auto &c : tmp) {
         m_columnMapping[c.second.getName()] = m_columns.size();
         m_columns.push_back(c.second);
+        m_columnValues.emplace_back(m_rowsByIndex.size(), -1.0f);
+        m_columnChanges.emplace_back();
     }
 
     int rowcount, rowkey;
     stream.read(reinterpret_cast<char *>(&rowcount), sizeof(rowcount));
-    for (int i = 0; i < rowcount; i++) {
-        stream.read(reinterpret_cast<char *>(&rowkey), sizeof(rowkey));
-        auto row = std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this));
-        row->read(stream);
-        m_rows.insert(std::make_pair(AttributeKey(rowkey), std::move(row)));
+    if (rowcount > 0) {
+        m_rowsByIndex.reserve(m_rowsByIndex.size() + static_cast<size_t>(rowcount));
+        for (auto &values : m_columnValues) {
+            values.reserve(values.size() + static_cast<size_t>(rowcount));
+        }
+    }
+    auto *buffer = dynamic_cast<genlib::MemoryStreamBuffer *>(stream.rdbuf());
+    if (buffer == nullptr || !stream.good() || !readRowsInBulk(stream, *buffer, rowcount)) {
+        for (int i = 0; i < rowcount; i++) {
+            stream.read(reinterpret_cast<char *>(&rowkey), sizeof(rowkey));
+            addRowInternal(AttributeKey(rowkey)).read(stream);
+        }
+    }
+    for (size_t i = 0; i < m_columnChanges.size(); i++) {
+        recordReset(i);
     }
 
     // ref column display params
     stream.read(reinterpret_cast<char *>(&m_displayParams), sizeof(DisplayParams));
 }
 
+void AttributeTable::skip(std::istream &stream) {
+    LayerManagerImpl::skip(stream);
+    int colcount = 0;
+    stream.read(reinterpret_cast<char *>(&colcount), sizeof(colcount));
+    for (int j = 0; j < colcount; j++) {
+        AttributeColumnImpl::skip(stream);
+    }
+    int rowcount = 0;
+    stream.read(reinterpret_cast<char *>(&rowcount), sizeof(rowcount));
+    for (int i = 0; i < rowcount; i++) {
+        stream.seekg(sizeof(int) + sizeof(LayerManager::KeyType), std::ios::cur);
+        dXreadwrite::skipVector<float>(stream);
+    }
+    stream.seekg(sizeof(DisplayParams), std::ios::cur);
+}
+
+bool AttributeTable::readRowsInBulk(std::istream &stream, genlib::MemoryStreamBuffer &buffer,
+                                    int rowcount) {
+    // the rows are first skipped through to find where their values are, so that if any of them
+    // are cut short the stream can be put back to be read as usual
+    const char *start = buffer.current();
+    std::vector<int> rowKeys;
+    std::vector<LayerManager::KeyType> layerKeys;
+    std::vector<const char *> rowData;
+    std::vector<unsigned int> rowDataSizes;
+    for (int i = 0; i < rowcount; i++) {
+        int rowkey;
+        LayerManager::KeyType layerKey;
+        unsigned int size = 0;
+        stream.read(reinterpret_cast<char *>(&rowkey), sizeof(rowkey));
+        stream.read(reinterpret_cast<char *>(&layerKey), sizeof(layerKey));
+        stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+        rowKeys.push_back(rowkey);
+        layerKeys.push_back(layerKey);
+        rowData.push_back(buffer.current());
+        rowDataSizes.push_back(size);
+        stream.seekg(static_cast<std::streamoff>(sizeof(float) * size), std::ios::cur);
+        if (stream.fail()) {
+            stream.clear();
+            buffer.moveTo(start);
+            return false;
+        }
+    }
+
+    std::vector<size_t> rowIndices;
+    rowIndices.reserve(rowKeys.size());
+    for (size_t i = 0; i < rowKeys.size(); i++) {
+        AttributeRowImpl &row = addRowInternal(AttributeKey(rowKeys[i]));
+        row.setLayerKey(layerKeys[i]);
+        rowIndices.push_back(row.m_row);
+    }
+
+    // then the values of each column are copied in straight from the buffer
+    auto n = static_cast<int>(m_columnValues.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static)
+#endif
+    for (int i = 0; i < n; i++) {
+        auto col = static_cast<size_t>(i);
+        std::vector<float> &values = m_columnValues[col];
+        for (size_t j = 0; j < rowIndices.size(); j++) {
+            if (col < rowDataSizes[j]) {
+                std::memcpy(&values[rowIndices[j]], rowData[j] + col * sizeof(float),
+                            sizeof(float));
+            }
+        }
+    }
+    return true;
+}
+
 void AttributeTable::write(std::ostream &stream, const LayerManager &layerManager) {
     layerManager.write(stream);
     auto colCount = static_cast<int>(m_columns.size());
@@ -358,7 +468,12 @@ void AttributeTable::write(std::ostream &stream, const LayerManager &layerManage
 
 void AttributeTable::clear() {
     m_rows.clear();
+    m_rowsByIndex.clear();
+    m_rowsInKeyOrder = true;
     m_columns.clear();
+    m_columnValues.clear();
+    m_columnChanges.clear();
+    m_layoutVersion++;
     m_columnMapping.clear();
 }
 
@@ -392,6 +507,93 @@ size_t AttributeTable::getColumnSortedIndex(size_t index) const {
         std::distance(m_columnMapping.begin(), m_columnMapping.find(getColumnName(index))));
 }
 
+const std::vector<float> &AttributeTable::getColumnValues(size_t colIndex) const {
+    checkColumnIndex(colIndex);
+    return m_columnValues[colIndex];
+}
+
+void AttributeTable::setColumnValues(size_t colIndex, std::vector<float> values) {
+    checkColumnIndex(colIndex);
+    if (values.size() != m_rowsByIndex.size()) {
+        throw std::invalid_argument("Column values do not match the number of rows");
+    }
+    // the same stats as setting each value on a reset column in key order would give. The total
+    // restarts whenever it is negative, so it has to be accumulated in order
+    AttributeColumnStats stats;
+    for (float value : values) {
+        if (stats.total < 0) {
+            stats.total = value;
+        } else {
+            stats.total += value;
+        }
+        if (value > stats.max) {
+            stats.max = value;
+        }
+        if (stats.min < 0 || value < stats.min) {
+            stats.min = value;
+        }
+    }
+    m_columns[colIndex].stats = stats;
+    recordReset(colIndex);
+
+    auto &columnValues = m_columnValues[colIndex];
+    if (m_rowsInKeyOrder) {
+        columnValues = std::move(values);
+    } else {
+        auto valueIt = values.begin();
+        for (auto &row : m_rows) {
+            columnValues[row.second->m_row] = *valueIt++;
+        }
+    }
+}
+
+const AttributeKey &AttributeTable::getDenseRowKey(size_t rowIdx) const {
+    return m_rowsByIndex.at(rowIdx)->first;
+}
+
+AttributeRow &AttributeTable::getDenseRow(size_t rowIdx) {
+    return *m_rowsByIndex.at(rowIdx)->second;
+}
+
+const AttributeRow &AttributeTable::getDenseRow(size_t rowIdx) const {
+    return *m_rowsByIndex.at(rowIdx)->second;
+}
+
+std::vector<size_t> AttributeTable::getDenseRowIndices() const {
+    std::vector<size_t> indices;
+    indices.reserve(m_rows.size());
+    for (auto &row : m_rows) {
+        indices.push_back(row.second->m_row);
+    }
+    return indices;
+}
+
+std::optional<size_t> AttributeTable::getDenseRowIndex(const AttributeKey &key) const {
+    auto iter = m_rows.find(key);
+    if (iter == m_rows.end()) {
+        return std::nullopt;
+    }
+    return iter->second->m_row;
+}
+
+size_t AttributeTable::getColumnVersion(size_t colIndex) const {
+    checkColumnIndex(colIndex);
+    return m_columnChanges[colIndex].version;
+}
+
+std::optional<std::vector<size_t>> AttributeTable::getColumnChanges(size_t colIndex,
+                                                                   size_t sinceVersion) const {
+    checkColumnIndex(colIndex);
+    const auto &changes = m_columnChanges[colIndex];
+    if (sinceVersion < changes.loggedFrom || sinceVersion > changes.version) {
+        return std::nullopt;
+    }
+    // one row is logged for each version after the first
+    return std::vector<size_t>(changes.rows.begin() +
+                                   static_cast<std::ptrdiff_t>(sinceVersion - changes.loggedFrom),
+                               changes.rows.end());
+}
+
 const AttributeColumn &AttributeTable::getColumn(size_t index) const {
     if (index == static_cast<size_t>(-1)) {
         return m_keyColumn;
@@ -420,9 +622,42 @@ void AttributeTable::checkColumnIndex(size_t index) const {
 size_t AttributeTable::addColumnInternal(const std::string &name, const std::string &formula) {
     size_t colIndex = m_columns.size();
     m_columns.push_back(AttributeColumnImpl(name, formula));
+    m_columnValues.emplace_back(m_rowsByIndex.size(), -1.0f);
+    m_columnChanges.emplace_back();
     m_columnMapping[name] = colIndex;
-    for (auto &elem : m_rows) {
-        elem.second->addColumn();
-    }
     return colIndex;
 }
+
+AttributeRowImpl &AttributeTable::addRowInternal(const AttributeKey &key) {
+    size_t rowIdx = m_rowsByIndex.size();
+    for (auto &values : m_columnValues) {
+        values.push_back(-1.0f);
+    }
+    auto res = m_rows.insert(std::make_pair(
+        key, std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this, rowIdx))));
+    m_rowsByIndex.push_back(res.first);
+    if (std::next(res.first) != m_rows.end()) {
+        m_rowsInKeyOrder = false;
+    }
+    m_layoutVersion++;
+    return *res.first->second;
+}
+
+void AttributeTable::recordChange(size_t colIndex, size_t rowIdx) {
+    auto &changes = m_columnChanges[colIndex];
+    changes.version++;
+    if (changes.rows.size() < MAX_LOGGED_CHANGES) {
+        changes.rows.push_back(rowIdx);
+    } else {
+        // too many to be worth keeping, start again from here
+        changes.rows.clear();
+        changes.loggedFrom = changes.version;
+    }
+}
+
+void AttributeTable::recordReset(size_t colIndex) {
+    auto &changes = m_columnChanges[colIndex];
+    changes.version++;
+    changes.rows.clear();
+    changes.loggedFrom = changes.version;
+}
@@ -16,6 +16,10 @@
 #include <string>
 #include <vector>
 
+namespace genlib {
+    class MemoryStreamBuffer;
+} // namespace genlib
+
 ///
 /// Namespace to hold known attributes
 ///
@@ -134,6 +138,7 @@ class AttributeColumnImpl : public AttributeColumn, AttributeColumnStats {
     // returns the physical column for comaptibility with the old attribute table
     size_t read(std::istream &stream);
     void write(std::ostream &stream, int physicalCol);
+    static void skip(std::istream &stream);
 
   private:
     std::string m_name;
@@ -153,11 +158,15 @@ class KeyColumn : public AttributeColumnImpl {
     KeyColumn() : AttributeColumnImpl() { setName(AttributeName::REF); }
 };
 
-// Implementation of AttributeRow
+class AttributeTable;
+
+// Implementation of AttributeRow - a view on one row of the columns stored in the table
 class AttributeRowImpl : public AttributeRow {
   public:
-    AttributeRowImpl(const AttributeColumnManager &colManager)
-        : m_data(colManager.getNumColumns(), -1.0), m_colManager(colManager) {
+    // a row without a place in the table, as used for dummy entries of an attribute index
+    AttributeRowImpl(AttributeTable &table) : AttributeRowImpl(table, static_cast<size_t>(-1)) {}
+
+    AttributeRowImpl(AttributeTable &table, size_t row) : m_table(table), m_row(row) {
         m_layerKey = 1;
     }
 
@@ -171,17 +180,17 @@ class AttributeRowImpl : public AttributeRow {
     AttributeRow &incrValue(const std::string &column, float value) override;
     AttributeRow &incrValue(size_t index, float value) override;
 
-    void addColumn();
-    void removeColumn(size_t index);
-
     void read(std::istream &stream);
     void write(std::ostream &stream);
 
   private:
-    std::vector<float> m_data;
-    const AttributeColumnManager &m_colManager;
+    AttributeTable &m_table;
+    // the dense index of the row in the columns of the table
+    size_t m_row;
 
     void checkIndex(size_t index) const;
+
+    friend class AttributeTable;
 };
 
 ///
@@ -210,8 +219,9 @@ class AttributeTable : public AttributeColumnManager {
     // AttributeTable "interface" - the actual table handling
   public:
     AttributeTable()
-        : m_rows(), m_columnMapping(), m_columns(), m_keyColumn(), m_displayParams(), _padding0(0) {
-    }
+        : m_rows(), m_rowsByIndex(), m_columnMapping(), m_columns(), m_columnValues(),
+          m_columnChanges(), m_layoutVersion(0), m_keyColumn(), m_displayParams(),
+          m_rowsInKeyOrder(true), _padding0(0) {}
     virtual ~AttributeTable() {}
     AttributeTable(AttributeTable &&) = default;
     AttributeTable &operator=(AttributeTable &&) = default;
@@ -265,13 +275,17 @@ class AttributeTable : public AttributeColumnManager {
     void setDisplayParamsForAllAttributes(const DisplayParams &params);
     void read(std::istream &stream, LayerManager &layerManager);
     void write(std::ostream &stream, const LayerManager &layerManager);
+    // move past a table and its layers, without reading them in
+    static void skip(std::istream &stream);
     void clear();
     float getSelAvg(size_t columnIndex, std::set<int> &selSet) {
         float selTotal = 0;
         int selNum = 0;
-        for (auto &pair : m_rows) {
-            if (selSet.find(pair.first.value) != selSet.end()) {
-                selTotal += pair.second->getValue(columnIndex);
+        // the selection is in key order too, so look its rows up rather than going through all
+        for (int key : selSet) {
+            auto iter = m_rows.find(AttributeKey(key));
+            if (iter != m_rows.end()) {
+                selTotal += iter->second->getValue(columnIndex);
                 selNum++;
             }
         }
@@ -294,22 +308,104 @@ class AttributeTable : public AttributeColumnManager {
     // if the set of columns was sorted
     size_t getColumnSortedIndex(size_t index) const;
 
+    ///
+    /// \brief Get the values of a column
+    /// The values are stored contiguously by the dense index of the rows. This is the order in
+    /// which the rows were added, with the last row moved into the place of any removed row, so
+    /// it is not the order of the keys
+    /// \param colIndex index of the column
+    /// \return the values of all rows, throws if the column does not exist
+    ///
+    const std::vector<float> &getColumnValues(size_t colIndex) const;
+
+    ///
+    /// \brief Set all the values of a column at once
+    /// The min, max and total of the column are computed from the values in one pass. The values
+    /// are moved into the column directly if the rows are stored in the order of their keys
+    /// \param colIndex index of the column
+    /// \param values one value for each row, in the order of the keys, throws if the count does
+    /// not match the number of rows
+    ///
+    void setColumnValues(size_t colIndex, std::vector<float> values);
+
+    ///
+    /// \brief Get the key of the row at a dense index of the columns
+    ///
+    const AttributeKey &getDenseRowKey(size_t rowIdx) const;
+    AttributeRow &getDenseRow(size_t rowIdx);
+    const AttributeRow &getDenseRow(size_t rowIdx) const;
+
+    ///
+    /// \brief Get the dense index of each row in the order of the keys
+    ///
+    std::vector<size_t> getDenseRowIndices() const;
+
+    ///
+    /// \brief Get the dense index of a row, nothing if the key is not found
+    ///
+    std::optional<size_t> getDenseRowIndex(const AttributeKey &key) const;
+
+    ///
+    /// \brief Version counters to tell caches of the table contents when to update
+    /// The layout version changes whenever rows are added or removed or columns removed, the
+    /// version of a column whenever any of its values is set
+    ///
+    size_t getLayoutVersion() const { return m_layoutVersion; }
+    size_t getColumnVersion(size_t colIndex) const;
+
+    ///
+    /// \brief Get the rows whose values in a column have been set since a version of the column
+    /// Only the latest changes are kept, and none from before the whole column was set or reset
+    /// \return the dense indices of the rows, possibly repeated, or nothing if the changes since
+    /// the version are no longer known
+    ///
+    std::optional<std::vector<size_t>> getColumnChanges(size_t colIndex,
+                                                        size_t sinceVersion) const;
+
   private:
+    // the rows are views on the columns, looked up by key here and by their dense index in
+    // m_rowsByIndex
     typedef std::map<AttributeKey, std::unique_ptr<AttributeRowImpl>> StorageType;
     StorageType m_rows;
+    std::vector<StorageType::iterator> m_rowsByIndex;
 
     // Requires a transparent comparator to allow comparing with string_view
     // see https://stackoverflow.com/a/35525806
     std::map<std::string, size_t, std::less<>> m_columnMapping;
     std::vector<AttributeColumnImpl> m_columns;
+    // the values of each column, indexed by the dense index of the rows
+    std::vector<std::vector<float>> m_columnValues;
+
+    // how many times the values of each column have been set, and in which rows lately
+    struct ColumnChanges {
+        ColumnChanges() : version(0), loggedFrom(0), rows() {}
+        size_t version;
+        // the version the logged rows follow on from
+        size_t loggedFrom;
+        std::vector<size_t> rows;
+    };
+    static constexpr size_t MAX_LOGGED_CHANGES = 4096;
+    std::vector<ColumnChanges> m_columnChanges;
+    size_t m_layoutVersion;
+
     KeyColumn m_keyColumn;
     DisplayParams m_displayParams;
+    // whether the dense index of the rows follows the order of their keys
+    bool m_rowsInKeyOrder;
 
-    [[maybe_unused]] unsigned _padding0 : 4 * 8;
+    [[maybe_unused]] unsigned _padding0 : 3 * 8;
 
   private:
     void checkColumnIndex(size_t index) const;
     size_t addColumnInternal(const std::string &name, const std::string &formula);
+    AttributeRowImpl &addRowInternal(const AttributeKey &key);
+    void recordChange(size_t colIndex, size_t rowIdx);
+    void recordReset(size_t colIndex);
+    // reads the rows from a stream held in memory, returns false if they could not be read that
+    // way, leaving the stream where it was
+    bool readRowsInBulk(std::istream &stream, genlib::MemoryStreamBuffer &buffer, int rowcount);
+
+    friend class AttributeRowImpl;
 
     // warning - here be dragons!
     // This is the implementation of stl style iterators on attribute table, allowing efficient
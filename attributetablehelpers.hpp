@@ -5,6 +5,7 @@
 #pragma once
 
 #include "attributetable.hpp"
+#include "attributetablestats.hpp"
 #include "attributetableview.hpp"
 #include "mgraph_consts.hpp"
 #include "pafcolor.hpp"
@@ -25,6 +26,7 @@ namespace dXreimpl {
         }
 
         layerManager.setLayerVisible(layerIndex);
+        AttributeStats::updateVisibleStats(table, layerManager);
     }
 
     inline PafColor getDisplayColor(const AttributeKey &key, const AttributeRow &row,
@@ -6,7 +6,10 @@
 
 #include "attributetable.hpp"
 
+#include "genlib/radixsort.hpp"
+
 #include <algorithm>
+#include <tuple>
 
 class ConstAttributeIndexItem {
   public:
@@ -57,6 +60,159 @@ inline bool operator<(const ConstAttributeIndexItem &lhs, const ConstAttributeIn
     return lhs.value < rhs.value;
 }
 
+///
+/// An index of a column of a table sorted by value, as made by makeAttributeIndex. It is kept
+/// along with the versions of the table and the column it was made from, and only made again
+/// once they have changed. If only a few values of the column have been set since, the index is
+/// repaired in place instead
+///
+template <typename Item, typename Table> class CachedAttributeIndex {
+  public:
+    // the index is repaired rather than made again if fewer than one in this many rows changed
+    static constexpr size_t REPAIR_FRACTION = 16;
+
+    CachedAttributeIndex()
+        : m_index(), m_positions(), m_keyPositions(), m_layoutVersion(0), m_columnVersion(0),
+          m_perturbationFactor(0.0), m_colIndex(-2), _padding0(0) {}
+
+    const std::vector<Item> &getIndex() const { return m_index; }
+    std::vector<Item> takeIndex() {
+        std::vector<Item> index = std::move(m_index);
+        clear();
+        return index;
+    }
+
+    void clear() {
+        m_index.clear();
+        m_positions.clear();
+        m_keyPositions.clear();
+        m_colIndex = -2;
+    }
+
+    // colIndex -1 for the keys, throws if less
+    void update(Table &table, int colIndex) {
+        if (colIndex < -1) {
+            throw std::out_of_range("Column index out of range");
+        }
+        size_t numRows = table.getNumRows();
+        // perturb the values to be sorted by so same values will be in order of
+        // appearence in the map
+        double perturbationFactor =
+            numRows == 0 ? 0.0
+            : colIndex == -1
+                ? 1e-9 / static_cast<double>(numRows)
+                : table.getColumn(static_cast<size_t>(colIndex)).getStats().max * 1e-9 /
+                      static_cast<double>(numRows);
+        if (colIndex == m_colIndex && table.getLayoutVersion() == m_layoutVersion &&
+            perturbationFactor == m_perturbationFactor) {
+            if (colIndex == -1) {
+                return;
+            }
+            auto col = static_cast<size_t>(colIndex);
+            size_t columnVersion = table.getColumnVersion(col);
+            if (columnVersion == m_columnVersion) {
+                return;
+            }
+            auto changes = table.getColumnChanges(col, m_columnVersion);
+            if (changes.has_value() && changes->size() * REPAIR_FRACTION < numRows) {
+                repair(table, *changes);
+                m_columnVersion = columnVersion;
+                return;
+            }
+        }
+        m_colIndex = colIndex;
+        m_layoutVersion = table.getLayoutVersion();
+        m_columnVersion =
+            colIndex == -1 ? 0 : table.getColumnVersion(static_cast<size_t>(colIndex));
+        m_perturbationFactor = perturbationFactor;
+        rebuild(table);
+    }
+
+  private:
+    std::vector<Item> m_index;
+    // the position in the order of the keys of each item of the index, and of each dense row
+    std::vector<size_t> m_positions;
+    std::vector<size_t> m_keyPositions;
+    size_t m_layoutVersion;
+    size_t m_columnVersion;
+    double m_perturbationFactor;
+    int m_colIndex;
+
+    [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
+    double indexValue(Table &table, size_t rowIdx, size_t position) const {
+        double value = m_colIndex == -1
+                           ? static_cast<double>(table.getDenseRowKey(rowIdx).value)
+                           : static_cast<double>(table.getColumnValues(
+                                 static_cast<size_t>(m_colIndex))[rowIdx]);
+        return value + static_cast<double>(position) * m_perturbationFactor;
+    }
+
+    void rebuild(Table &table) {
+        std::vector<size_t> rowIndices = table.getDenseRowIndices();
+        m_keyPositions.assign(rowIndices.size(), 0);
+        std::vector<double> values(rowIndices.size());
+        for (size_t position = 0; position < rowIndices.size(); position++) {
+            m_keyPositions[rowIndices[position]] = position;
+            values[position] = indexValue(table, rowIndices[position], position);
+        }
+        // a stable sort, so rows with the same value stay in the order of the keys
+        m_positions = genlib::radixSortOrder(values);
+        m_index.clear();
+        m_index.reserve(m_positions.size());
+        for (size_t position : m_positions) {
+            size_t rowIdx = rowIndices[position];
+            m_index.push_back(
+                Item(table.getDenseRowKey(rowIdx), values[position], table.getDenseRow(rowIdx)));
+        }
+    }
+
+    // takes the changed rows out of the index and merges them back in at their new values,
+    // leaving the index as it would be made again
+    void repair(Table &table, const std::vector<size_t> &changedRows) {
+        std::vector<char> changed(m_index.size(), 0);
+        std::vector<std::tuple<double, size_t, size_t>> fresh;
+        for (size_t rowIdx : changedRows) {
+            size_t position = m_keyPositions[rowIdx];
+            if (!changed[position]) {
+                changed[position] = 1;
+                fresh.emplace_back(indexValue(table, rowIdx, position), position, rowIdx);
+            }
+        }
+        std::sort(fresh.begin(), fresh.end());
+
+        std::vector<Item> index;
+        std::vector<size_t> positions;
+        index.reserve(m_index.size());
+        positions.reserve(m_index.size());
+        auto freshIt = fresh.begin();
+        for (size_t i = 0; i < m_index.size(); i++) {
+            if (changed[m_positions[i]]) {
+                continue;
+            }
+            while (freshIt != fresh.end() &&
+                   std::make_pair(std::get<0>(*freshIt), std::get<1>(*freshIt)) <
+                       std::make_pair(m_index[i].value, m_positions[i])) {
+                addFresh(table, *freshIt++, index, positions);
+            }
+            index.push_back(m_index[i]);
+            positions.push_back(m_positions[i]);
+        }
+        while (freshIt != fresh.end()) {
+            addFresh(table, *freshIt++, index, positions);
+        }
+        m_index = std::move(index);
+        m_positions = std::move(positions);
+    }
+
+    static void addFresh(Table &table, const std::tuple<double, size_t, size_t> &item,
+                         std::vector<Item> &index, std::vector<size_t> &positions) {
+        auto [value, position, rowIdx] = item;
+        index.push_back(Item(table.getDenseRowKey(rowIdx), value, table.getDenseRow(rowIdx)));
+        positions.push_back(position);
+    }
+};
+
 std::vector<ConstAttributeIndexItem> makeAttributeIndex(const AttributeTable &table, int colIndex);
 std::vector<AttributeIndexItem> makeAttributeIndex(AttributeTable &table, int colIndex);
 std::pair<std::vector<AttributeIndexItem>::iterator, std::vector<AttributeIndexItem>::iterator>
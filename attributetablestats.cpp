@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "attributetablestats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // the value at a fraction of the sorted values, found by partially sorting them
+    double findQuantile(std::vector<float> &values, double fraction) {
+        double position = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(values.size() - 1);
+        auto lower = static_cast<size_t>(std::floor(position));
+        auto lowerIt = values.begin() + static_cast<std::ptrdiff_t>(lower);
+        std::nth_element(values.begin(), lowerIt, values.end());
+        double lowerValue = *lowerIt;
+        if (lower + 1 >= values.size()) {
+            return lowerValue;
+        }
+        // everything after the lower value is no less than it, so the next value is the least
+        double upperValue = *std::min_element(lowerIt + 1, values.end());
+        return lowerValue + (upperValue - lowerValue) * (position - static_cast<double>(lower));
+    }
+} // namespace
+
+AttributeStats::RowMask AttributeStats::makeSelectionMask(const AttributeTable &table,
+                                                          const std::set<int> &selSet) {
+    RowMask mask(table.getNumRows(), 0);
+    for (int key : selSet) {
+        auto rowIdx = table.getDenseRowIndex(AttributeKey(key));
+        if (rowIdx.has_value()) {
+            mask[*rowIdx] = 1;
+        }
+    }
+    return mask;
+}
+
+AttributeStats::RowMask AttributeStats::makeVisibleMask(const AttributeTable &table,
+                                                        const LayerManager &layerManager) {
+    RowMask mask(table.getNumRows(), 0);
+    for (size_t rowIdx = 0; rowIdx < mask.size(); rowIdx++) {
+        mask[rowIdx] = isObjectVisible(layerManager, table.getDenseRow(rowIdx)) ? 1 : 0;
+    }
+    return mask;
+}
+
+AttributeStats::RowMask AttributeStats::intersectMasks(const RowMask &maskA,
+                                                       const RowMask &maskB) {
+    if (maskA.size() != maskB.size()) {
+        throw std::invalid_argument("Masks of different sizes");
+    }
+    RowMask mask(maskA.size());
+    for (size_t i = 0; i < mask.size(); i++) {
+        mask[i] = maskA[i] & maskB[i];
+    }
+    return mask;
+}
+
+AttributeStats::Summary AttributeStats::summarise(const AttributeTable &table, size_t colIndex,
+                                                  const std::vector<double> &quantiles,
+                                                  size_t histogramBins, const RowMask *mask) {
+    const std::vector<float> &columnValues = table.getColumnValues(colIndex);
+    if (mask != nullptr && mask->size() != columnValues.size()) {
+        throw std::invalid_argument("Mask does not match the rows of the table");
+    }
+
+    // gather the values to summarise so that everything after works on one plain array
+    std::vector<float> values;
+    values.reserve(columnValues.size());
+    for (size_t i = 0; i < columnValues.size(); i++) {
+        if (columnValues[i] != -1.0f && (mask == nullptr || (*mask)[i])) {
+            values.push_back(columnValues[i]);
+        }
+    }
+
+    Summary summary;
+    summary.quantiles.assign(quantiles.size(), -1.0);
+    summary.histogram.assign(histogramBins, 0);
+    summary.count = values.size();
+    if (values.empty()) {
+        return summary;
+    }
+
+    float minValue = values.front();
+    float maxValue = values.front();
+    double total = 0.0;
+    for (float value : values) {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+        total += static_cast<double>(value);
+    }
+    summary.min = minValue;
+    summary.max = maxValue;
+    summary.total = total;
+    summary.mean = total / static_cast<double>(values.size());
+
+    double squares = 0.0;
+    for (float value : values) {
+        double diff = static_cast<double>(value) - summary.mean;
+        squares += diff * diff;
+    }
+    summary.stdDev = std::sqrt(squares / static_cast<double>(values.size()));
+
+    if (histogramBins != 0) {
+        double range = summary.max - summary.min;
+        double binScale = range > 0.0 ? static_cast<double>(histogramBins) / range : 0.0;
+        for (float value : values) {
+            auto bin = static_cast<size_t>((static_cast<double>(value) - summary.min) * binScale);
+            summary.histogram[std::min(bin, histogramBins - 1)]++;
+        }
+    }
+
+    for (size_t q = 0; q < quantiles.size(); q++) {
+        summary.quantiles[q] = findQuantile(values, quantiles[q]);
+    }
+    return summary;
+}
+
+std::vector<AttributeStats::Summary>
+AttributeStats::summarise(const AttributeTable &table, const std::vector<size_t> &colIndices,
+                          const std::vector<double> &quantiles, size_t histogramBins,
+                          const RowMask *mask) {
+    std::vector<Summary> summaries(colIndices.size());
+    // check the columns first so that nothing throws from the parallel loop
+    for (size_t colIndex : colIndices) {
+        table.getColumnValues(colIndex);
+    }
+    if (mask != nullptr && mask->size() != table.getNumRows()) {
+        throw std::invalid_argument("Mask does not match the rows of the table");
+    }
+    auto n = static_cast<int>(colIndices.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        auto idx = static_cast<size_t>(i);
+        summaries[idx] = summarise(table, colIndices[idx], quantiles, histogramBins, mask);
+    }
+    return summaries;
+}
+
+void AttributeStats::updateVisibleStats(const AttributeTable &table,
+                                        const LayerManager &layerManager) {
+    std::vector<size_t> colIndices(table.getNumColumns());
+    for (size_t i = 0; i < colIndices.size(); i++) {
+        colIndices[i] = i;
+    }
+    RowMask mask = makeVisibleMask(table, layerManager);
+    std::vector<Summary> summaries = summarise(table, colIndices, {}, 0, &mask);
+    for (size_t i = 0; i < colIndices.size(); i++) {
+        const AttributeColumn &column = table.getColumn(i);
+        AttributeColumnStats stats = column.getStats();
+        stats.visibleMin = summaries[i].min;
+        stats.visibleMax = summaries[i].max;
+        stats.visibleTotal = summaries[i].total;
+        column.setStats(stats);
+    }
+}
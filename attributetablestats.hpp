@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "attributetable.hpp"
+#include "layermanager.hpp"
+
+#include <set>
+#include <vector>
+
+///
+/// Statistics of the columns of an attribute table, computed from the contiguous values of each
+/// column (see AttributeTable::getColumnValues) rather than row by row
+///
+namespace AttributeStats {
+
+    ///
+    /// The statistics of the values of a column, leaving out rows without a value (-1)
+    ///
+    struct Summary {
+        Summary() : count(0), min(-1), max(-1), total(-1), mean(-1), stdDev(-1), quantiles(),
+                    histogram() {}
+
+        size_t count;
+        double min;
+        double max;
+        double total;
+        double mean;
+        double stdDev;
+        // the value at each of the fractions asked for, -1 if there are no values
+        std::vector<double> quantiles;
+        // the number of values in each of the bins asked for, splitting the range between min
+        // and max in equal parts
+        std::vector<size_t> histogram;
+    };
+
+    ///
+    /// One flag for each row in the order of the dense row index of the table, whether to include
+    /// the row
+    ///
+    typedef std::vector<char> RowMask;
+
+    RowMask makeSelectionMask(const AttributeTable &table, const std::set<int> &selSet);
+    RowMask makeVisibleMask(const AttributeTable &table, const LayerManager &layerManager);
+    // only the rows included in both masks
+    RowMask intersectMasks(const RowMask &maskA, const RowMask &maskB);
+
+    ///
+    /// \brief Summarise a column of the table
+    /// \param quantiles fractions from 0 to 1 to find the values at, interpolating between the
+    /// values either side
+    /// \param histogramBins number of bins of the histogram, none if 0
+    /// \param mask rows to include, all if null
+    ///
+    Summary summarise(const AttributeTable &table, size_t colIndex,
+                      const std::vector<double> &quantiles = std::vector<double>(),
+                      size_t histogramBins = 0, const RowMask *mask = nullptr);
+
+    ///
+    /// \brief Summarise several columns of the table at once, in parallel
+    ///
+    std::vector<Summary> summarise(const AttributeTable &table,
+                                   const std::vector<size_t> &colIndices,
+                                   const std::vector<double> &quantiles = std::vector<double>(),
+                                   size_t histogramBins = 0, const RowMask *mask = nullptr);
+
+    ///
+    /// \brief Set the visible min, max and total of all columns from the rows on visible layers
+    ///
+    void updateVisibleStats(const AttributeTable &table, const LayerManager &layerManager);
+} // namespace AttributeStats
@@ -13,9 +13,8 @@ void AttributeTableView::setDisplayColIndex(int columnIndex) {
         m_index.clear();
         return;
     }
-    // recalculate the index even if it's the same column in case stuff has
-    // changed
-    m_index = makeAttributeIndex(table, columnIndex);
+    // the index is only remade or repaired if the column has changed since
+    m_index.update(table, columnIndex);
     m_displayColumn = columnIndex;
 }
 
@@ -40,18 +39,18 @@ void AttributeTableHandle::setDisplayColIndex(int columnIndex) {
     if (columnIndex < -1) {
         m_mutableIndex.clear();
     } else {
-        // recalculate the index even if it's the same column in case stuff has
-        // changed
-        m_mutableIndex = makeAttributeIndex(m_mutableTable, columnIndex);
+        // the index is only remade or repaired if the column has changed since
+        m_mutableIndex.update(m_mutableTable, columnIndex);
     }
     AttributeTableView::setDisplayColIndex(columnIndex);
 }
 AttributeTableHandle::Index::iterator::difference_type
 AttributeTableHandle::findInIndex(const AttributeKey &key) {
 
-    auto iter = std::find_if(m_mutableIndex.begin(), m_mutableIndex.end(), index_item_key(key));
-    if (iter != m_mutableIndex.end()) {
-        return (std::distance(m_mutableIndex.begin(), iter));
+    const auto &index = m_mutableIndex.getIndex();
+    auto iter = std::find_if(index.begin(), index.end(), index_item_key(key));
+    if (iter != index.end()) {
+        return (std::distance(index.begin(), iter));
     }
     return -1;
 }
@@ -23,12 +23,12 @@ class AttributeTableView {
     const DisplayParams &getDisplayParams() const;
 
     typedef std::vector<ConstAttributeIndexItem> ConstIndex;
-    const ConstIndex &getConstTableIndex() const { return m_index; }
+    const ConstIndex &getConstTableIndex() const { return m_index.getIndex(); }
 
     const AttributeColumn &getDisplayedColumn() const;
 
   private:
-    ConstIndex m_index;
+    CachedAttributeIndex<ConstAttributeIndexItem, const AttributeTable> m_index;
     int m_displayColumn;
 
     [[maybe_unused]] unsigned _padding0 : 4 * 8;
@@ -40,13 +40,13 @@ class AttributeTableHandle : public AttributeTableView {
         : AttributeTableView(tablIn), m_mutableTable(tablIn), m_mutableIndex() {}
     virtual ~AttributeTableHandle() {}
     typedef std::vector<AttributeIndexItem> Index;
-    const Index &getTableIndex() const { return m_mutableIndex; }
+    const Index &getTableIndex() const { return m_mutableIndex.getIndex(); }
     void setDisplayColIndex(int columnIndex) override;
     Index::iterator::difference_type findInIndex(const AttributeKey &key);
 
   private:
     AttributeTable &m_mutableTable;
-    Index m_mutableIndex;
+    CachedAttributeIndex<AttributeIndexItem, AttributeTable> m_mutableIndex;
 };
 
 struct index_item_key : public std::function<bool(AttributeKey)> {
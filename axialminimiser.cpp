@@ -7,36 +7,235 @@
 
 #include "tolerances.hpp"
 
-static int compareValueTriplet(const void *p1, const void *p2) {
-    auto vp1 = static_cast<const ValueTriplet *>(p1);
-    auto vp2 = static_cast<const ValueTriplet *>(p2);
-    return (vp1->value1 > vp2->value1 ? 1
-            : vp1->value1 < vp2->value1
-                ? -1
-                : (vp1->value2 > vp2->value2   ? 1
-                   : vp1->value2 < vp2->value2 ? -1
-                                               : (vp1->index > vp2->index   ? 1
-                                                  : vp1->index < vp2->index ? -1
-                                                                            : 0)));
-}
+#include <algorithm>
+
+namespace {
+    // the number of lines checked in parallel before any of them are removed
+    const size_t CHECK_BATCH_SIZE = 256;
+
+    bool compareValueTriplet(const ValueTriplet &vp1, const ValueTriplet &vp2) {
+        return vp1.value1 < vp2.value1 ||
+               (vp1.value1 == vp2.value1 &&
+                (vp1.value2 < vp2.value2 || (vp1.value2 == vp2.value2 && vp1.index < vp2.index)));
+    }
+} // namespace
 
 AxialMinimiser::AxialMinimiser(const ShapeGraph &alllinemap, size_t noOfAxsegcuts,
                                size_t noOfRadialsegs)
-    : m_alllinemap(static_cast<const ShapeGraph *>(&alllinemap)),
-      m_vps(new ValueTriplet[noOfAxsegcuts]), m_removed(new bool[noOfAxsegcuts]),
-      m_affected(new bool[noOfAxsegcuts]), m_vital(new bool[noOfAxsegcuts]),
-      m_radialsegcounts(new int[noOfRadialsegs]), m_axialconns() {}
-
-AxialMinimiser::~AxialMinimiser() {
-    delete[] m_vital;
-    delete[] m_affected;
-    delete[] m_radialsegcounts;
-    delete[] m_vps;
-    delete[] m_removed;
+    : m_alllinemap(static_cast<const ShapeGraph *>(&alllinemap)), m_vps(noOfAxsegcuts),
+      m_removed(noOfAxsegcuts, false), m_affected(noOfAxsegcuts, false),
+      m_vital(noOfAxsegcuts, false), m_radialsegcounts(noOfRadialsegs, 0), m_axialconns(),
+      m_lines(), m_axsegcuts(), m_segdivisors(), m_keyvertexlines(), m_segmentlines(),
+      m_dividedsegs(), m_stale() {}
+
+void AxialMinimiser::flatten(std::map<int, std::set<int>> &axsegcuts,
+                             std::map<RadialKey, RadialSegment> &radialsegs,
+                             std::map<RadialKey, std::set<int>> &rlds,
+                             std::vector<RadialLine> &radialLines,
+                             std::vector<std::vector<int>> &keyvertexconns,
+                             size_t keyvertexcount) {
+    m_axialconns = m_alllinemap->m_connectors;
+    size_t lineCount = m_axialconns.size();
+
+    m_lines.clear();
+    for (const auto &shape : m_alllinemap->m_shapes) {
+        m_lines.push_back(shape.second.getLine());
+    }
+
+    m_radialsegcounts.assign(radialsegs.size(), 0);
+    m_axsegcuts.clear();
+    for (const auto &axSegCut : axsegcuts) {
+        m_axsegcuts.emplace_back(axSegCut.second.begin(), axSegCut.second.end());
+        for (int cut : axSegCut.second) {
+            m_radialsegcounts[static_cast<size_t>(cut)] += 1;
+        }
+    }
+    m_removed.assign(lineCount, false);
+    m_vital.assign(lineCount, false);
+    m_affected.assign(lineCount, true);
+
+    // the first of the radial lines with each key, as found by searching through them
+    std::map<RadialKey, const RadialLine *> radialLineKeys;
+    for (const auto &radialLine : radialLines) {
+        radialLineKeys.emplace(static_cast<RadialKey>(radialLine), &radialLine);
+    }
+
+    m_segdivisors.assign(radialsegs.size(), SegmentDivisors());
+    m_dividedsegs.assign(lineCount, std::vector<int>());
+    int cut = 0;
+    for (const auto &[key, seg] : radialsegs) {
+        auto keyIter = rlds.find(key);
+        if (keyIter == rlds.end()) {
+            throw genlib::RuntimeException(
+                "RadialKey A not found when checking for vital axial lines");
+        }
+        auto radialBIter = rlds.find(seg.radialB);
+        if (radialBIter == rlds.end()) {
+            throw genlib::RuntimeException(
+                "RadialKey B not found when checking for vital axial lines");
+        }
+        auto iterKey = radialLineKeys.find(key);
+        auto iterSegB = radialLineKeys.find(seg.radialB);
+        if (iterKey == radialLineKeys.end() || iterSegB == radialLineKeys.end()) {
+            throw genlib::RuntimeException("Radial key not found in radial lines");
+        }
+        SegmentDivisors &divisors = m_segdivisors[static_cast<size_t>(cut)];
+        divisors.divisorsa.assign(keyIter->second.begin(), keyIter->second.end());
+        divisors.divisorsb.assign(radialBIter->second.begin(), radialBIter->second.end());
+        divisors.rlinea = iterKey->second;
+        divisors.rlineb = iterSegB->second;
+        for (const auto *divisorset : {&divisors.divisorsa, &divisors.divisorsb}) {
+            for (int div : *divisorset) {
+                if (div >= 0 && static_cast<size_t>(div) < lineCount) {
+                    m_dividedsegs[static_cast<size_t>(div)].push_back(cut);
+                }
+            }
+        }
+        cut++;
+    }
+
+    m_segmentlines.assign(radialsegs.size(), std::vector<size_t>());
+    m_keyvertexlines.assign(keyvertexcount, std::vector<size_t>());
+    for (size_t y = 0; y < lineCount; y++) {
+        for (int axSegCut : m_axsegcuts[y]) {
+            m_segmentlines[static_cast<size_t>(axSegCut)].push_back(y);
+        }
+        for (int keyvertex : keyvertexconns[y]) {
+            m_keyvertexlines[static_cast<size_t>(keyvertex)].push_back(y);
+        }
+    }
+    m_stale.assign(lineCount, 0);
+    m_batch = 0;
+}
+
+void AxialMinimiser::removeLine(size_t removeindex,
+                                const std::vector<std::vector<int>> &keyvertexconns,
+                                std::vector<int> &keyvertexcounts) {
+    m_removed[removeindex] = true;
+    auto &affectedconnections = m_axialconns[removeindex].connections;
+    for (auto affectedconnection : affectedconnections) {
+        if (!m_removed[affectedconnection]) {
+            auto &connections = m_axialconns[affectedconnection].connections;
+            genlib::findAndErase(connections, removeindex);
+            m_affected[affectedconnection] = true;
+        }
+    }
+    for (int cut : m_axsegcuts[removeindex]) {
+        m_radialsegcounts[static_cast<size_t>(cut)] -= 1;
+    }
+    // vital connections
+    for (int keyvertex : keyvertexconns[removeindex]) {
+        keyvertexcounts[static_cast<size_t>(keyvertex)] -= 1;
+    }
+}
+
+// to be called before the line is removed, while its connections are still in place
+void AxialMinimiser::markStale(size_t removeindex,
+                               const std::vector<std::vector<int>> &keyvertexconns) {
+    // the connections of the lines connected to it change, and so may the subset checks of
+    // any line connected to those
+    m_stale[removeindex] = m_batch;
+    for (auto connection : m_axialconns[removeindex].connections) {
+        m_stale[connection] = m_batch;
+        for (auto secondconnection : m_axialconns[connection].connections) {
+            m_stale[secondconnection] = m_batch;
+        }
+    }
+    for (int keyvertex : keyvertexconns[removeindex]) {
+        for (size_t line : m_keyvertexlines[static_cast<size_t>(keyvertex)]) {
+            m_stale[line] = m_batch;
+        }
+    }
+    for (const auto *cuts : {&m_axsegcuts[removeindex], &m_dividedsegs[removeindex]}) {
+        for (int cut : *cuts) {
+            for (size_t line : m_segmentlines[static_cast<size_t>(cut)]) {
+                m_stale[line] = m_batch;
+            }
+        }
+    }
 }
 
 // Alan and Bill's algo...
 
+AxialMinimiser::Verdict
+AxialMinimiser::checkSubset(size_t ii, const std::vector<std::vector<int>> &keyvertexconns,
+                            const std::vector<int> &keyvertexcounts) const {
+    if (m_removed[ii] || !m_affected[ii] || m_vital[ii]) {
+        return Verdict::SKIP;
+    }
+    // vital connections code (uses original unaltered connections)
+    for (size_t j = 0; j < keyvertexconns[ii].size(); j++) {
+        // first check to see if removing this line will cause elimination of
+        // a vital connection
+        if (keyvertexcounts[static_cast<size_t>(keyvertexconns[ii][j])] <= 1) {
+            // connect vital... just go on to the next one:
+            return Verdict::VITAL_CONNECTION;
+        }
+    }
+    //
+    const Connector &axa = m_axialconns[ii];
+    bool subset = false;
+    for (size_t j = 0; j < axa.connections.size(); j++) {
+        auto indextob = axa.connections[j];
+        if (indextob == ii || m_removed[indextob]) { // <- removed[indextob] should never happen
+                                                     // as it should have been removed below
+            continue;
+        }
+        const Connector &axb = m_axialconns[indextob];
+        if (axa.connections.size() <= axb.connections.size()) {
+            // change to 10.08, coconnecting is 1 -> connection to other line is
+            // implicitly handled
+            int coconnecting = 1;
+            // first check it's a connection subset
+            // note that changes in 10.08 mean that lines no longer connect to
+            // themselves this means that the subset 1 connects {2,3} and 2
+            // connects {1,3} are equivalent
+            for (size_t axai = 0, axbi = 0;
+                 axai < axa.connections.size() && axbi < axb.connections.size();
+                 axai++, axbi++) {
+                // extra 10.08 -> step over connection to b
+                if (axa.connections[axai] == indextob) {
+                    axai++;
+                }
+                // extra 10.08 add axb.connections[axbi] == ii -> step over
+                // connection to
+                // a
+                while (axbi < axb.connections.size() &&
+                       (axb.connections[axbi] == ii ||
+                        axa.connections[axai] > axb.connections[axbi])) {
+                    axbi++;
+                }
+                if (axbi >= axb.connections.size()) {
+                    break;
+                } else if (axa.connections[axai] == axb.connections[axbi]) {
+                    coconnecting++;
+                } else if (axa.connections[axai] < axb.connections[axbi]) {
+                    break;
+                }
+            }
+            if (coconnecting >= static_cast<int>(axa.connections.size())) {
+                subset = true;
+                break;
+            }
+        }
+    }
+    if (!subset) {
+        return Verdict::NOT_SUBSET;
+    }
+    // now check removing it won't break any topological loops
+    bool presumedvital = false;
+    for (int cut : m_axsegcuts[ii]) {
+        if (m_radialsegcounts[static_cast<size_t>(cut)] <= 1) {
+            presumedvital = true;
+            break;
+        }
+    }
+    if (presumedvital) {
+        presumedvital = checkVital(static_cast<int>(ii), m_axsegcuts[ii]);
+    }
+    return presumedvital ? Verdict::VITAL : Verdict::REMOVE;
+}
+
 void AxialMinimiser::removeSubsets(std::map<int, std::set<int>> &axsegcuts,
                                    std::map<RadialKey, RadialSegment> &radialsegs,
                                    std::map<RadialKey, std::set<int>> &rlds,
@@ -45,141 +244,61 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int>> &axsegcuts,
                                    std::vector<int> &keyvertexcounts) {
     bool removedflag = true;
 
-    m_axialconns = m_alllinemap->m_connectors;
+    flatten(axsegcuts, radialsegs, rlds, radialLines, keyvertexconns, keyvertexcounts.size());
 
-    for (size_t x = 0; x < radialsegs.size(); x++) {
-        m_radialsegcounts[x] = 0;
-    }
-    unsigned int y = 0;
-    for (const auto &axSegCut : axsegcuts) {
-        for (int cut : axSegCut.second) {
-            m_radialsegcounts[cut] += 1;
-        }
-        m_removed[y] = false;
-        m_vital[y] = false;
-        m_affected[y] = true;
+    size_t lineCount = m_axialconns.size();
+    m_vps.resize(lineCount);
+    for (size_t y = 0; y < lineCount; y++) {
         m_vps[y].index = static_cast<int>(y);
-        double length = static_cast<double>(m_axialconns[y].connections.size());
-        m_vps[y].value1 = static_cast<int>(length);
-        length = genlib::getMapAtIndex(m_alllinemap->m_shapes, y)->second.getLine().length();
-        m_vps[y].value2 = static_cast<float>(length);
-        y++;
+        m_vps[y].value1 = static_cast<int>(m_axialconns[y].connections.size());
+        m_vps[y].value2 = static_cast<float>(m_lines[y].length());
     }
 
     // sort according to number of connections then length
-    qsort(m_vps, m_axialconns.size(), sizeof(ValueTriplet), compareValueTriplet);
+    std::sort(m_vps.begin(), m_vps.end(), compareValueTriplet);
 
+    std::vector<Verdict> verdicts(CHECK_BATCH_SIZE);
     while (removedflag) {
 
         removedflag = false;
-        for (size_t i = 0; i < m_axialconns.size(); i++) {
-            auto ii = static_cast<size_t>(m_vps[i].index);
-            if (m_removed[ii] || !m_affected[ii] || m_vital[ii]) {
-                continue;
+        for (size_t first = 0; first < lineCount; first += CHECK_BATCH_SIZE) {
+            size_t last = std::min(lineCount, first + CHECK_BATCH_SIZE);
+            m_batch++;
+            auto n = static_cast<int>(last - first);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+            for (int b = 0; b < n; b++) {
+                auto ii = static_cast<size_t>(m_vps[first + static_cast<size_t>(b)].index);
+                verdicts[static_cast<size_t>(b)] =
+                    checkSubset(ii, keyvertexconns, keyvertexcounts);
             }
-            // vital connections code (uses original unaltered connections)
-            {
-                bool vitalconn = false;
-                for (size_t j = 0; j < keyvertexconns[ii].size(); j++) {
-                    // first check to see if removing this line will cause elimination of
-                    // a vital connection
-                    if (keyvertexcounts[static_cast<size_t>(keyvertexconns[ii][j])] <= 1) {
-                        // connect vital... just go on to the next one:
-                        vitalconn = true;
-                        break;
-                    }
-                }
-                if (vitalconn) {
+
+            for (size_t i = first; i < last; i++) {
+                auto ii = static_cast<size_t>(m_vps[i].index);
+                Verdict verdict = isStale(ii) ? checkSubset(ii, keyvertexconns, keyvertexcounts)
+                                              : verdicts[i - first];
+                switch (verdict) {
+                case Verdict::SKIP:
+                    break;
+                case Verdict::VITAL_CONNECTION:
                     m_vital[ii] = true;
-                    continue;
-                }
-            }
-            //
-            Connector &axa = m_axialconns[ii];
-            m_affected[ii] = false;
-            bool subset = false;
-            for (size_t j = 0; j < axa.connections.size(); j++) {
-                auto indextob = axa.connections[j];
-                if (indextob == ii ||
-                    m_removed[indextob]) { // <- removed[indextob] should never happen
-                                           // as it should have been removed below
-                    continue;
-                }
-                Connector &axb = m_axialconns[indextob];
-                if (axa.connections.size() <= axb.connections.size()) {
-                    // change to 10.08, coconnecting is 1 -> connection to other line is
-                    // implicitly handled
-                    int coconnecting = 1;
-                    // first check it's a connection subset
-                    // note that changes in 10.08 mean that lines no longer connect to
-                    // themselves this means that the subset 1 connects {2,3} and 2
-                    // connects {1,3} are equivalent
-                    for (size_t axai = 0, axbi = 0;
-                         axai < axa.connections.size() && axbi < axb.connections.size();
-                         axai++, axbi++) {
-                        // extra 10.08 -> step over connection to b
-                        if (axa.connections[axai] == indextob) {
-                            axai++;
-                        }
-                        // extra 10.08 add axb.connections[axbi] == ii -> step over
-                        // connection to
-                        // a
-                        while (axbi < axb.connections.size() &&
-                               (axb.connections[axbi] == ii ||
-                                axa.connections[axai] > axb.connections[axbi])) {
-                            axbi++;
-                        }
-                        if (axbi >= axb.connections.size()) {
-                            break;
-                        } else if (axa.connections[axai] == axb.connections[axbi]) {
-                            coconnecting++;
-                        } else if (axa.connections[axai] < axb.connections[axbi]) {
-                            break;
-                        }
-                    }
-                    if (coconnecting >= static_cast<int>(axa.connections.size())) {
-                        subset = true;
-                        break;
-                    }
-                }
-            }
-            if (subset) {
-                size_t removeindex = ii;
-                // now check removing it won't break any topological loops
-                bool presumedvital = false;
-                auto &axSegCut = genlib::getMapAtIndex(axsegcuts, removeindex)->second;
-                for (int cut : axSegCut) {
-                    if (m_radialsegcounts[cut] <= 1) {
-                        presumedvital = true;
-                        break;
-                    }
-                }
-                if (presumedvital) {
-                    presumedvital = checkVital(static_cast<int>(removeindex), axSegCut, radialsegs,
-                                               rlds, radialLines);
-                }
-                if (presumedvital) {
-                    m_vital[removeindex] = true;
-                }
-                // if not, remove it...
-                if (!m_vital[removeindex]) {
-                    m_removed[removeindex] = true;
-                    auto &affectedconnections = m_axialconns[removeindex].connections;
-                    for (auto affectedconnection : affectedconnections) {
-                        if (!m_removed[affectedconnection]) {
-                            auto &connections = m_axialconns[affectedconnection].connections;
-                            genlib::findAndErase(connections, removeindex);
-                            m_affected[affectedconnection] = true;
-                        }
-                    }
+                    break;
+                case Verdict::NOT_SUBSET:
+                    m_affected[ii] = false;
+                    break;
+                case Verdict::VITAL:
+                    m_affected[ii] = false;
+                    m_vital[ii] = true;
+                    break;
+                case Verdict::REMOVE:
+                    // if not vital, remove it...
+                    m_affected[ii] = false;
+                    markStale(ii, keyvertexconns);
+                    removeLine(ii, keyvertexconns, keyvertexcounts);
                     removedflag = true;
-                    for (int cut : axSegCut) {
-                        m_radialsegcounts[cut] -= 1;
-                    }
-                    // vital connections
-                    for (size_t k = 0; k < keyvertexconns[removeindex].size(); k++) {
-                        keyvertexcounts[static_cast<size_t>(keyvertexconns[removeindex][k])] -= 1;
-                    }
+                    break;
                 }
             }
         }
@@ -190,91 +309,91 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int>> &axsegcuts,
 
 // My algo... v. simple... fewest longest
 
+AxialMinimiser::Verdict
+AxialMinimiser::checkLongest(size_t j, const std::vector<std::vector<int>> &keyvertexconns,
+                             const std::vector<int> &keyvertexcounts) const {
+    // vital connections code (uses original unaltered connections)
+    for (size_t k = 0; k < keyvertexconns[j].size(); k++) {
+        // first check to see if removing this line will cause elimination of a
+        // vital connection
+        if (keyvertexcounts[static_cast<size_t>(keyvertexconns[j][k])] <= 1) {
+            // connect vital... just go on to the next one:
+            return Verdict::VITAL_CONNECTION;
+        }
+    }
+    //
+    bool presumedvital = false;
+    for (int cut : m_axsegcuts[j]) {
+        if (m_radialsegcounts[static_cast<size_t>(cut)] <= 1) {
+            presumedvital = true;
+            break;
+        }
+    }
+    if (presumedvital) {
+        presumedvital = checkVital(static_cast<int>(j), m_axsegcuts[j]);
+    }
+    if (!presumedvital) {
+        // don't let anything this is connected to go down to zero connections
+        for (auto affectedconnection : m_axialconns[j].connections) {
+            if (!m_removed[affectedconnection]) {
+                auto &connections = m_axialconns[affectedconnection].connections;
+                if (connections.size() <= 2) { // <- note number of connections includes
+                                               // itself... so you and one other
+                    presumedvital = true;
+                    break;
+                }
+            }
+        }
+    }
+    return presumedvital ? Verdict::VITAL : Verdict::REMOVE;
+}
+
 void AxialMinimiser::fewestLongest(std::map<int, std::set<int>> &axsegcuts,
                                    std::map<RadialKey, RadialSegment> &radialsegs,
                                    std::map<RadialKey, std::set<int>> &rlds,
                                    std::vector<RadialLine> &radialLines,
                                    std::vector<std::vector<int>> &keyvertexconns,
                                    std::vector<int> &keyvertexcounts) {
-    // m_axialconns = m_alllinemap->m_connectors;
-    int livecount = 0;
+    // normally continues from removeSubsets
+    if (m_lines.size() != axsegcuts.size() || m_segdivisors.size() != radialsegs.size()) {
+        flatten(axsegcuts, radialsegs, rlds, radialLines, keyvertexconns, keyvertexcounts.size());
+    }
+    size_t livecount = 0;
 
+    m_vps.resize(m_axialconns.size());
     for (size_t y = 0; y < m_axialconns.size(); y++) {
         if (!m_removed[y] && !m_vital[y]) {
             m_vps[livecount].index = static_cast<int>(y);
             m_vps[livecount].value1 = static_cast<int>(m_axialconns[y].connections.size());
-            m_vps[livecount].value2 = static_cast<float>(
-                genlib::getMapAtIndex(m_alllinemap->m_shapes, y)->second.getLine().length());
+            m_vps[livecount].value2 = static_cast<float>(m_lines[y].length());
             livecount++;
         }
     }
 
-    qsort(m_vps, static_cast<size_t>(livecount), sizeof(ValueTriplet), compareValueTriplet);
-
-    for (int i = 0; i < livecount; i++) {
-
-        int j = m_vps[i].index;
-        // vital connections code (uses original unaltered connections)
-        bool vitalconn = false;
-        size_t k;
-        for (k = 0; k < keyvertexconns[static_cast<size_t>(j)].size(); k++) {
-            // first check to see if removing this line will cause elimination of a
-            // vital connection
-            if (keyvertexcounts[static_cast<size_t>(keyvertexconns[static_cast<size_t>(j)][k])] <=
-                1) {
-                // connect vital... just go on to the next one:
-                vitalconn = true;
-                break;
-            }
-        }
-        if (vitalconn) {
-            continue;
-        }
-        //
-        bool presumedvital = false;
-        auto &axSegCut = genlib::getMapAtIndex(axsegcuts, static_cast<size_t>(j))->second;
-        for (int cut : axSegCut) {
-            if (m_radialsegcounts[cut] <= 1) {
-                presumedvital = true;
-                break;
-            }
-        }
-        if (presumedvital) {
-            presumedvital = checkVital(j, axSegCut, radialsegs, rlds, radialLines);
-        }
-        if (!presumedvital) {
-            // don't let anything this is connected to go down to zero connections
-            auto &affectedconnections = m_axialconns[static_cast<size_t>(j)].connections;
-            for (auto affectedconnection : affectedconnections) {
-                if (!m_removed[affectedconnection]) {
-                    auto &connections =
-                        m_axialconns[static_cast<size_t>(affectedconnection)].connections;
-                    if (connections.size() <= 2) { // <- note number of connections includes
-                                                   // itself... so you and one other
-                        presumedvital = true;
-                        break;
-                    }
-                }
-            }
+    std::sort(m_vps.begin(), m_vps.begin() + static_cast<std::ptrdiff_t>(livecount),
+              compareValueTriplet);
+
+    std::vector<Verdict> verdicts(CHECK_BATCH_SIZE);
+    for (size_t first = 0; first < livecount; first += CHECK_BATCH_SIZE) {
+        size_t last = std::min(livecount, first + CHECK_BATCH_SIZE);
+        m_batch++;
+        auto n = static_cast<int>(last - first);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+        for (int b = 0; b < n; b++) {
+            auto j = static_cast<size_t>(m_vps[first + static_cast<size_t>(b)].index);
+            verdicts[static_cast<size_t>(b)] = checkLongest(j, keyvertexconns, keyvertexcounts);
         }
-        if (!presumedvital) {
-            m_removed[j] = true;
-            auto &affectedconnections = m_axialconns[static_cast<size_t>(j)].connections;
-            for (auto affectedconnection : affectedconnections) {
-                if (!m_removed[affectedconnection]) {
-                    auto &connections =
-                        m_axialconns[static_cast<size_t>(affectedconnection)].connections;
-                    genlib::findAndErase(connections, static_cast<size_t>(j));
-                    m_affected[affectedconnection] = true;
-                }
-            }
-            for (auto cut : axSegCut) {
-                m_radialsegcounts[cut] -= 1;
-            }
-            // vital connections
-            for (size_t kvc = 0; kvc < keyvertexconns[static_cast<size_t>(j)].size(); kvc++) {
-                keyvertexcounts[static_cast<size_t>(keyvertexconns[static_cast<size_t>(j)][kvc])] -=
-                    1;
+
+        for (size_t i = first; i < last; i++) {
+            auto j = static_cast<size_t>(m_vps[i].index);
+            Verdict verdict = isStale(j) ? checkLongest(j, keyvertexconns, keyvertexcounts)
+                                         : verdicts[i - first];
+            if (verdict == Verdict::REMOVE) {
+                markStale(j, keyvertexconns);
+                removeLine(j, keyvertexconns, keyvertexcounts);
             }
         }
     }
@@ -282,75 +401,46 @@ void AxialMinimiser::fewestLongest(std::map<int, std::set<int>> &axsegcuts,
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 
-bool AxialMinimiser::checkVital(int checkindex, std::set<int> &axSegCut,
-                                std::map<RadialKey, RadialSegment> &radialsegs,
-                                std::map<RadialKey, std::set<int>> &rlds,
-                                std::vector<RadialLine> &radialLines) const {
-    const std::map<int, SalaShape> &axiallines = m_alllinemap->m_shapes;
-
-    bool presumedvital = true;
-    int nonvitalcount = 0, vitalsegs = 0;
+bool AxialMinimiser::checkVital(int checkindex, const std::vector<int> &axSegCut) const {
     // again, this time more rigourously... check any connected pairs don't cover
-    // the link...
+    // the link... every segment only cut by this line has to be
     for (int cut : axSegCut) {
-        if (m_radialsegcounts[cut] <= 1) {
-            bool nonvitalseg = false;
-            vitalsegs++;
-            auto radialSegIter = genlib::getMapAtIndex(radialsegs, static_cast<size_t>(cut));
-            const RadialKey &key = radialSegIter->first;
-            RadialSegment &seg = radialSegIter->second;
-            auto keyIter = rlds.find(key);
-            if (keyIter == rlds.end()) {
-                throw genlib::RuntimeException(
-                    "RadialKey A not found when checking for vital axial lines");
-            }
-            std::set<int> &divisorsa = keyIter->second;
-            auto radialBIter = rlds.find(seg.radialB);
-            if (radialBIter == rlds.end()) {
-                throw genlib::RuntimeException(
-                    "RadialKey B not found when checking for vital axial lines");
-            }
-            std::set<int> &divisorsb = radialBIter->second;
-            auto iterKey = std::find(radialLines.begin(), radialLines.end(), key);
-            if (iterKey == radialLines.end()) {
-                throw genlib::RuntimeException("Radial key not found in radial lines");
-            }
-            const RadialLine &rlinea = *iterKey;
-
-            auto iterSegB = std::find(radialLines.begin(), radialLines.end(), seg.radialB);
-            if (iterSegB == radialLines.end()) {
-                throw genlib::RuntimeException("Radial key not found in radial lines");
+        if (m_radialsegcounts[static_cast<size_t>(cut)] > 1) {
+            continue;
+        }
+        const SegmentDivisors &divisors = m_segdivisors[static_cast<size_t>(cut)];
+        const RadialLine &rlinea = *divisors.rlinea;
+        const RadialLine &rlineb = *divisors.rlineb;
+        bool nonvitalseg = false;
+        for (int diva : divisors.divisorsa) {
+            if (diva == checkindex || m_removed[static_cast<size_t>(diva)]) {
+                continue;
             }
-            const RadialLine &rlineb = *iterSegB;
-            for (int diva : divisorsa) {
-                if (diva == checkindex || m_removed[diva]) {
+            auto &connections = m_axialconns[static_cast<size_t>(diva)].connections;
+            for (int divb : divisors.divisorsb) {
+                if (divb == checkindex || m_removed[static_cast<size_t>(divb)]) {
                     continue;
                 }
-                for (int divb : divisorsb) {
-                    if (divb == checkindex || m_removed[divb]) {
-                        continue;
-                    }
-                    auto &connections = m_axialconns[static_cast<size_t>(diva)].connections;
-                    if (std::find(connections.begin(), connections.end(),
-                                  static_cast<size_t>(divb)) != connections.end()) {
-                        // as a further challenge, they must link within in the zone of
-                        // interest, not on the far side of it... arg!
-                        Point2f p = axiallines.at(diva).getLine().intersection_point(
-                            axiallines.at(divb).getLine(), TOLERANCE_A);
-                        if (p.insegment(rlinea.keyvertex, rlinea.openspace, rlineb.openspace,
-                                        TOLERANCE_A)) {
-                            nonvitalseg = true;
-                        }
+                if (std::binary_search(connections.begin(), connections.end(),
+                                       static_cast<size_t>(divb))) {
+                    // as a further challenge, they must link within in the zone of
+                    // interest, not on the far side of it... arg!
+                    Point2f p = m_lines[static_cast<size_t>(diva)].intersection_point(
+                        m_lines[static_cast<size_t>(divb)], TOLERANCE_A);
+                    if (p.insegment(rlinea.keyvertex, rlinea.openspace, rlineb.openspace,
+                                    TOLERANCE_A)) {
+                        nonvitalseg = true;
+                        break;
                     }
                 }
             }
             if (nonvitalseg) {
-                nonvitalcount++;
+                break;
             }
         }
+        if (!nonvitalseg) {
+            return true;
+        }
     }
-    if (nonvitalcount == vitalsegs) {
-        presumedvital = false;
-    }
-    return presumedvital;
+    return false;
 }
@@ -18,18 +18,58 @@ class AxialMinimiser {
   protected:
     const ShapeGraph *m_alllinemap;
     //
-    ValueTriplet *m_vps;
-    bool *m_removed;
-    bool *m_affected;
-    bool *m_vital;
-    int *m_radialsegcounts;
+    std::vector<ValueTriplet> m_vps;
+    std::vector<bool> m_removed;
+    std::vector<bool> m_affected;
+    std::vector<bool> m_vital;
+    std::vector<int> m_radialsegcounts;
     std::vector<Connector>
         m_axialconns; // <- uses a copy of axial lines as it will remove connections
+
+    // flat copies of the maps passed in, indexed by line and by radial segment, made once by
+    // removeSubsets so that the lines may be checked without looking anything up
+    struct SegmentDivisors {
+        std::vector<int> divisorsa, divisorsb;
+        const RadialLine *rlinea, *rlineb;
+        SegmentDivisors() : divisorsa(), divisorsb(), rlinea(nullptr), rlineb(nullptr) {}
+        SegmentDivisors(const SegmentDivisors &) = default;
+        SegmentDivisors &operator=(const SegmentDivisors &) = default;
+    };
+    std::vector<Line4f> m_lines;
+    std::vector<std::vector<int>> m_axsegcuts;
+    std::vector<SegmentDivisors> m_segdivisors;
+
+    // the lines whose checks may come out differently once a line is removed: the lines
+    // sharing a key vertex, cutting the same radial segments or cutting segments it divides
+    std::vector<std::vector<size_t>> m_keyvertexlines;
+    std::vector<std::vector<size_t>> m_segmentlines;
+    std::vector<std::vector<int>> m_dividedsegs;
+
+    // Lines are checked in parallel batches against the state at the start of the batch and
+    // then removed in order. Once a line is removed, any later line in the batch the removal
+    // may have affected is checked again
+    std::vector<size_t> m_stale;
+    size_t m_batch = 0;
+
+    enum class Verdict { SKIP, VITAL_CONNECTION, NOT_SUBSET, VITAL, REMOVE };
+
+    void flatten(std::map<int, std::set<int>> &axsegcuts,
+                 std::map<RadialKey, RadialSegment> &radialsegs,
+                 std::map<RadialKey, std::set<int>> &rlds, std::vector<RadialLine> &radialLines,
+                 std::vector<std::vector<int>> &keyvertexconns, size_t keyvertexcount);
+    Verdict checkSubset(size_t ii, const std::vector<std::vector<int>> &keyvertexconns,
+                        const std::vector<int> &keyvertexcounts) const;
+    Verdict checkLongest(size_t j, const std::vector<std::vector<int>> &keyvertexconns,
+                         const std::vector<int> &keyvertexcounts) const;
+    void removeLine(size_t removeindex, const std::vector<std::vector<int>> &keyvertexconns,
+                    std::vector<int> &keyvertexcounts);
+    void markStale(size_t removeindex, const std::vector<std::vector<int>> &keyvertexconns);
+    bool isStale(size_t index) const { return m_stale[index] == m_batch; }
+
   public:
     AxialMinimiser(const ShapeGraph &alllinemap, size_t noOfAxsegcuts, size_t noOfRadialsegs);
     AxialMinimiser(const AxialMinimiser &) = default;
-    AxialMinimiser &operator=(AxialMinimiser &) = default;
-    ~AxialMinimiser();
+    AxialMinimiser &operator=(const AxialMinimiser &) = default;
     void removeSubsets(std::map<int, std::set<int>> &axsegcuts,
                        std::map<RadialKey, RadialSegment> &radialsegs,
                        std::map<RadialKey, std::set<int>> &rlds,
@@ -43,10 +83,7 @@ class AxialMinimiser {
                        std::vector<std::vector<int>> &keyvertexconns,
                        std::vector<int> &keyvertexcounts);
     // advanced topological testing:
-    bool checkVital(int checkindex, std::set<int> &axSegCut,
-                    std::map<RadialKey, RadialSegment> &radialsegs,
-                    std::map<RadialKey, std::set<int>> &rlds,
-                    std::vector<RadialLine> &radialLines) const;
+    bool checkVital(int checkindex, const std::vector<int> &axSegCut) const;
     //
-    bool removed(int i) const { return m_removed[i]; }
+    bool removed(int i) const { return m_removed[static_cast<size_t>(i)]; }
 };
@@ -6,8 +6,14 @@
 
 #include "axialintegration.hpp"
 
+#include "../genlib/bitops.hpp"
+#include "../genlib/dependencysweep.hpp"
 #include "../genlib/pflipper.hpp"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 std::vector<std::string> AxialIntegration::getRequiredColumns(std::vector<int> radii,
                                                               std::string weightingColName,
                                                               bool simpleVersion) {
@@ -173,10 +179,76 @@ std::vector<int> AxialIntegration::getFormattedRadii(std::set<double> radiusSet)
     return radii;
 }
 
+void AxialIntegration::searchBitParallel(const std::vector<Connector> &connections,
+                                         size_t firstRoot, size_t rootCount, int maxDepth,
+                                         const std::vector<double> &weights,
+                                         BitParallelSearch &search) {
+    auto &visited = search.visited;
+    auto &frontier = search.frontier;
+    auto &next = search.next;
+    std::fill(visited.begin(), visited.end(), 0);
+    std::fill(frontier.begin(), frontier.end(), 0);
+    for (size_t j = 0; j < rootCount; j++) {
+        uint64_t rootBit = uint64_t(1) << j;
+        visited[firstRoot + j] |= rootBit;
+        frontier[firstRoot + j] |= rootBit;
+        search.histograms[j].counts.clear();
+        search.histograms[j].weights.clear();
+    }
+    for (int depth = 1; maxDepth == -1 || depth <= maxDepth; depth++) {
+        // the frontiers of all roots spread along the connections at once
+        std::fill(next.begin(), next.end(), 0);
+        for (size_t line = 0; line < connections.size(); line++) {
+            if (frontier[line] != 0) {
+                for (auto connection : connections[line].connections) {
+                    next[connection] |= frontier[line];
+                }
+            }
+        }
+        for (size_t j = 0; j < rootCount; j++) {
+            search.histograms[j].counts.push_back(0);
+            if (!weights.empty()) {
+                search.histograms[j].weights.push_back(0.0);
+            }
+        }
+        bool found = false;
+        for (size_t line = 0; line < connections.size(); line++) {
+            uint64_t discovered = next[line] & ~visited[line];
+            next[line] = discovered;
+            if (discovered == 0) {
+                continue;
+            }
+            found = true;
+            visited[line] |= discovered;
+            for (; discovered != 0; discovered &= discovered - 1) {
+                auto &histogram = search.histograms[genlib::lowestBitIndex(discovered)];
+                histogram.counts.back()++;
+                if (!weights.empty()) {
+                    histogram.weights.back() += weights[line];
+                }
+            }
+        }
+        if (!found) {
+            break;
+        }
+        std::swap(frontier, next);
+    }
+}
+
 AnalysisResult AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simpleVersion) {
     // note, from 10.0, Depthmap no longer includes *self* connections on axial lines
     // self connections are stripped out on loading graph files, as well as no longer made
 
+#if !defined(_OPENMP)
+    if (comm)
+        comm->logWarning("OpenMP NOT available, only running on a single core");
+    m_forceCommUpdatesMasterThread = false;
+#else
+    if (m_limitToThreads.has_value()) {
+        omp_set_num_threads(m_limitToThreads.value());
+    }
+#endif
+
     time_t atime = 0;
     if (comm) {
         qtimer(atime, 0);
@@ -275,258 +347,461 @@ AnalysisResult AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool s
         }
     }
 
-    // for choice
-    AnalysisInfo **audittrail = nullptr;
     auto nshapes = map.getShapeCount();
-    if (m_choice) {
-        audittrail = new AnalysisInfo *[nshapes];
-        for (size_t i = 0; i < nshapes; i++) {
-            audittrail[i] = new AnalysisInfo[radii.size()];
-        }
-    }
+    auto nradii = radii.size();
 
     // n.b., for this operation we assume continuous line referencing from zero (this is silly?)
     // has already failed due to this!  when intro hand drawn fewest line (where user may have
     // deleted) it's going to get worse...
 
-    bool *covered = new bool[nshapes];
-
-    size_t i = 0;
-    for (auto &iter : attributes) {
-        AttributeRow &row = iter.getRow();
-        for (size_t j = 0; j < nshapes; j++) {
-            covered[j] = false;
+    // for choice accumulated in one reverse sweep per root, the radius each node was discovered
+    // in is kept so that it contributes to that radius only (choice is summed across radii below)
+    bool sweepChoice = m_choice && m_choiceAccumulation != ChoiceAccumulation::BACKTRACK;
+    bool allPaths = m_choice && m_choiceAccumulation == ChoiceAccumulation::ALL_PATHS;
+
+    // the choice of every root is first gathered by the thread that searches from it and then
+    // added to the totals in root order, so the totals do not depend on the number of threads
+    std::vector<double> totalChoices(m_choice ? nshapes * nradii : 0, 0.0);
+    std::vector<double> totalWeightedChoices(m_choice ? nshapes * nradii : 0, 0.0);
+
+    // when following single paths the next line is picked at random. Without a seed the global
+    // random numbers are used as always, which requires the roots to be searched in order on a
+    // single thread
+    bool randomPick = m_choice && !allPaths;
+    bool parallel = !randomPick || m_choiceSeed.has_value();
+
+    // the attributes of a root for a radius, from the number of lines found at every depth
+    auto setRootValues = [&](std::vector<std::pair<size_t, float>> &rowValues, size_t r,
+                             int nodeCount, int totalDepth, double totalWeight,
+                             double wTotalDepth, const std::vector<int> &depthcounts, int depth) {
+        auto setValue = [&rowValues](size_t col, double value) {
+            rowValues.emplace_back(col, static_cast<float>(value));
+        };
+        setValue(countCol[r], nodeCount);
+        if (m_weightedMeasureCol.has_value()) {
+            setValue(totalWeightCol[r], totalWeight);
         }
-        if (m_choice) {
-            for (size_t k = 0; k < nshapes; k++) {
-                audittrail[k][0].previous.ref =
-                    -1; // note, 0th member used as radius doesn't matter
-                // note, choice columns are not cleared, but cummulative over all shortest path
-                // pairs
+        // node count > 1 to avoid divide by zero (was > 2)
+        if (nodeCount > 1) {
+            // note -- node_count includes this one -- mean depth as per p.108 Social Logic of Space
+            double meanDepth = static_cast<double>(totalDepth) / static_cast<double>(nodeCount - 1);
+            setValue(depthCol[r], meanDepth);
+            if (m_weightedMeasureCol.has_value()) {
+                // weighted mean depth:
+                setValue(wDepthCol[r], wTotalDepth / totalWeight);
             }
-        }
-
-        std::vector<int> depthcounts;
-        depthcounts.push_back(0);
+            // total nodes > 2 to avoid divide by 0 (was > 3)
+            if (nodeCount > 2 && meanDepth > 1.0) {
+                double ra = 2.0 * (meanDepth - 1.0) / static_cast<double>(nodeCount - 2);
+                // d-value / p-value from Depthmap 4 manual, note: node_count includes this one
+                double rraD = ra / pafmath::dvalue(nodeCount);
+                double rraP = ra / pafmath::dvalue(nodeCount);
+                double integTk = pafmath::teklinteg(nodeCount, totalDepth);
+                setValue(integDvCol[r], 1.0 / rraD);
 
-        pflipper<std::vector<std::pair<int, int>>> foundlist;
-        foundlist.a().push_back(std::pair<int, int>(static_cast<int>(i), -1));
-        covered[i] = true;
-        int totalDepth = 0, depth = 1, nodeCount = 1, pos = -1,
-            previous = -1; // node_count includes this 1
-        double weight = 0.0, rootweight = 0.0, totalWeight = 0.0, wTotalDepth = 0.0;
-        if (m_weightedMeasureCol.has_value()) {
-            rootweight = weights[i];
-            // include this line in total weights (as per nodecount)
-            totalWeight += rootweight;
-        }
-        int index = -1;
-        size_t r = 0;
-        for (int radius : radii) {
-            while (foundlist.a().size()) {
-                if (!m_choice) {
-                    index = foundlist.a().back().first;
-                } else {
-                    pos = static_cast<int>(pafmath::pafrand() % foundlist.a().size());
-                    index = foundlist.a().at(static_cast<size_t>(pos)).first;
-                    previous = foundlist.a().at(static_cast<size_t>(pos)).second;
-                    audittrail[index][0].previous.ref =
-                        previous; // note 0th member used here: can be used individually different
-                                  // radius previous
-                }
-                Connector &line = map.getConnections()[static_cast<size_t>(index)];
-                for (size_t k = 0; k < line.connections.size(); k++) {
-                    if (!covered[line.connections[k]]) {
-                        covered[line.connections[k]] = true;
-                        foundlist.b().push_back(
-                            std::make_pair(static_cast<int>(line.connections[k]), index));
-                        if (m_weightedMeasureCol.has_value()) {
-                            // the weight is taken from the discovered node:
-                            weight = weights[line.connections[k]];
-                            totalWeight += weight;
-                            wTotalDepth += depth * weight;
-                        }
-                        if (m_choice && previous != -1) {
-                            // both directional paths are now recorded for choice
-                            // (coincidentally fixes choice problem which was completely wrong)
-                            size_t here =
-                                static_cast<size_t>(index); // note: start counting from index as
-                                                            // actually looking ahead here
-                            while (here != i) { // not i means not the current root for the path
-                                audittrail[here][r].choice += 1;
-                                audittrail[here][r].weightedChoice += weight * rootweight;
-                                here = static_cast<size_t>(
-                                    audittrail[here][0]
-                                        .previous
-                                        .ref); // <- note, just using 0th position: radius for
-                                               // the previous doesn't matter in this analysis
-                            }
-                            if (m_weightedMeasureCol.has_value()) {
-                                // in weighted choice, root node and current node receive values:
-                                audittrail[i][r].weightedChoice += (weight * rootweight) * 0.5;
-                                audittrail[line.connections[k]][r].weightedChoice +=
-                                    (weight * rootweight) * 0.5;
-                            }
-                        }
-                        totalDepth += depth;
-                        nodeCount++;
-                        depthcounts.back() += 1;
+                if (!simpleVersion) {
+                    setValue(integPvCol[r], 1.0 / rraP);
+                    if (totalDepth - nodeCount + 1 > 1) {
+                        setValue(integTkCol[r], integTk);
+                    } else {
+                        setValue(integTkCol[r], -1.0);
                     }
                 }
-                if (!m_choice)
-                    foundlist.a().pop_back();
-                else
-                    foundlist.a().erase(foundlist.a().begin() + pos);
-                if (!foundlist.a().size()) {
-                    foundlist.flip();
-                    depth++;
-                    depthcounts.push_back(0);
-                    if (radius != -1 && depth > radius) {
-                        break;
+
+                if (m_fulloutput) {
+                    setValue(raCol[r], ra);
+
+                    if (!simpleVersion) {
+                        setValue(rraCol[r], rraD);
+                    }
+                    setValue(tdCol[r], totalDepth);
+
+                    if (!simpleVersion) {
+                        // alan's palm-tree normalisation: palmtree
+                        double dmin = nodeCount - 1;
+                        double dmax = pafmath::palmtree(nodeCount, depth - 1);
+                        if (dmax != dmin) {
+                            setValue(pennNormCol[r], (dmax - totalDepth) / (dmax - dmin));
+                        }
                     }
                 }
-            }
-            // set the attributes for this node:
-            row.setValue(countCol[r], static_cast<float>(nodeCount));
-            if (m_weightedMeasureCol.has_value()) {
-                row.setValue(totalWeightCol[r], static_cast<float>(totalWeight));
-            }
-            // node count > 1 to avoid divide by zero (was > 2)
-            if (nodeCount > 1) {
-                // note -- node_count includes this one -- mean depth as per p.108 Social Logic of
-                // Space
-                double meanDepth =
-                    static_cast<double>(totalDepth) / static_cast<double>(nodeCount - 1);
-                row.setValue(depthCol[r], static_cast<float>(meanDepth));
-                if (m_weightedMeasureCol.has_value()) {
-                    // weighted mean depth:
-                    row.setValue(wDepthCol[r], static_cast<float>(wTotalDepth / totalWeight));
+            } else {
+                setValue(integDvCol[r], -1.0);
+
+                if (!simpleVersion) {
+                    setValue(integPvCol[r], -1.0);
+                    setValue(integTkCol[r], -1.0);
                 }
-                // total nodes > 2 to avoid divide by 0 (was > 3)
-                if (nodeCount > 2 && meanDepth > 1.0) {
-                    double ra = 2.0 * (meanDepth - 1.0) / static_cast<double>(nodeCount - 2);
-                    // d-value / p-value from Depthmap 4 manual, note: node_count includes this one
-                    double rraD = ra / pafmath::dvalue(nodeCount);
-                    double rraP = ra / pafmath::dvalue(nodeCount);
-                    double integTk = pafmath::teklinteg(nodeCount, totalDepth);
-                    row.setValue(integDvCol[r], static_cast<float>(1.0 / rraD));
+                if (m_fulloutput) {
+                    setValue(raCol[r], -1.0);
 
                     if (!simpleVersion) {
-                        row.setValue(integPvCol[r], static_cast<float>(1.0 / rraP));
-                        if (totalDepth - nodeCount + 1 > 1) {
-                            row.setValue(integTkCol[r], static_cast<float>(integTk));
-                        } else {
-                            row.setValue(integTkCol[r], -1.0f);
-                        }
+                        setValue(rraCol[r], -1.0);
+                    }
+
+                    setValue(tdCol[r], -1.0);
+
+                    if (!simpleVersion) {
+                        setValue(pennNormCol[r], -1.0);
                     }
+                }
+            }
 
-                    if (m_fulloutput) {
-                        row.setValue(raCol[r], static_cast<float>(ra));
+            if (!simpleVersion) {
+                double entropy = 0.0, intensity = 0.0, relEntropy = 0.0, factorial = 1.0,
+                       harmonic = 0.0;
+                for (size_t k = 0; k < depthcounts.size(); k++) {
+                    if (depthcounts[k] != 0) {
+                        // some debate over whether or not this should be node count - 1
+                        // (i.e., including or not including the node itself)
+                        double prob =
+                            static_cast<double>(depthcounts[k]) / static_cast<double>(nodeCount);
+                        entropy -= prob * pafmath::log2(prob);
+                        // Formula from Turner 2001, "Depthmap"
+                        factorial *= static_cast<double>(k + 1);
+                        double q = (pow(meanDepth, static_cast<double>(k)) /
+                                    static_cast<double>(factorial)) *
+                                   exp(-meanDepth);
+                        relEntropy += static_cast<double>(prob) * pafmath::log2(prob / q);
+                        //
+                        harmonic += 1.0 / static_cast<double>(depthcounts[k]);
+                    }
+                }
+                harmonic = static_cast<double>(depthcounts.size()) / harmonic;
+                if (totalDepth > nodeCount) {
+                    intensity = nodeCount * entropy / (totalDepth - nodeCount);
+                } else {
+                    intensity = -1;
+                }
+                setValue(entropyCol[r], entropy);
+                setValue(relEntropyCol[r], relEntropy);
+                setValue(intensityCol[r], intensity);
+                setValue(harmonicCol[r], harmonic);
+            }
+        } else {
+            setValue(depthCol[r], -1.0);
+            setValue(integDvCol[r], -1.0);
 
-                        if (!simpleVersion) {
-                            row.setValue(rraCol[r], static_cast<float>(rraD));
+            if (!simpleVersion) {
+                setValue(integPvCol[r], -1.0);
+                setValue(integTkCol[r], -1.0);
+                setValue(entropyCol[r], -1.0);
+                setValue(relEntropyCol[r], -1.0);
+                setValue(harmonicCol[r], -1.0);
+            }
+        }
+    };
+
+    size_t count = 0;
+
+    if (!m_choice) {
+        // without choice no paths have to be kept, so the searches from 64 roots are run at once,
+        // only counting the lines found at every depth
+        int maxDepth = radii.back();
+        auto nbatches = static_cast<int>((nshapes + 63) / 64);
+
+#if defined(_OPENMP)
+#pragma omp parallel default(shared)
+#endif
+        {
+            BitParallelSearch search(nshapes);
+            std::vector<std::vector<std::pair<size_t, float>>> batchValues(64);
+            std::vector<int> depthcounts;
+
+#if defined(_OPENMP)
+#pragma omp for ordered schedule(dynamic)
+#endif
+            for (int b = 0; b < nbatches; b++) {
+                size_t firstRoot = static_cast<size_t>(b) * 64;
+                size_t rootCount = std::min<size_t>(64, nshapes - firstRoot);
+                searchBitParallel(map.getConnections(), firstRoot, rootCount, maxDepth, weights,
+                                  search);
+                for (size_t j = 0; j < rootCount; j++) {
+                    auto &histogram = search.histograms[j];
+                    batchValues[j].clear();
+                    size_t lastDepth = histogram.counts.size();
+                    while (lastDepth > 0 && histogram.counts[lastDepth - 1] == 0) {
+                        lastDepth--;
+                    }
+                    for (size_t r = 0; r < nradii; r++) {
+                        // as a search from a single root, the depths counted go one past the
+                        // radius, or two past the last lines found
+                        size_t levels = lastDepth + 2;
+                        size_t radiusLevels = histogram.counts.size();
+                        if (radii[r] != -1) {
+                            levels = std::min(levels, static_cast<size_t>(radii[r]) + 1);
+                            radiusLevels = std::min(radiusLevels, static_cast<size_t>(radii[r]));
+                        }
+                        depthcounts.assign(levels, 0);
+                        int nodeCount = 1, totalDepth = 0;
+                        double totalWeight = 0.0, wTotalDepth = 0.0;
+                        if (m_weightedMeasureCol.has_value()) {
+                            totalWeight = weights[firstRoot + j];
                         }
-                        row.setValue(tdCol[r], static_cast<float>(totalDepth));
-
-                        if (!simpleVersion) {
-                            // alan's palm-tree normalisation: palmtree
-                            double dmin = nodeCount - 1;
-                            double dmax = pafmath::palmtree(nodeCount, depth - 1);
-                            if (dmax != dmin) {
-                                row.setValue(
-                                    pennNormCol[r],
-                                    static_cast<float>((dmax - totalDepth) / (dmax - dmin)));
+                        for (size_t k = 0; k < radiusLevels; k++) {
+                            auto depth = static_cast<int>(k + 1);
+                            depthcounts[k] = histogram.counts[k];
+                            nodeCount += histogram.counts[k];
+                            totalDepth += depth * histogram.counts[k];
+                            if (m_weightedMeasureCol.has_value()) {
+                                totalWeight += histogram.weights[k];
+                                wTotalDepth += depth * histogram.weights[k];
                             }
                         }
+                        setRootValues(batchValues[j], r, nodeCount, totalDepth, totalWeight,
+                                      wTotalDepth, depthcounts, static_cast<int>(levels));
                     }
-                } else {
-                    row.setValue(integDvCol[r], -1.0f);
+                }
 
-                    if (!simpleVersion) {
-                        row.setValue(integPvCol[r], -1.0f);
-                        row.setValue(integTkCol[r], -1.0f);
+#if defined(_OPENMP)
+#pragma omp ordered
+#endif
+                {
+                    for (size_t j = 0; j < rootCount; j++) {
+                        AttributeRow &row = map.getAttributeRowFromShapeIndex(firstRoot + j);
+                        for (auto &[col, value] : batchValues[j]) {
+                            row.setValue(col, value);
+                        }
                     }
-                    if (m_fulloutput) {
-                        row.setValue(raCol[r], -1.0f);
+                    count += rootCount;
+                }
 
-                        if (!simpleVersion) {
-                            row.setValue(rraCol[r], -1.0f);
+#if defined(_OPENMP)
+                // only executed by the main thread if requested
+                if (!m_forceCommUpdatesMasterThread || omp_get_thread_num() == 0)
+#endif
+                    if (comm) {
+                        if (qtimer(atime, 500)) {
+                            if (comm->IsCancelled()) {
+                                throw Communicator::CancelledException();
+                            }
+                            comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                         }
+                    }
+            }
+        }
 
-                        row.setValue(tdCol[r], -1.0f);
+        result.completed = true;
 
-                        if (!simpleVersion) {
-                            row.setValue(pennNormCol[r], -1.0f);
+        return result;
+    }
+
+    auto n = static_cast<int>(nshapes);
+
+#if defined(_OPENMP)
+#pragma omp parallel default(shared) if (parallel)
+#endif
+    {
+        std::vector<bool> covered(nshapes, false);
+        // for choice
+        std::vector<AnalysisInfo> audittrail(m_choice ? nshapes * nradii : 0);
+        genlib::DependencySweep sweep(sweepChoice ? nshapes : 0);
+        std::vector<size_t> discoveryRadius(sweepChoice ? nshapes : 0);
+        std::vector<int> discoveryDepth(allPaths ? nshapes : 0);
+        // the lines found from the current root, and the attributes of the root
+        std::vector<size_t> reached;
+        std::vector<std::pair<size_t, float>> rowValues;
+
+#if defined(_OPENMP)
+#pragma omp for ordered schedule(dynamic)
+#endif
+        for (int ii = 0; ii < n; ii++) {
+            auto i = static_cast<size_t>(ii);
+            // note, 0th member used as radius doesn't matter for the previous line
+            auto trail = [&audittrail, nradii](size_t line, size_t r) -> AnalysisInfo & {
+                return audittrail[line * nradii + r];
+            };
+            uint64_t randomStream = m_choiceSeed.has_value()
+                                        ? pafmath::counterrand(*m_choiceSeed, i)
+                                        : 0;
+            uint64_t randomDraws = 0;
+            rowValues.clear();
+
+            std::vector<int> depthcounts;
+            depthcounts.push_back(0);
+
+            pflipper<std::vector<std::pair<int, int>>> foundlist;
+            foundlist.a().push_back(std::pair<int, int>(static_cast<int>(i), -1));
+            covered[i] = true;
+            reached.push_back(i);
+            if (sweepChoice) {
+                sweep.reset();
+                sweep.settleRoot(i);
+            }
+            int totalDepth = 0, depth = 1, nodeCount = 1, pos = -1,
+                previous = -1; // node_count includes this 1
+            double weight = 0.0, rootweight = 0.0, totalWeight = 0.0, wTotalDepth = 0.0;
+            if (m_weightedMeasureCol.has_value()) {
+                rootweight = weights[i];
+                // include this line in total weights (as per nodecount)
+                totalWeight += rootweight;
+            }
+            int index = -1;
+            size_t r = 0;
+            for (int radius : radii) {
+                while (foundlist.a().size()) {
+                    if (!randomPick) {
+                        // all equally short paths are counted, so the order does not matter
+                        index = foundlist.a().back().first;
+                        previous = foundlist.a().back().second;
+                    } else {
+                        uint64_t random =
+                            m_choiceSeed.has_value()
+                                ? pafmath::counterrand(randomStream, randomDraws++)
+                                : static_cast<uint64_t>(pafmath::pafrand());
+                        pos = static_cast<int>(random % foundlist.a().size());
+                        index = foundlist.a().at(static_cast<size_t>(pos)).first;
+                        previous = foundlist.a().at(static_cast<size_t>(pos)).second;
+                        trail(static_cast<size_t>(index), 0).previous.ref =
+                            previous; // note 0th member used here: can be used individually
+                                      // different radius previous
+                    }
+                    Connector &line = map.getConnections()[static_cast<size_t>(index)];
+                    for (size_t k = 0; k < line.connections.size(); k++) {
+                        if (!covered[line.connections[k]]) {
+                            covered[line.connections[k]] = true;
+                            reached.push_back(line.connections[k]);
+                            foundlist.b().push_back(
+                                std::make_pair(static_cast<int>(line.connections[k]), index));
+                            if (m_weightedMeasureCol.has_value()) {
+                                // the weight is taken from the discovered node:
+                                weight = weights[line.connections[k]];
+                                totalWeight += weight;
+                                wTotalDepth += depth * weight;
+                            }
+                            if (m_choice && previous != -1 && !sweepChoice) {
+                                // both directional paths are now recorded for choice
+                                // (coincidentally fixes choice problem which was completely
+                                // wrong)
+                                size_t here =
+                                    static_cast<size_t>(index); // note: start counting from index
+                                                                // as actually looking ahead here
+                                while (here !=
+                                       i) { // not i means not the current root for the path
+                                    trail(here, r).choice += 1;
+                                    trail(here, r).weightedChoice += weight * rootweight;
+                                    here = static_cast<size_t>(
+                                        trail(here, 0)
+                                            .previous
+                                            .ref); // <- note, just using 0th position: radius for
+                                                   // the previous doesn't matter in this analysis
+                                }
+                            }
+                            if (m_choice && previous != -1) {
+                                if (m_weightedMeasureCol.has_value()) {
+                                    // in weighted choice, root node and current node receive
+                                    // values:
+                                    trail(i, r).weightedChoice += (weight * rootweight) * 0.5;
+                                    trail(line.connections[k], r).weightedChoice +=
+                                        (weight * rootweight) * 0.5;
+                                }
+                            }
+                            if (sweepChoice) {
+                                sweep.settle(line.connections[k], static_cast<size_t>(index));
+                                discoveryRadius[line.connections[k]] = r;
+                                if (allPaths) {
+                                    discoveryDepth[line.connections[k]] = depth;
+                                }
+                            }
+                            totalDepth += depth;
+                            nodeCount++;
+                            depthcounts.back() += 1;
+                        } else if (allPaths && discoveryDepth[line.connections[k]] == depth &&
+                                   line.connections[k] != i) {
+                            // another shortest path to a node discovered at this depth
+                            sweep.addPredecessor(line.connections[k], static_cast<size_t>(index));
                         }
                     }
-                }
-
-                if (!simpleVersion) {
-                    double entropy = 0.0, intensity = 0.0, relEntropy = 0.0, factorial = 1.0,
-                           harmonic = 0.0;
-                    for (size_t k = 0; k < depthcounts.size(); k++) {
-                        if (depthcounts[k] != 0) {
-                            // some debate over whether or not this should be node count - 1
-                            // (i.e., including or not including the node itself)
-                            double prob = static_cast<double>(depthcounts[k]) /
-                                          static_cast<double>(nodeCount);
-                            entropy -= prob * pafmath::log2(prob);
-                            // Formula from Turner 2001, "Depthmap"
-                            factorial *= static_cast<double>(k + 1);
-                            double q = (pow(meanDepth, static_cast<double>(k)) /
-                                        static_cast<double>(factorial)) *
-                                       exp(-meanDepth);
-                            relEntropy += static_cast<double>(prob) * pafmath::log2(prob / q);
-                            //
-                            harmonic += 1.0 / static_cast<double>(depthcounts[k]);
+                    if (!randomPick)
+                        foundlist.a().pop_back();
+                    else
+                        foundlist.a().erase(foundlist.a().begin() + pos);
+                    if (!foundlist.a().size()) {
+                        foundlist.flip();
+                        depth++;
+                        depthcounts.push_back(0);
+                        if (radius != -1 && depth > radius) {
+                            break;
                         }
                     }
-                    harmonic = static_cast<double>(depthcounts.size()) / harmonic;
-                    if (totalDepth > nodeCount) {
-                        intensity = nodeCount * entropy / (totalDepth - nodeCount);
-                    } else {
-                        intensity = -1;
+                }
+                // set the attributes for this node:
+                setRootValues(rowValues, r, nodeCount, totalDepth, totalWeight, wTotalDepth,
+                              depthcounts, depth);
+                ++r;
+            }
+            if (sweepChoice) {
+                // push the targets of all paths from this root back towards it at once
+                for (size_t rd = 0; rd < nradii; rd++) {
+                    sweep.accumulate(
+                        [&](size_t node) { return discoveryRadius[node] == rd ? 1.0 : 0.0; },
+                        [&](size_t node, double dependency) {
+                            if (node != i) {
+                                trail(node, rd).choice += dependency;
+                            }
+                        });
+                    if (m_weightedMeasureCol.has_value()) {
+                        sweep.accumulate(
+                            [&](size_t node) {
+                                return discoveryRadius[node] == rd ? weights[node] * rootweight
+                                                                   : 0.0;
+                            },
+                            [&](size_t node, double dependency) {
+                                if (node != i) {
+                                    trail(node, rd).weightedChoice += dependency;
+                                }
+                            });
                     }
-                    row.setValue(entropyCol[r], static_cast<float>(entropy));
-                    row.setValue(relEntropyCol[r], static_cast<float>(relEntropy));
-                    row.setValue(intensityCol[r], static_cast<float>(intensity));
-                    row.setValue(harmonicCol[r], static_cast<float>(harmonic));
                 }
-            } else {
-                row.setValue(depthCol[r], -1.0f);
-                row.setValue(integDvCol[r], -1.0f);
+            }
 
-                if (!simpleVersion) {
-                    row.setValue(integPvCol[r], -1.0f);
-                    row.setValue(integTkCol[r], -1.0f);
-                    row.setValue(entropyCol[r], -1.0f);
-                    row.setValue(relEntropyCol[r], -1.0f);
-                    row.setValue(harmonicCol[r], -1.0f);
+#if defined(_OPENMP)
+#pragma omp ordered
+#endif
+            {
+                AttributeRow &row = map.getAttributeRowFromShapeIndex(i);
+                for (auto &[col, value] : rowValues) {
+                    row.setValue(col, value);
                 }
-            }
-            ++r;
-        }
-        //
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    delete[] covered;
-                    throw Communicator::CancelledException();
+                for (auto line : reached) {
+                    covered[line] = false;
+                    if (m_choice) {
+                        for (size_t rd = 0; rd < nradii; rd++) {
+                            auto &adt = trail(line, rd);
+                            totalChoices[line * nradii + rd] += adt.choice;
+                            totalWeightedChoices[line * nradii + rd] += adt.weightedChoice;
+                            adt.choice = 0.0;
+                            adt.weightedChoice = 0.0;
+                        }
+                        trail(line, 0).previous.ref = -1;
+                    }
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
+                reached.clear();
+                count++;
             }
+
+#if defined(_OPENMP)
+            // only executed by the main thread if requested
+            if (!m_forceCommUpdatesMasterThread || omp_get_thread_num() == 0)
+#endif
+                if (comm) {
+                    if (qtimer(atime, 500)) {
+                        if (comm->IsCancelled()) {
+                            throw Communicator::CancelledException();
+                        }
+                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
+                    }
+                }
         }
-        i++;
     }
-    delete[] covered;
     if (m_choice) {
-        i = 0;
+        size_t i = 0;
         for (auto &iter : attributes) {
             AttributeRow &row = iter.getRow();
             double totalChoice = 0.0, wTotalChoice = 0.0;
-            for (size_t r = 0; r < radii.size(); r++) {
-                totalChoice += audittrail[i][r].choice;
-                wTotalChoice += audittrail[i][r].weightedChoice;
+            for (size_t r = 0; r < nradii; r++) {
+                totalChoice += totalChoices[i * nradii + r];
+                wTotalChoice += totalWeightedChoices[i * nradii + r];
                 // n.b., normalise choice according to (n-1)(n-2)/2 (maximum possible through
                 // routes)
                 double nodeCount = row.getValue(countCol[r]);
@@ -563,12 +838,6 @@ AnalysisResult AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool s
                 break;
             }
         }
-        for (size_t j = 0; j < nshapes; j++) {
-            // TODO: At this moment, GCC triggers a warning here. Find
-            // a better solution rather than disabling the warnind
-            delete[] audittrail[j];
-        }
-        delete[] audittrail;
     }
 
     result.completed = true;
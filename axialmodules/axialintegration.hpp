@@ -6,18 +6,21 @@
 
 #pragma once
 
+#include "../choiceaccumulation.hpp"
 #include "../genlib/stringutils.hpp"
 #include "../iaxial.hpp"
 
 class AxialIntegration : IAxial {
     std::set<double> m_radiusSet;
     std::optional<size_t> m_weightedMeasureCol;
+    std::optional<uint64_t> m_choiceSeed = std::nullopt;
+    std::optional<int> m_limitToThreads;
     bool m_choice;
     bool m_fulloutput;
     bool m_forceLegacyColumnOrder = false;
+    bool m_forceCommUpdatesMasterThread = false;
 
-    [[maybe_unused]] unsigned _padding0 : 1 * 8;
-    [[maybe_unused]] unsigned _padding1 : 4 * 8;
+    ChoiceAccumulation m_choiceAccumulation = ChoiceAccumulation::BACKTRACK;
 
     // used during angular analysis
     struct AnalysisInfo {
@@ -106,20 +109,46 @@ class AxialIntegration : IAxial {
     }
 
   private:
+    // the number of lines found at every depth from a root, and their total weight
+    struct DepthHistogram {
+        std::vector<int> counts;
+        std::vector<double> weights;
+        DepthHistogram() : counts(), weights() {}
+    };
+    // buffers of the searches from up to 64 roots at once, one bit per root in every word
+    struct BitParallelSearch {
+        std::vector<uint64_t> visited, frontier, next;
+        std::vector<DepthHistogram> histograms;
+        BitParallelSearch(size_t lineCount)
+            : visited(lineCount), frontier(lineCount), next(lineCount), histograms(64) {}
+    };
+    static void searchBitParallel(const std::vector<Connector> &connections, size_t firstRoot,
+                                  size_t rootCount, int maxDepth,
+                                  const std::vector<double> &weights, BitParallelSearch &search);
+
     static std::vector<int> getFormattedRadii(std::set<double> radiusSet);
     std::vector<std::string> getRequiredColumns(std::vector<int> radii,
                                                 std::string weightingColName, bool simpleVersion);
 
   public:
     AxialIntegration(std::set<double> radiusSet, int weightedMeasureCol, bool choice,
-                     bool fulloutput)
+                     bool fulloutput, std::optional<int> limitToThreads = std::nullopt,
+                     bool forceCommUpdatesMasterThread = false)
         : m_radiusSet(std::move(radiusSet)),
           m_weightedMeasureCol(weightedMeasureCol < 0 ? std::nullopt
                                                       : std::make_optional(weightedMeasureCol)),
-          m_choice(choice), m_fulloutput(fulloutput), _padding0(0), _padding1(0) {}
+          m_limitToThreads(limitToThreads), m_choice(choice), m_fulloutput(fulloutput),
+          m_forceCommUpdatesMasterThread(forceCommUpdatesMasterThread) {}
     std::string getAnalysisName() const override { return "Angular Analysis"; }
     void setForceLegacyColumnOrder(bool forceLegacyColumnOrder) {
         m_forceLegacyColumnOrder = forceLegacyColumnOrder;
     }
+    void setChoiceAccumulation(ChoiceAccumulation choiceAccumulation) {
+        m_choiceAccumulation = choiceAccumulation;
+    }
+    // Pick the next line of a choice search from a random stream of its own for every root
+    // instead of the global random numbers, so that choice can be calculated in parallel and
+    // gives the same results for a seed on any number of threads
+    void setChoiceSeed(uint64_t choiceSeed) { m_choiceSeed = choiceSeed; }
     AnalysisResult run(Communicator *, ShapeGraph &map, bool) override;
 };
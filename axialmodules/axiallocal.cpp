@@ -6,6 +6,10 @@
 
 #include "axiallocal.hpp"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 AnalysisResult AxialLocal::run(Communicator *comm, ShapeGraph &map, bool) {
     time_t atime = 0;
     if (comm) {
@@ -29,50 +33,79 @@ AnalysisResult AxialLocal::run(Communicator *comm, ShapeGraph &map, bool) {
     // has already failed due to this!  when intro hand drawn fewest line (where user may have
     // deleted) it's going to get worse...
 
-    size_t i = 0;
-    for (auto &iter : attributes) {
-        AttributeRow &row = iter.getRow();
-
-        double control = 0.0;
-        const auto &connections = map.getConnections()[i].connections;
-        std::vector<size_t> totalneighbourhood;
-        for (auto connection : connections) {
-            // n.b., as of Depthmap 10.0, connections[j] and i cannot coexist
-            // if (connections[j] != i) {
-            genlib::addIfNotExists(totalneighbourhood, connection);
-            int retroSize = 0;
-            auto &retconnectors = map.getConnections()[connection].connections;
-            for (auto retconnector : retconnectors) {
-                retroSize++;
-                genlib::addIfNotExists(totalneighbourhood, retconnector);
+    const auto &connectors = map.getConnections();
+    size_t nshapes = connectors.size();
+    std::vector<float> controlValues(nshapes, -1.0f);
+    std::vector<float> controllabilityValues(nshapes, -1.0f);
+    size_t count = 0;
+    auto n = static_cast<int>(nshapes);
+
+#if defined(_OPENMP)
+#pragma omp parallel default(shared)
+#endif
+    {
+        // the lines in the neighbourhood of line i are marked with i + 1, so the marks do not
+        // have to be cleared between lines
+        std::vector<size_t> neighbourhoodMarks(nshapes, 0);
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int ii = 0; ii < n; ii++) {
+            auto i = static_cast<size_t>(ii);
+            double control = 0.0;
+            const auto &connections = connectors[i].connections;
+            size_t totalneighbourhood = 0;
+            auto addToNeighbourhood = [&](size_t line) {
+                if (neighbourhoodMarks[line] != i + 1) {
+                    neighbourhoodMarks[line] = i + 1;
+                    totalneighbourhood++;
+                }
+            };
+            for (auto connection : connections) {
+                // n.b., as of Depthmap 10.0, connections[j] and i cannot coexist
+                // if (connections[j] != i) {
+                addToNeighbourhood(connection);
+                auto &retconnectors = connectors[connection].connections;
+                for (auto retconnector : retconnectors) {
+                    addToNeighbourhood(retconnector);
+                }
+                if (retconnectors.size() > 0) {
+                    control += 1.0 / static_cast<double>(retconnectors.size());
+                }
+                //}
             }
-            if (retroSize > 0) {
-                control += 1.0 / static_cast<double>(retroSize);
+
+            if (connections.size() > 0) {
+                controlValues[i] = static_cast<float>(control);
+                controllabilityValues[i] =
+                    static_cast<float>(static_cast<double>(connections.size()) /
+                                       static_cast<double>(totalneighbourhood - 1));
             }
-            //}
-        }
 
-        if (connections.size() > 0) {
-            row.setValue(controlCol, static_cast<float>(control));
-            row.setValue(controllabilityCol,
-                         static_cast<float>(static_cast<double>(connections.size()) /
-                                            static_cast<double>(totalneighbourhood.size() - 1)));
-        } else {
-            row.setValue(controlCol, -1);
-            row.setValue(controllabilityCol, -1);
-        }
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+            count++; // <- increment count
 
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
+#if defined(_OPENMP)
+            // comm updates only from the main thread
+            if (omp_get_thread_num() == 0)
+#endif
+                if (comm) {
+                    if (qtimer(atime, 500)) {
+                        if (comm->IsCancelled()) {
+                            throw Communicator::CancelledException();
+                        }
+                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
+                    }
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
-            }
         }
-        i++;
     }
 
+    attributes.setColumnValues(controlCol, std::move(controlValues));
+    attributes.setColumnValues(controllabilityCol, std::move(controllabilityValues));
+
     result.completed = true;
 
     return result;
@@ -8,35 +8,26 @@
 
 #include "../genlib/pflipper.hpp"
 
-AnalysisResult AxialStepDepth::run(Communicator *, ShapeGraph &map, bool) {
-
-    AttributeTable &attributes = map.getAttributeTable();
+std::vector<float> AxialStepDepth::traverse(const ShapeGraph &map,
+                                            const std::set<int> &originRefs) const {
 
-    AnalysisResult result;
-
-    auto stepdepthCol = attributes.insertOrResetColumn(Column::STEP_DEPTH);
-    result.addAttribute(Column::STEP_DEPTH);
+    std::vector<float> stepDepths(map.getShapeCount(), -1.0f);
 
-    bool *covered = new bool[map.getConnections().size()];
-    for (size_t i = 0; i < map.getConnections().size(); i++) {
-        covered[i] = false;
-    }
+    std::vector<bool> covered(map.getConnections().size(), false);
     pflipper<std::vector<size_t>> foundlist;
-    for (auto &lineindex : m_originRefs) {
+    for (auto &lineindex : originRefs) {
         foundlist.a().push_back(static_cast<size_t>(lineindex));
-        covered[lineindex] = true;
-        map.getAttributeRowFromShapeIndex(static_cast<size_t>(lineindex))
-            .setValue(stepdepthCol, 0.0f);
+        covered[static_cast<size_t>(lineindex)] = true;
+        stepDepths[static_cast<size_t>(lineindex)] = 0.0f;
     }
     int depth = 1;
     while (foundlist.a().size()) {
-        Connector &line = map.getConnections()[foundlist.a().back()];
+        const Connector &line = map.getConnections()[foundlist.a().back()];
         for (size_t k = 0; k < line.connections.size(); k++) {
             if (!covered[line.connections[k]]) {
                 covered[line.connections[k]] = true;
                 foundlist.b().push_back(line.connections[k]);
-                map.getAttributeRowFromShapeIndex(line.connections[k])
-                    .setValue(stepdepthCol, static_cast<float>(depth));
+                stepDepths[line.connections[k]] = static_cast<float>(depth);
             }
         }
         foundlist.a().pop_back();
@@ -45,7 +36,44 @@ AnalysisResult AxialStepDepth::run(Communicator *, ShapeGraph &map, bool) {
             depth++;
         }
     }
-    delete[] covered;
+
+    return stepDepths;
+}
+
+AnalysisResult AxialStepDepth::run(Communicator *, ShapeGraph &map, bool) {
+
+    AttributeTable &attributes = map.getAttributeTable();
+
+    AnalysisResult result;
+
+    std::vector<const std::set<int> *> originSets;
+    std::vector<size_t> stepdepthCols;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        std::string stepdepthColText = getOriginSetColumn(Column::STEP_DEPTH, originSetName);
+        stepdepthCols.push_back(attributes.insertOrResetColumn(stepdepthColText));
+        result.addAttribute(stepdepthColText);
+        originSets.push_back(&originRefs);
+    }
+
+    std::vector<std::vector<float>> stepDepths(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        stepDepths[static_cast<size_t>(i)] = traverse(map, *originSets[static_cast<size_t>(i)]);
+    }
+
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        for (size_t i = 0; i < originSets.size(); i++) {
+            if (stepDepths[i][cursor] >= 0) {
+                row.setValue(stepdepthCols[i], stepDepths[i][cursor]);
+            }
+        }
+    }
 
     result.completed = true;
 
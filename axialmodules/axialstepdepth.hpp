@@ -10,7 +10,10 @@
 
 class AxialStepDepth : IAxial {
 
-    std::set<int> m_originRefs;
+    // named sets of origins, each given its own step depth column
+    std::map<std::string, std::set<int>> m_originSets;
+
+    std::vector<float> traverse(const ShapeGraph &map, const std::set<int> &originRefs) const;
 
   public:
     struct Column {
@@ -19,7 +22,10 @@ class AxialStepDepth : IAxial {
     };
 
   public:
-    AxialStepDepth(std::set<int> originRefs) : m_originRefs(std::move(originRefs)) {}
+    AxialStepDepth(std::set<int> originRefs) : m_originSets({{"", std::move(originRefs)}}) {}
+    // one search per set, run in parallel, sharing the reading of the map
+    AxialStepDepth(std::map<std::string, std::set<int>> originSets)
+        : m_originSets(std::move(originSets)) {}
     std::string getAnalysisName() const override { return "Angular Analysis"; }
     AnalysisResult run(Communicator *comm, ShapeGraph &map, bool simpleVersion) override;
 };
@@ -10,13 +10,20 @@
 
 #include "genlib/containerutils.hpp"
 
-AxialVertex AxialPolygons::makeVertex(const AxialVertexKey &vertexkey, const Point2f &openspace) {
+AxialVertex AxialPolygons::makeVertex(const AxialVertexKey &vertexkey,
+                                      const Point2f &openspace) const {
     auto vertPossIter =
         genlib::getMapAtIndex(vertexPossibles, static_cast<size_t>(vertexkey.refKey));
+    return makeVertex(vertexkey, openspace, vertPossIter);
+}
+
+AxialVertex AxialPolygons::makeVertex(
+    const AxialVertexKey &vertexkey, const Point2f &openspace,
+    std::map<Point2f, std::vector<Point2f>>::const_iterator vertPossIter) const {
     AxialVertex av(vertexkey, vertPossIter->first, openspace);
 
     // n.b., at this point, vertex key m_a and m_b are unfixed
-    std::vector<Point2f> &pointlist = vertPossIter->second;
+    const std::vector<Point2f> &pointlist = vertPossIter->second;
     if (pointlist.size() < 2) {
         return av;
     }
@@ -327,20 +334,23 @@ void AxialPolygons::makeAxialLines(std::set<AxialVertex> &openvertices, std::vec
                                    KeyVertices &keyvertices,
                                    std::vector<PolyConnector> &polyConnections,
                                    std::vector<RadialLine> &radialLines) {
-    auto it = openvertices.rbegin();
-    AxialVertex vertex = *it;
-    openvertices.erase(std::next(it).base());
+    std::vector<AxialVertexLink> links = makeVertexLinks(*openvertices.rbegin());
+    addVertexLinks(openvertices, links, lines, keyvertices, polyConnections, radialLines);
+    std::sort(radialLines.begin(), radialLines.end());
+    radialLines.erase(std::unique(radialLines.begin(), radialLines.end()), radialLines.end());
+}
 
-    handledList.insert(vertex);
+std::vector<AxialVertexLink> AxialPolygons::makeVertexLinks(const AxialVertex &vertex) const {
+    std::vector<AxialVertexLink> links;
 
     int i = -1;
-    for (const auto &vertPoss : vertexPossibles) {
+    for (auto vertPoss = vertexPossibles.begin(); vertPoss != vertexPossibles.end(); ++vertPoss) {
         i++;
         if (i == vertex.refKey) {
             continue;
         }
         bool possible = false, stubpossible = false;
-        Point2f p = vertPoss.first - vertex.point;
+        Point2f p = vertPoss->first - vertex.point;
         if (vertex.convex) {
             if (vertex.a.det(p) > 0 && vertex.b.det(p) > 0) {
                 possible = true;
@@ -353,94 +363,116 @@ void AxialPolygons::makeAxialLines(std::set<AxialVertex> &openvertices, std::vec
                 stubpossible = true;
             }
         }
-        if (possible || stubpossible) {
-            Line4f line(vertPoss.first, vertex.point);
-            if (!intersect_exclude(line)) {
-                AxialVertex nextVertex = makeVertex(AxialVertexKey(i), vertex.point);
-                if (nextVertex.initialised && std::find(handledList.begin(), handledList.end(),
-                                                        nextVertex) == handledList.end()) {
-                    openvertices.insert(nextVertex); // <- note, add ignores duplicate adds (each
-                                                     // vertex tends to be added multiple times
-                                                     // before this vertex is handled itself)
-                    bool shortlineSegend = false;
-                    Line4f shortline = line;
-                    if (!vertex.convex && possible) {
-                        Line4f ext(line.t_end(), line.t_end() + (line.t_end() - line.t_start()));
-                        ext.ray(1, m_region);
-                        cutLine(ext, 1);
-                        line = Line4f(line.t_start(), ext.t_end());
-                        // for radial line segend calc:
-                        if ((-p).det(vertex.b) < 0) {
-                            shortlineSegend = true;
-                        }
-                    }
-                    if (m_vertexPolys[static_cast<size_t>(vertex.refKey)] !=
-                        m_vertexPolys[static_cast<size_t>(
-                            nextVertex.refKey)]) { // must be on separate
-                                                   // polygons
-                        // radial line(s) (for new point)
-                        RadialLine radialshort(nextVertex, shortlineSegend, vertex.point,
-                                               nextVertex.point, nextVertex.point + nextVertex.b);
-                        polyConnections.push_back(
-                            PolyConnector(shortline, static_cast<RadialKey>(radialshort)));
-                        radialLines.push_back(radialshort);
-                        if (!vertex.convex && possible) {
-                            Line4f longline = Line4f(vertPoss.first, line.t_end());
-                            RadialLine radiallong(radialshort);
-                            radiallong.segend = shortlineSegend ? 0 : 1;
-                            polyConnections.push_back(
-                                PolyConnector(longline, static_cast<RadialKey>(radiallong)));
-                            radialLines.push_back(radiallong);
-                        }
-                    }
-                    shortlineSegend = false;
-                    if (!nextVertex.convex && nextVertex.axial) {
-                        Line4f ext(line.t_start() - (line.t_end() - line.t_start()),
-                                   line.t_start());
-                        ext.ray(0, m_region);
-                        cutLine(ext, 0);
-                        line = Line4f(ext.t_start(), line.t_end());
-                        // for radial line segend calc:
-                        if (p.det(nextVertex.b) < 0) {
-                            shortlineSegend = true;
-                        }
-                    }
-                    if (m_vertexPolys[static_cast<size_t>(vertex.refKey)] !=
-                        m_vertexPolys[static_cast<size_t>(
-                            nextVertex.refKey)]) { // must be on separate
-                                                   // polygons
-                        // radial line(s) (for original point)
-                        RadialLine radialshort(vertex, shortlineSegend, nextVertex.point,
-                                               vertex.point, vertex.point + vertex.b);
-                        polyConnections.push_back(
-                            PolyConnector(shortline, static_cast<RadialKey>(radialshort)));
-                        radialLines.push_back(radialshort);
-                        if (!nextVertex.convex && nextVertex.axial) {
-                            Line4f longline = Line4f(line.t_start(), vertex.point);
-                            RadialLine radiallong(radialshort);
-                            radiallong.segend = shortlineSegend ? 0 : 1;
-                            polyConnections.push_back(
-                                PolyConnector(longline, static_cast<RadialKey>(radiallong)));
-                            radialLines.push_back(radiallong);
-                        }
-                    }
-                    if (possible && nextVertex.axial) {
-                        // axial line
-                        lines.push_back(line);
-                        keyvertices.push_back(std::set<int>());
-                        if (vertex.convex) {
-                            keyvertices.back().insert(vertex.refKey);
-                        }
-                        if (nextVertex.convex) {
-                            keyvertices.back().insert(nextVertex.refKey);
-                        }
-                    }
-                }
+        if (!possible && !stubpossible) {
+            continue;
+        }
+        Line4f line(vertPoss->first, vertex.point);
+        if (intersect_exclude(line)) {
+            continue;
+        }
+        AxialVertex nextVertex = makeVertex(AxialVertexKey(i), vertex.point, vertPoss);
+        if (!nextVertex.initialised || handledList.find(nextVertex) != handledList.end()) {
+            continue;
+        }
+        AxialVertexLink &link = links.emplace_back(nextVertex);
+        bool shortlineSegend = false;
+        Line4f shortline = line;
+        if (!vertex.convex && possible) {
+            Line4f ext(line.t_end(), line.t_end() + (line.t_end() - line.t_start()));
+            ext.ray(1, m_region);
+            cutLine(ext, 1);
+            line = Line4f(line.t_start(), ext.t_end());
+            // for radial line segend calc:
+            if ((-p).det(vertex.b) < 0) {
+                shortlineSegend = true;
+            }
+        }
+        if (m_vertexPolys[static_cast<size_t>(vertex.refKey)] !=
+            m_vertexPolys[static_cast<size_t>(nextVertex.refKey)]) { // must be on separate
+                                                                     // polygons
+            // radial line(s) (for new point)
+            RadialLine radialshort(nextVertex, shortlineSegend, vertex.point, nextVertex.point,
+                                   nextVertex.point + nextVertex.b);
+            link.polyConnections.push_back(
+                PolyConnector(shortline, static_cast<RadialKey>(radialshort)));
+            link.radialLines.push_back(radialshort);
+            if (!vertex.convex && possible) {
+                Line4f longline = Line4f(vertPoss->first, line.t_end());
+                RadialLine radiallong(radialshort);
+                radiallong.segend = shortlineSegend ? 0 : 1;
+                link.polyConnections.push_back(
+                    PolyConnector(longline, static_cast<RadialKey>(radiallong)));
+                link.radialLines.push_back(radiallong);
+            }
+        }
+        shortlineSegend = false;
+        if (!nextVertex.convex && nextVertex.axial) {
+            Line4f ext(line.t_start() - (line.t_end() - line.t_start()), line.t_start());
+            ext.ray(0, m_region);
+            cutLine(ext, 0);
+            line = Line4f(ext.t_start(), line.t_end());
+            // for radial line segend calc:
+            if (p.det(nextVertex.b) < 0) {
+                shortlineSegend = true;
+            }
+        }
+        if (m_vertexPolys[static_cast<size_t>(vertex.refKey)] !=
+            m_vertexPolys[static_cast<size_t>(nextVertex.refKey)]) { // must be on separate
+                                                                     // polygons
+            // radial line(s) (for original point)
+            RadialLine radialshort(vertex, shortlineSegend, nextVertex.point, vertex.point,
+                                   vertex.point + vertex.b);
+            link.polyConnections.push_back(
+                PolyConnector(shortline, static_cast<RadialKey>(radialshort)));
+            link.radialLines.push_back(radialshort);
+            if (!nextVertex.convex && nextVertex.axial) {
+                Line4f longline = Line4f(line.t_start(), vertex.point);
+                RadialLine radiallong(radialshort);
+                radiallong.segend = shortlineSegend ? 0 : 1;
+                link.polyConnections.push_back(
+                    PolyConnector(longline, static_cast<RadialKey>(radiallong)));
+                link.radialLines.push_back(radiallong);
+            }
+        }
+        if (possible && nextVertex.axial) {
+            // axial line
+            link.axialLine = line;
+            if (vertex.convex) {
+                link.keyvertices.insert(vertex.refKey);
+            }
+            if (nextVertex.convex) {
+                link.keyvertices.insert(nextVertex.refKey);
             }
         }
     }
-    std::sort(radialLines.begin(), radialLines.end());
-    radialLines.erase(std::unique(radialLines.begin(), radialLines.end()), radialLines.end());
+    return links;
+}
+
+void AxialPolygons::addVertexLinks(std::set<AxialVertex> &openvertices,
+                                   std::vector<AxialVertexLink> &links,
+                                   std::vector<Line4f> &lines, KeyVertices &keyvertices,
+                                   std::vector<PolyConnector> &polyConnections,
+                                   std::vector<RadialLine> &radialLines) {
+    auto it = openvertices.rbegin();
+    handledList.insert(*it);
+    openvertices.erase(std::next(it).base());
+
+    for (auto &link : links) {
+        // the vertex may have been handled since the links were made
+        if (handledList.find(link.nextVertex) != handledList.end()) {
+            continue;
+        }
+        openvertices.insert(link.nextVertex); // <- note, add ignores duplicate adds (each
+                                              // vertex tends to be added multiple times
+                                              // before this vertex is handled itself)
+        polyConnections.insert(polyConnections.end(), link.polyConnections.begin(),
+                               link.polyConnections.end());
+        radialLines.insert(radialLines.end(), link.radialLines.begin(), link.radialLines.end());
+        if (link.axialLine.has_value()) {
+            lines.push_back(*link.axialLine);
+            keyvertices.push_back(std::move(link.keyvertices));
+        }
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
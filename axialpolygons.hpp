@@ -11,6 +11,8 @@
 
 #include "genlib/simplematrix.hpp"
 
+#include <optional>
+
 struct AxialVertexKey {
     int refKey;
     short refA;
@@ -120,6 +122,18 @@ struct PolyConnector {
     PolyConnector(const Line4f &l = Line4f(), const RadialKey &k = RadialKey()) : line(l), key(k) {}
 };
 
+// what handling a vertex adds when it reaches a visible vertex that has not been handled yet:
+// the radial lines and poly connections between the two and possibly an axial line
+struct AxialVertexLink {
+    AxialVertex nextVertex;
+    std::vector<PolyConnector> polyConnections;
+    std::vector<RadialLine> radialLines;
+    std::optional<Line4f> axialLine;
+    std::set<int> keyvertices;
+    AxialVertexLink(const AxialVertex &next = AxialVertex())
+        : nextVertex(next), polyConnections(), radialLines(), axialLine(), keyvertices() {}
+};
+
 class AxialPolygons : public SpacePixel {
     friend class ShapeGraphs;
 
@@ -127,6 +141,9 @@ class AxialPolygons : public SpacePixel {
     std::vector<int> m_vertexPolys;
     genlib::ColumnMatrix<std::vector<int>> m_pixelPolys;
 
+    AxialVertex makeVertex(const AxialVertexKey &vertexkey, const Point2f &openspace,
+                           std::map<Point2f, std::vector<Point2f>>::const_iterator vertPoss) const;
+
   public:
     AxialPolygons() : m_vertexPolys(), m_pixelPolys(0, 0), handledList(), vertexPossibles() {}
     std::set<AxialVertex> handledList;
@@ -137,13 +154,23 @@ class AxialPolygons : public SpacePixel {
                              const std::vector<Connector> &connectionset);
     void makePixelPolys();
     //
-    AxialVertex makeVertex(const AxialVertexKey &vertexkey, const Point2f &openspace);
+    AxialVertex makeVertex(const AxialVertexKey &vertexkey, const Point2f &openspace) const;
     // find a polygon corner visible from seed:
     AxialVertexKey seedVertex(const Point2f &seed);
     // make axial lines from corner vertices, visible from openspace
     void makeAxialLines(std::set<AxialVertex> &openvertices, std::vector<Line4f> &lines,
                         KeyVertices &keyvertices, std::vector<PolyConnector> &polyConnections,
                         std::vector<RadialLine> &radialLines);
+    // the links from an open vertex to the vertices visible from it, leaving out those already
+    // in the handled list. Nothing is changed, so the links of many open vertices can be made
+    // at once as long as no vertex is handled in the meantime
+    std::vector<AxialVertexLink> makeVertexLinks(const AxialVertex &vertex) const;
+    // handle the last open vertex given its links, as makeAxialLines would but without
+    // sorting the radial lines
+    void addVertexLinks(std::set<AxialVertex> &openvertices,
+                        std::vector<AxialVertexLink> &links, std::vector<Line4f> &lines,
+                        KeyVertices &keyvertices, std::vector<PolyConnector> &polyConnections,
+                        std::vector<RadialLine> &radialLines);
     // extra: make all the polygons possible from the set of m_vertex_possibles
     void makePolygons(std::vector<std::vector<Point2f>> &polygons);
 };
@@ -0,0 +1,13 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+// How choice (through-movement) is accumulated from each search root
+
+enum class ChoiceAccumulation {
+    BACKTRACK,   // = 0 walk every discovered path back to the root (original behaviour)
+    SINGLE_PATH, // = 1 one reverse sweep over the search tree, same tie-breaking as BACKTRACK
+    ALL_PATHS    // = 2 one reverse sweep, choice shared among all equally short paths
+};
@@ -29,6 +29,13 @@ bool Connector::read(std::istream &stream) {
     return true;
 }
 
+void Connector::skip(std::istream &stream) {
+    dXreadwrite::skipVector<int>(stream);
+    stream.seekg(sizeof(segmentAxialref), std::ios::cur);
+    dXreadwrite::skipMap<SegmentRef, float>(stream);
+    dXreadwrite::skipMap<SegmentRef, float>(stream);
+}
+
 bool Connector::write(std::ostream &stream) const {
     // n.b., must set displayed attribute as soon as loaded...
     dXreadwrite::writeCastVector<int>(stream, connections);
@@ -83,6 +83,7 @@ struct Connector {
     //
     bool read(std::istream &stream);
     bool write(std::ostream &stream) const;
+    static void skip(std::istream &stream);
     //
     // Cursor extras
     enum { CONN_ALL, SEG_CONN_ALL, SEG_CONN_FW, SEG_CONN_BK };
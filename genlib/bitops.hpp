@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+
+namespace genlib {
+
+    /**
+     * @brief Index of the lowest set bit of a non-zero word
+     */
+    inline unsigned int lowestBitIndex(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+        // de Bruijn multiplication of the isolated lowest bit
+        static const unsigned int index[64] = {
+            0,  1,  48, 2,  57, 49, 28, 3,  61, 58, 50, 42, 38, 29, 17, 4,  //
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,  //
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, //
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9,  13, 8,  7,  6};
+        return index[((word & (~word + 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+    }
+} // namespace genlib
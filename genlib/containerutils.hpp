@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <map>
+#include <set>
 #include <vector>
 
 namespace genlib {
@@ -56,6 +57,26 @@ namespace genlib {
         return iter == m.end() ? -1 : std::distance(m.begin(), iter);
     }
 
+    // the indices of many keys at once, in a single walk through the map rather than one for
+    // each key. Keys not in the map are left out
+    template <typename K, typename V>
+    std::vector<size_t> findIndicesFromKeys(const std::map<K, V> &m, const std::set<K> &keys) {
+        std::vector<size_t> indices;
+        indices.reserve(keys.size());
+        auto keyIter = keys.begin();
+        size_t idx = 0;
+        for (auto iter = m.begin(); iter != m.end() && keyIter != keys.end(); ++iter, ++idx) {
+            while (keyIter != keys.end() && *keyIter < iter->first) {
+                ++keyIter;
+            }
+            if (keyIter != keys.end() && !(iter->first < *keyIter)) {
+                indices.push_back(idx);
+                ++keyIter;
+            }
+        }
+        return indices;
+    }
+
     template <typename TContainer, typename TValue>
     typename TContainer::iterator findBinary(TContainer &container, const TValue val) {
         auto res = std::lower_bound(container.begin(), container.end(), val);
@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace genlib {
+
+    /**
+     * Records the order in which nodes are settled by a search from a single root, along with
+     * their predecessors on shortest paths, so that path dependencies can be accumulated in one
+     * reverse sweep as in Brandes (2001) "A faster algorithm for betweenness centrality". The
+     * cost of the sweep is linear in the number of recorded predecessors, independent of the
+     * depth of the paths.
+     *
+     * If every node is given a single predecessor the sweep reproduces the walk-back-to-root
+     * choice of the original analyses. If all equally short predecessors are added, the
+     * dependency of a node is shared among them in proportion to their path counts.
+     */
+    class DependencySweep {
+        std::vector<size_t> m_order;
+        std::vector<std::vector<size_t>> m_predecessors;
+        std::vector<double> m_pathCount;
+        std::vector<double> m_dependency;
+        std::vector<bool> m_settled;
+
+      public:
+        DependencySweep(size_t nodeCount = 0)
+            : m_order(), m_predecessors(nodeCount), m_pathCount(nodeCount, 0.0),
+              m_dependency(nodeCount, 0.0), m_settled(nodeCount, false) {}
+
+        /**
+         * @brief Clears the nodes settled by the previous search only
+         */
+        void reset() {
+            for (auto node : m_order) {
+                m_predecessors[node].clear();
+                m_pathCount[node] = 0.0;
+                m_settled[node] = false;
+            }
+            m_order.clear();
+        }
+
+        /**
+         * @brief Settles the root of the search
+         */
+        void settleRoot(size_t node) {
+            m_order.push_back(node);
+            m_pathCount[node] = 1.0;
+            m_settled[node] = true;
+        }
+
+        /**
+         * @brief Settles a node reached through its first (tie-breaking) predecessor
+         */
+        void settle(size_t node, size_t predecessor) {
+            m_order.push_back(node);
+            m_predecessors[node].push_back(predecessor);
+            m_pathCount[node] = m_pathCount[predecessor];
+            m_settled[node] = true;
+        }
+
+        /**
+         * @brief Adds a further predecessor through which an already settled node is reached at
+         * the same distance
+         */
+        void addPredecessor(size_t node, size_t predecessor) {
+            m_predecessors[node].push_back(predecessor);
+            m_pathCount[node] += m_pathCount[predecessor];
+        }
+
+        bool isSettled(size_t node) const { return m_settled[node]; }
+        const std::vector<size_t> &getSettleOrder() const { return m_order; }
+
+        /**
+         * @brief Visits the settled nodes in reverse settle order, pushing the dependency of each
+         * onto its predecessors
+         * @param target amount a node contributes as a destination, target(node) -> double
+         * @param visit receives every settled node with the sum of the targets lying beyond it
+         * on paths from the root, visit(node, dependency)
+         */
+        template <typename TargetFn, typename VisitFn>
+        void accumulate(TargetFn target, VisitFn visit) {
+            for (auto node : m_order) {
+                m_dependency[node] = 0.0;
+            }
+            for (auto it = m_order.rbegin(); it != m_order.rend(); ++it) {
+                size_t node = *it;
+                double dependency = m_dependency[node];
+                visit(node, dependency);
+                double push = (dependency + target(node)) / m_pathCount[node];
+                for (auto predecessor : m_predecessors[node]) {
+                    m_dependency[predecessor] += m_pathCount[predecessor] * push;
+                }
+            }
+        }
+    };
+} // namespace genlib
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace genlib {
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &filename)
+        : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+        m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0) {
+            return;
+        }
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            return;
+        }
+        void *data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) {
+            return;
+        }
+        m_data = static_cast<const char *>(data);
+        m_size = static_cast<size_t>(size.QuadPart);
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+    }
+#else
+    MappedFile::MappedFile(const std::string &filename) : m_data(nullptr), m_size(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat status;
+        if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+            auto size = static_cast<size_t>(status.st_size);
+            void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const char *>(data);
+                m_size = size;
+            }
+        }
+        // the mapping stays valid after the file is closed
+        close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data != nullptr) {
+            munmap(const_cast<char *>(m_data), m_size);
+        }
+    }
+#endif
+
+    MemoryStreamBuffer::MemoryStreamBuffer(const char *begin, const char *end) {
+        setg(const_cast<char *>(begin), const_cast<char *>(begin), const_cast<char *>(end));
+    }
+
+    void MemoryStreamBuffer::moveTo(const char *position) {
+        setg(eback(), const_cast<char *>(position), egptr());
+    }
+
+    std::streamsize MemoryStreamBuffer::xsgetn(char *s, std::streamsize count) {
+        std::streamsize available = egptr() - gptr();
+        std::streamsize n = std::min(count, available);
+        if (n > 0) {
+            std::memcpy(s, gptr(), static_cast<size_t>(n));
+            // gbump only takes an int, which may not be enough to move through a large file
+            moveTo(gptr() + n);
+        }
+        return n;
+    }
+
+    std::streamsize MemoryStreamBuffer::showmanyc() {
+        std::streamsize available = egptr() - gptr();
+        return available > 0 ? available : -1;
+    }
+
+    MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type off,
+                                                             std::ios_base::seekdir dir,
+                                                             std::ios_base::openmode which) {
+        if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        const char *base = gptr();
+        if (dir == std::ios_base::beg) {
+            base = eback();
+        } else if (dir == std::ios_base::end) {
+            base = egptr();
+        }
+        if (off < eback() - base || off > egptr() - base) {
+            return pos_type(off_type(-1));
+        }
+        moveTo(base + off);
+        return pos_type(off_type(gptr() - eback()));
+    }
+
+    MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type pos,
+                                                             std::ios_base::openmode which) {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+} // namespace genlib
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <streambuf>
+#include <string>
+
+namespace genlib {
+
+    // A file mapped read-only into memory, so that it can be read without copying it through the
+    // buffers of a file stream. If the file can not be mapped (for example if it is empty or not a
+    // regular file) nothing is mapped, and it has to be read some other way
+    class MappedFile {
+      public:
+        MappedFile(const std::string &filename);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool isMapped() const { return m_data != nullptr; }
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+      private:
+        const char *m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void *m_file;
+        void *m_mapping;
+#endif
+    };
+
+    // A read-only stream buffer over a block of memory, for an istream to read from it directly.
+    // Readers that know the layout of what follows may also take the memory from the current
+    // position and decode it in bulk, then move the position past it
+    class MemoryStreamBuffer : public std::streambuf {
+      public:
+        MemoryStreamBuffer(const char *begin, const char *end);
+
+        const char *current() const { return gptr(); }
+        const char *end() const { return egptr(); }
+        void moveTo(const char *position);
+
+      protected:
+        std::streamsize xsgetn(char *s, std::streamsize count) override;
+        std::streamsize showmanyc() override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+} // namespace genlib
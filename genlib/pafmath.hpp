@@ -9,6 +9,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 namespace pafmath {
     constexpr long double M_ROOT_1_2 = 0.70710678118654752440084436210485L;
@@ -36,6 +37,20 @@ namespace pafmath {
         return static_cast<double>(pafrand(set)) / static_cast<double>(PAF_RAND_MAX + 1);
     }
 
+    // a counter-based random number (SplitMix64 finaliser): the same seed and counter always
+    // give the same number, so independent streams can be drawn without any shared state
+    inline uint64_t counterrand(uint64_t seed, uint64_t counter) {
+        uint64_t z = seed + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // a counter-based random number from 0 to just less than 1
+    inline double counterrandr(uint64_t seed, uint64_t counter) {
+        return static_cast<double>(counterrand(seed, counter) >> 11) * 0x1.0p-53;
+    }
+
     inline double log2(double a) { return (static_cast<double>(pafmath::ln(a) * M_1_LN2)); }
 
     // Hillier Hanson dvalue
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace genlib {
+
+    /**
+     * @brief Stable sort of the positions of a set of keys by the keys. The keys are sorted a
+     * byte at a time from the least significant one, skipping the bytes all the keys share.
+     * Large sets are split into one chunk per thread, each of which is counted and moved in
+     * parallel, the chunks placed one after the other so that the sort stays stable
+     * @param keys the keys, none of which may be NaN
+     * @return the positions of the keys in ascending order of the keys, equal keys in the order
+     * they were given
+     */
+    inline std::vector<size_t> radixSortOrder(const std::vector<double> &keys) {
+        constexpr uint64_t SIGN_BIT = uint64_t(1) << 63;
+        constexpr size_t PARALLEL_THRESHOLD = 1 << 16;
+
+        const size_t n = keys.size();
+        std::vector<uint64_t> bits(n), sortedBits(n);
+        std::vector<size_t> order(n), sortedOrder(n);
+        for (size_t i = 0; i < n; i++) {
+            // -0 and 0 compare equal, so give them the same bits
+            double key = keys[i] == 0.0 ? 0.0 : keys[i];
+            uint64_t keyBits;
+            std::memcpy(&keyBits, &key, sizeof(keyBits));
+            // flip the bits so that they sort as unsigned integers in the order of the doubles
+            bits[i] = (keyBits & SIGN_BIT) ? ~keyBits : (keyBits | SIGN_BIT);
+            order[i] = i;
+        }
+
+        size_t chunkCount = 1;
+#if defined(_OPENMP)
+        if (n >= PARALLEL_THRESHOLD) {
+            chunkCount = static_cast<size_t>(omp_get_max_threads());
+        }
+#endif
+        const size_t chunkSize = (n + chunkCount - 1) / chunkCount;
+        std::vector<std::array<size_t, 256>> counts(chunkCount);
+
+        for (unsigned shift = 0; shift < 64; shift += 8) {
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if (chunkCount > 1)
+#endif
+            for (int c = 0; c < static_cast<int>(chunkCount); c++) {
+                auto &chunkCounts = counts[static_cast<size_t>(c)];
+                chunkCounts.fill(0);
+                size_t end = std::min(n, (static_cast<size_t>(c) + 1) * chunkSize);
+                for (size_t i = static_cast<size_t>(c) * chunkSize; i < end; i++) {
+                    chunkCounts[(bits[i] >> shift) & 0xff]++;
+                }
+            }
+
+            // turn the counts into the place each chunk starts at for each byte, all of the
+            // chunks for one byte before any for the next
+            bool shared = false;
+            size_t offset = 0;
+            for (size_t b = 0; b < 256; b++) {
+                size_t byteStart = offset;
+                for (auto &chunkCounts : counts) {
+                    size_t count = chunkCounts[b];
+                    chunkCounts[b] = offset;
+                    offset += count;
+                }
+                if (offset - byteStart == n) {
+                    shared = true;
+                }
+            }
+            if (shared) {
+                continue;
+            }
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if (chunkCount > 1)
+#endif
+            for (int c = 0; c < static_cast<int>(chunkCount); c++) {
+                auto &chunkCounts = counts[static_cast<size_t>(c)];
+                size_t end = std::min(n, (static_cast<size_t>(c) + 1) * chunkSize);
+                for (size_t i = static_cast<size_t>(c) * chunkSize; i < end; i++) {
+                    size_t &place = chunkCounts[(bits[i] >> shift) & 0xff];
+                    sortedBits[place] = bits[i];
+                    sortedOrder[place] = order[i];
+                    place++;
+                }
+            }
+            std::swap(bits, sortedBits);
+            std::swap(order, sortedOrder);
+        }
+        return order;
+    }
+} // namespace genlib
@@ -31,6 +31,16 @@ namespace dXreadwrite {
         return vec;
     }
 
+    // move past vector data without reading it in, where only what follows is needed
+    template <typename T> size_t skipVector(std::istream &stream) {
+        unsigned int size = 0;
+        stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (size > 0) {
+            stream.seekg(static_cast<std::streamoff>(sizeof(T) * size), std::ios::cur);
+        }
+        return size;
+    }
+
     // read in a vector into a new vector and cast according to new type
     template <typename F, typename T>
     size_t readFromCastIntoVector(std::istream &stream, std::vector<T> &vecT) {
@@ -98,6 +108,17 @@ namespace dXreadwrite {
         return map;
     }
 
+    // move past map data without reading it in
+    template <typename K, typename V> size_t skipMap(std::istream &stream) {
+        unsigned int size = 0;
+        stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (size > 0) {
+            stream.seekg(static_cast<std::streamoff>((sizeof(K) + sizeof(V)) * size),
+                         std::ios::cur);
+        }
+        return size;
+    }
+
     template <typename K, typename V>
     void writeMap(std::ostream &stream, const std::map<K, V> &map) {
         // READ / WRITE USES 32-bit LENGTHS (number of elements) for compatibility reasons
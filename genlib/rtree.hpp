@@ -0,0 +1,395 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "region4f.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace genlib {
+
+    /**
+     * An R-tree of regions, each carrying an integer value (such as a shape key). A whole set
+     * of regions is packed at once with the Sort-Tile-Recursive method of Leutenegger et al.
+     * (1997) "STR: A simple and efficient algorithm for R-tree packing", and single regions
+     * may then be added or removed. Added regions go to the leaf needing the least enlargement,
+     * and full nodes are split in half along their longer side. Removal does not shrink the
+     * node regions, which stay correct as they still cover everything below them.
+     *
+     * Queries do not change the tree, so any number may be run concurrently.
+     */
+    class RTree {
+      public:
+        static constexpr size_t NODE_CAPACITY = 16;
+
+        struct Entry {
+            Region4f region;
+            int value;
+
+          private:
+            [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
+          public:
+            Entry(const Region4f &r = Region4f(), int v = -1) : region(r), value(v), _padding0(0) {}
+        };
+
+      private:
+        struct Node {
+            Region4f region;
+            // entries for leaves, nodes otherwise
+            std::vector<size_t> children;
+            bool leaf;
+
+          private:
+            [[maybe_unused]] unsigned _padding0 : 3 * 8;
+            [[maybe_unused]] unsigned _padding1 : 4 * 8;
+
+          public:
+            Node(bool isLeaf = true)
+                : region(), children(), leaf(isLeaf), _padding0(0), _padding1(0) {}
+        };
+
+        std::vector<Entry> m_entries;
+        std::vector<Node> m_nodes;
+        // slots of removed entries, reused by later insertions
+        std::vector<size_t> m_freeEntries;
+        size_t m_root = 0;
+        size_t m_size = 0;
+
+        static bool overlaps(const Region4f &a, const Region4f &b) {
+            return a.bottomLeft.x <= b.topRight.x && b.bottomLeft.x <= a.topRight.x &&
+                   a.bottomLeft.y <= b.topRight.y && b.bottomLeft.y <= a.topRight.y;
+        }
+        static bool covers(const Region4f &a, const Region4f &b) {
+            return a.bottomLeft.x <= b.bottomLeft.x && a.bottomLeft.y <= b.bottomLeft.y &&
+                   a.topRight.x >= b.topRight.x && a.topRight.y >= b.topRight.y;
+        }
+        static Region4f combine(const Region4f &a, const Region4f &b) {
+            return Region4f(Point2f(std::min(a.bottomLeft.x, b.bottomLeft.x),
+                                    std::min(a.bottomLeft.y, b.bottomLeft.y)),
+                            Point2f(std::max(a.topRight.x, b.topRight.x),
+                                    std::max(a.topRight.y, b.topRight.y)));
+        }
+        static double area(const Region4f &r) {
+            return (r.topRight.x - r.bottomLeft.x) * (r.topRight.y - r.bottomLeft.y);
+        }
+        static Point2f centre(const Region4f &r) {
+            return Point2f((r.bottomLeft.x + r.topRight.x) * 0.5,
+                           (r.bottomLeft.y + r.topRight.y) * 0.5);
+        }
+        const Region4f &childRegion(const Node &node, size_t child) const {
+            return node.leaf ? m_entries[child].region : m_nodes[child].region;
+        }
+        void fitRegion(Node &node) const {
+            node.region = childRegion(node, node.children.front());
+            for (size_t child : node.children) {
+                node.region = combine(node.region, childRegion(node, child));
+            }
+        }
+
+        // packs one level of the tree: the items are tiled into vertical slices by their centres
+        // along x, and each slice into runs along y
+        std::vector<size_t> packLevel(std::vector<size_t> items, bool leaf) {
+            auto centreAlong = [&](size_t item, bool x) {
+                Point2f c = centre(leaf ? m_entries[item].region : m_nodes[item].region);
+                return x ? c.x : c.y;
+            };
+            size_t nodeCount = (items.size() + NODE_CAPACITY - 1) / NODE_CAPACITY;
+            auto sliceCount =
+                static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+            size_t sliceSize = sliceCount * NODE_CAPACITY;
+            std::sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+                return std::make_pair(centreAlong(a, true), a) <
+                       std::make_pair(centreAlong(b, true), b);
+            });
+            std::vector<size_t> level;
+            for (size_t start = 0; start < items.size(); start += sliceSize) {
+                auto sliceBegin = items.begin() + static_cast<std::ptrdiff_t>(start);
+                auto sliceEnd =
+                    items.begin() + static_cast<std::ptrdiff_t>(std::min(start + sliceSize,
+                                                                         items.size()));
+                std::sort(sliceBegin, sliceEnd, [&](size_t a, size_t b) {
+                    return std::make_pair(centreAlong(a, false), a) <
+                           std::make_pair(centreAlong(b, false), b);
+                });
+                for (auto run = sliceBegin; run < sliceEnd;) {
+                    auto runEnd = run + std::min<std::ptrdiff_t>(
+                                            static_cast<std::ptrdiff_t>(NODE_CAPACITY),
+                                            sliceEnd - run);
+                    Node node(leaf);
+                    node.children = std::vector<size_t>(run, runEnd);
+                    fitRegion(node);
+                    level.push_back(m_nodes.size());
+                    m_nodes.push_back(std::move(node));
+                    run = runEnd;
+                }
+            }
+            return level;
+        }
+
+        // splits a full node in half along the longer side of its region, returning the new
+        // node holding the second half
+        size_t split(size_t nodeIndex) {
+            Node &node = m_nodes[nodeIndex];
+            bool alongX = node.region.width() >= node.region.height();
+            std::vector<size_t> children = std::move(node.children);
+            std::sort(children.begin(), children.end(), [&](size_t a, size_t b) {
+                Point2f ca = centre(childRegion(m_nodes[nodeIndex], a));
+                Point2f cb = centre(childRegion(m_nodes[nodeIndex], b));
+                return alongX ? ca.x < cb.x : ca.y < cb.y;
+            });
+            auto half = children.begin() + static_cast<std::ptrdiff_t>(children.size() / 2);
+            Node sibling(node.leaf);
+            sibling.children = std::vector<size_t>(half, children.end());
+            children.erase(half, children.end());
+            node.children = std::move(children);
+            fitRegion(node);
+            fitRegion(sibling);
+            m_nodes.push_back(std::move(sibling));
+            return m_nodes.size() - 1;
+        }
+
+      public:
+        RTree() : m_entries(), m_nodes(), m_freeEntries() {}
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        void clear() {
+            m_entries.clear();
+            m_nodes.clear();
+            m_freeEntries.clear();
+            m_root = 0;
+            m_size = 0;
+        }
+
+        /**
+         * @brief Replaces the contents of the tree with the entries, packed bottom up
+         */
+        void build(std::vector<Entry> entries) {
+            clear();
+            m_entries = std::move(entries);
+            m_size = m_entries.size();
+            if (m_entries.empty()) {
+                return;
+            }
+            std::vector<size_t> level(m_entries.size());
+            for (size_t i = 0; i < level.size(); i++) {
+                level[i] = i;
+            }
+            bool leaf = true;
+            do {
+                level = packLevel(std::move(level), leaf);
+                leaf = false;
+            } while (level.size() > 1);
+            m_root = level.front();
+        }
+
+        void insert(const Region4f &region, int value) {
+            size_t entry = m_entries.size();
+            if (m_freeEntries.empty()) {
+                m_entries.emplace_back(region, value);
+            } else {
+                entry = m_freeEntries.back();
+                m_freeEntries.pop_back();
+                m_entries[entry] = Entry(region, value);
+            }
+            m_size++;
+            if (m_nodes.empty()) {
+                m_nodes.emplace_back(true);
+                m_nodes.back().children.push_back(entry);
+                m_nodes.back().region = region;
+                m_root = 0;
+                return;
+            }
+            // descend to the leaf needing the least enlargement, the smaller on a tie
+            std::vector<size_t> path;
+            size_t current = m_root;
+            while (true) {
+                path.push_back(current);
+                Node &node = m_nodes[current];
+                node.region = node.children.empty() ? region : combine(node.region, region);
+                if (node.leaf) {
+                    break;
+                }
+                size_t best = node.children.front();
+                double bestEnlargement = -1.0, bestArea = -1.0;
+                for (size_t child : node.children) {
+                    const Region4f &childRegion = m_nodes[child].region;
+                    double childArea = area(childRegion);
+                    double enlargement = area(combine(childRegion, region)) - childArea;
+                    if (bestEnlargement < 0.0 || enlargement < bestEnlargement ||
+                        (enlargement == bestEnlargement && childArea < bestArea)) {
+                        best = child;
+                        bestEnlargement = enlargement;
+                        bestArea = childArea;
+                    }
+                }
+                current = best;
+            }
+            m_nodes[current].children.push_back(entry);
+            // split any full nodes on the way back up, growing a new root if needed
+            for (size_t level = path.size(); level-- > 0;) {
+                size_t nodeIndex = path[level];
+                if (m_nodes[nodeIndex].children.size() <= NODE_CAPACITY) {
+                    break;
+                }
+                size_t sibling = split(nodeIndex);
+                if (level == 0) {
+                    Node root(false);
+                    root.children = {nodeIndex, sibling};
+                    fitRegion(root);
+                    m_nodes.push_back(std::move(root));
+                    m_root = m_nodes.size() - 1;
+                } else {
+                    m_nodes[path[level - 1]].children.push_back(sibling);
+                }
+            }
+        }
+
+        /**
+         * @brief Removes an entry with the value, looked for under the region it was added with
+         * first and then through the whole tree
+         * @return false if there was no such entry
+         */
+        bool remove(const Region4f &region, int value) {
+            for (bool anywhere : {false, true}) {
+                if (m_nodes.empty()) {
+                    return false;
+                }
+                std::vector<size_t> stack{m_root};
+                while (!stack.empty()) {
+                    Node &node = m_nodes[stack.back()];
+                    stack.pop_back();
+                    if (!anywhere && !covers(node.region, region)) {
+                        continue;
+                    }
+                    if (!node.leaf) {
+                        stack.insert(stack.end(), node.children.begin(), node.children.end());
+                        continue;
+                    }
+                    auto found = std::find_if(node.children.begin(), node.children.end(),
+                                              [&](size_t entry) {
+                                                  return m_entries[entry].value == value;
+                                              });
+                    if (found != node.children.end()) {
+                        m_freeEntries.push_back(*found);
+                        node.children.erase(found);
+                        m_size--;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Calls visit with the value of every entry whose region overlaps the region,
+         * touching included
+         */
+        template <typename Visitor> void query(const Region4f &region, Visitor &&visit) const {
+            if (m_size == 0) {
+                return;
+            }
+            std::vector<size_t> stack{m_root};
+            while (!stack.empty()) {
+                const Node &node = m_nodes[stack.back()];
+                stack.pop_back();
+                if (!overlaps(node.region, region)) {
+                    continue;
+                }
+                for (size_t child : node.children) {
+                    if (node.leaf) {
+                        if (overlaps(m_entries[child].region, region)) {
+                            visit(m_entries[child].value);
+                        }
+                    } else {
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief The values of the entries overlapping each of the regions, sorted, with the
+         * regions queried in parallel
+         */
+        std::vector<std::vector<int>> queryAll(const std::vector<Region4f> &regions) const {
+            std::vector<std::vector<int>> values(regions.size());
+            auto n = static_cast<int>(regions.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic, 16)
+#endif
+            for (int i = 0; i < n; i++) {
+                auto &found = values[static_cast<size_t>(i)];
+                query(regions[static_cast<size_t>(i)], [&found](int value) {
+                    found.push_back(value);
+                });
+                std::sort(found.begin(), found.end());
+            }
+            return values;
+        }
+
+        /**
+         * @brief Best-first search for the entry closest to a point. The distance to an entry
+         * is given by distanceTo(value), which must be no less than the distance to its region,
+         * or -1 to leave the entry out
+         * @param maxDistance entries further than this are not considered, -1 for no limit
+         * @return the value and distance of the closest entry, value -1 if none was found. On a
+         * tie the lowest value is returned
+         */
+        template <typename Distance>
+        std::pair<int, double> nearest(const Point2f &point, Distance &&distanceTo,
+                                       double maxDistance = -1.0) const {
+            auto regionDistance = [&point](const Region4f &r) {
+                double dx = std::max({r.bottomLeft.x - point.x, 0.0, point.x - r.topRight.x});
+                double dy = std::max({r.bottomLeft.y - point.y, 0.0, point.y - r.topRight.y});
+                return std::sqrt(dx * dx + dy * dy);
+            };
+            // distance, then nodes (0) before entries (1) so that all entries at a distance
+            // are found before one is returned, then the node index or entry value
+            using Candidate = std::tuple<double, int, long>;
+            std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+            if (m_size != 0) {
+                queue.emplace(regionDistance(m_nodes[m_root].region), 0,
+                              static_cast<long>(m_root));
+            }
+            while (!queue.empty()) {
+                auto [distance, kind, item] = queue.top();
+                queue.pop();
+                if (maxDistance != -1.0 && distance > maxDistance) {
+                    break;
+                }
+                if (kind == 1) {
+                    return std::make_pair(static_cast<int>(item), distance);
+                }
+                const Node &node = m_nodes[static_cast<size_t>(item)];
+                for (size_t child : node.children) {
+                    if (node.leaf) {
+                        const Entry &entry = m_entries[child];
+                        if (maxDistance != -1.0 &&
+                            regionDistance(entry.region) > maxDistance) {
+                            continue;
+                        }
+                        double entryDistance = distanceTo(entry.value);
+                        if (entryDistance != -1.0) {
+                            queue.emplace(entryDistance, 1, entry.value);
+                        }
+                    } else {
+                        queue.emplace(regionDistance(m_nodes[child].region), 0,
+                                      static_cast<long>(child));
+                    }
+                }
+            }
+            return std::make_pair(-1, -1.0);
+        }
+    };
+} // namespace genlib
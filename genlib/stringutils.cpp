@@ -39,6 +39,14 @@ namespace dXstring {
         return result;
     }
 
+    void skipString(std::istream &stream) {
+        unsigned int length = 0;
+        stream.read(reinterpret_cast<char *>(&length), sizeof(length));
+        if (length > 0) {
+            stream.seekg(static_cast<std::streamoff>(length), std::ios::cur);
+        }
+    }
+
     void writeString(std::ostream &stream, const std::string &s) {
         unsigned int length = static_cast<unsigned int>(s.length());
         stream.write(reinterpret_cast<char *>(&length), sizeof(unsigned int));
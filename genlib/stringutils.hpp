@@ -12,6 +12,7 @@
 namespace dXstring {
     std::vector<std::string> split(const std::string &s, char delim, bool skipEmptyTokens = false);
     std::string readString(std::istream &stream);
+    void skipString(std::istream &stream);
     void writeString(std::ostream &stream, const std::string &s);
     std::string formatString(double value, const std::string &format = "%+.16le");
     std::string formatString(int value, const std::string &format = "% 16d");
@@ -68,7 +68,7 @@ namespace IsovistUtils {
         Isovist iso;
         iso.makeit(bspNodeTree.getRoot(), p, bounds, startangle, endangle);
         int polyref = map.makePolyShape(iso.getPolygon(), false);
-        map.getAllShapes()[polyref].setCentroid(p);
+        map.getAllShapes().at(polyref).setCentroid(p);
 
         AttributeTable &table = map.getAttributeTable();
         AttributeRow &row = table.getRow(AttributeKey(polyref));
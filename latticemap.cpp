@@ -14,6 +14,7 @@
 
 #include "genlib/comm.hpp" // for communicator
 #include "genlib/containerutils.hpp"
+#include "genlib/mappedfile.hpp"
 #include "genlib/pflipper.hpp"
 #include "genlib/stringutils.hpp"
 
@@ -21,6 +22,55 @@
 #include <numeric>
 #include <unordered_set>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace {
+    // Points held in memory (from a file mapped into memory) are read on several threads, a
+    // column at a time. The points are first skipped through to find where each column starts,
+    // which is only worth it if there are other threads to do the reading. Returns false if the
+    // points were not read, leaving the stream where it was
+    bool readPointColumnsInParallel([[maybe_unused]] std::istream &stream,
+                                    [[maybe_unused]] genlib::ColumnMatrix<Point> &points) {
+#if defined(_OPENMP)
+        auto *buffer = dynamic_cast<genlib::MemoryStreamBuffer *>(stream.rdbuf());
+        if (buffer == nullptr || !stream.good() || omp_get_max_threads() < 2) {
+            return false;
+        }
+        std::vector<const char *> columnStarts;
+        columnStarts.reserve(points.columns() + 1);
+        for (size_t j = 0; j < points.columns(); j++) {
+            columnStarts.push_back(buffer->current());
+            for (size_t k = 0; k < points.rows(); k++) {
+                Point::skip(stream);
+            }
+        }
+        columnStarts.push_back(buffer->current());
+        if (stream.fail()) {
+            // damaged, leave it to be read as usual
+            stream.clear();
+            buffer->moveTo(columnStarts.front());
+            return false;
+        }
+
+        auto n = static_cast<int>(points.columns());
+#pragma omp parallel for default(shared) schedule(dynamic)
+        for (int i = 0; i < n; i++) {
+            auto j = static_cast<size_t>(i);
+            genlib::MemoryStreamBuffer columnBuffer(columnStarts[j], columnStarts[j + 1]);
+            std::istream columnStream(&columnBuffer);
+            for (size_t k = 0; k < points.rows(); k++) {
+                points(k, j).read(columnStream);
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+} // namespace
+
 /////////////////////////////////////////////////////////////////////////////////
 
 LatticeMap::LatticeMap(Region4f region, const std::string &name)
@@ -738,11 +788,15 @@ bool LatticeMap::readPointsAndAttributes(std::istream &stream) {
 
     m_points = genlib::ColumnMatrix<Point>(m_rows, m_cols);
 
-    for (size_t j = 0; j < m_cols; j++) {
-        for (size_t k = 0; k < m_rows; k++) {
-            m_points(k, j).read(stream);
+    if (!readPointColumnsInParallel(stream, m_points)) {
+        for (size_t j = 0; j < m_cols; j++) {
+            for (size_t k = 0; k < m_rows; k++) {
+                m_points(k, j).read(stream);
+            }
         }
+    }
 
+    for (size_t j = 0; j < m_cols; j++) {
         for (size_t k = 0; k < m_rows; k++) {
             Point &pnt = m_points(k, j);
             // Old style point node reffing and also unselects selected nodes which
@@ -787,6 +841,25 @@ std::tuple<bool, int> LatticeMap::read(std::istream &stream) {
     return std::make_tuple(read, displayedAttribute);
 }
 
+std::string LatticeMap::skip(std::istream &stream) {
+    std::string name = dXstring::readString(stream);
+    int rows = 0, cols = 0;
+    stream.seekg(sizeof(m_spacing), std::ios::cur);
+    stream.read(reinterpret_cast<char *>(&rows), sizeof(rows));
+    stream.read(reinterpret_cast<char *>(&cols), sizeof(cols));
+    // filled point count, bottom left and displayed attribute
+    stream.seekg(sizeof(m_filledPointCount) + sizeof(m_bottomLeft) + sizeof(int), std::ios::cur);
+
+    AttributeTable::skip(stream);
+    for (int j = 0; j < cols; j++) {
+        for (int k = 0; k < rows; k++) {
+            Point::skip(stream);
+        }
+    }
+    stream.seekg(sizeof(m_processed) + sizeof(m_boundarygraph), std::ios::cur);
+    return name;
+}
+
 bool LatticeMap::writeMetadata(std::ostream &stream) const {
     dXstring::writeString(stream, m_name);
 
@@ -192,6 +192,8 @@ class LatticeMap : public AttributeMap {
     bool readMetadata(std::istream &stream);
     bool readPointsAndAttributes(std::istream &stream);
     std::tuple<bool, int> read(std::istream &stream);
+    // move past what read would read, without reading it in, giving the name of the map
+    static std::string skip(std::istream &stream);
 
     bool writeMetadata(std::ostream &stream) const;
     bool writePointsAndAttributes(std::ostream &stream) const;
@@ -78,6 +78,16 @@ void LayerManagerImpl::read(std::istream &stream) {
     }
 }
 
+void LayerManagerImpl::skip(std::istream &stream) {
+    stream.seekg(sizeof(KeyType) + sizeof(m_visibleLayers), std::ios::cur);
+    int count = 0;
+    stream.read(reinterpret_cast<char *>(&count), sizeof(int));
+    for (int i = 0; i < count; ++i) {
+        stream.seekg(sizeof(KeyType), std::ios::cur);
+        dXstring::skipString(stream);
+    }
+}
+
 void LayerManagerImpl::write(std::ostream &stream) const {
     //    KeyType availableLayers = 0;
     //    for (size_t i = m_layers.size(); i < 64; ++i)
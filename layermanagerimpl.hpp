@@ -26,6 +26,7 @@ class LayerManagerImpl : public LayerManager {
 
     void read(std::istream &stream) override;
     void write(std::ostream &stream) const override;
+    static void skip(std::istream &stream);
 
   private:
     void checkIndex(size_t index) const;
@@ -487,7 +487,7 @@ MapConverter::convertAxialToSegment(Communicator *, ShapeGraph &axialMap, const
     // destroy unnecessary parts of axial map as quickly as possible in order not
     // to overload memory
     if (!keeporiginal) {
-        axialMap.getAllShapes().clear();
+        axialMap.clearShapes();
         axialMap.getConnections().clear();
     }
 
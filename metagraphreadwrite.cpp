@@ -10,9 +10,11 @@
 #include "mgraph_consts.hpp"
 #include "shapemapgroupdata.hpp"
 
+#include "genlib/mappedfile.hpp"
 #include "genlib/readwritehelpers.hpp"
 #include "genlib/stringutils.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 namespace {
@@ -41,6 +43,153 @@ namespace {
         return ref.get();
     }
 
+    // The table of contents is written after the last section, which readers before it stop at.
+    // It ends with where it starts, relative to the start of the graph, and a marker, so that it
+    // can be found from the end of the file
+    const char TABLE_OF_CONTENTS_TYPE = 't';
+    const char TABLE_OF_CONTENTS_MARKER[3] = {'t', 'o', 'c'};
+    // the "grf" marker, version, state, view class, and show grid and text flags
+    const std::streamoff GRAPH_HEADER_SIZE = 3 + sizeof(int) * 3 + sizeof(bool) * 2;
+    const std::streamoff TABLE_OF_CONTENTS_TRAILER_SIZE = sizeof(int64_t) + 3;
+
+    std::tuple<std::string, int> getNameAndType(const LatticeMap &map) {
+        return std::make_tuple(map.getName(), -1);
+    }
+    std::tuple<std::string, int> getNameAndType(const ShapeMap &map) {
+        return std::make_tuple(map.getName(), map.getMapType());
+    }
+
+    // adds maps just written, from the positions the write function gave
+    template <typename MapOrRef>
+    void addToContents(MetaGraphReadWrite::TableOfContents &contents,
+                       MetaGraphReadWrite::MapSection section, int drawingFile,
+                       const std::vector<MapOrRef> &maps,
+                       const std::vector<std::streampos> &mapPositions, std::streampos start) {
+        for (size_t i = 0; i < maps.size(); i++) {
+            MetaGraphReadWrite::MapLocation location;
+            std::tie(location.name, location.mapType) =
+                getNameAndType(getMapRef(std::forward<const MapOrRef>(maps[i]),
+                                         is_reference_wrapper<std::decay_t<const MapOrRef>>{}));
+            location.offset = mapPositions[i] - start;
+            location.size = mapPositions[i + 1] - mapPositions[i];
+            location.section = section;
+            location.index = static_cast<unsigned int>(i);
+            location.drawingFile = drawingFile;
+            contents.maps.push_back(std::move(location));
+        }
+    }
+
+    void writeTableOfContents(std::ostream &stream,
+                              const MetaGraphReadWrite::TableOfContents &contents,
+                              std::streampos start) {
+        int64_t contentsOffset = stream.tellp() - start;
+        stream.write(&TABLE_OF_CONTENTS_TYPE, 1);
+        auto count = static_cast<unsigned int>(contents.maps.size());
+        stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        for (const auto &location : contents.maps) {
+            int section = static_cast<int>(location.section);
+            stream.write(reinterpret_cast<const char *>(&section), sizeof(section));
+            stream.write(reinterpret_cast<const char *>(&location.drawingFile),
+                         sizeof(location.drawingFile));
+            stream.write(reinterpret_cast<const char *>(&location.index), sizeof(location.index));
+            stream.write(reinterpret_cast<const char *>(&location.mapType),
+                         sizeof(location.mapType));
+            stream.write(reinterpret_cast<const char *>(&location.offset),
+                         sizeof(location.offset));
+            stream.write(reinterpret_cast<const char *>(&location.size), sizeof(location.size));
+            dXstring::writeString(stream, location.name);
+        }
+        stream.write(reinterpret_cast<const char *>(&contents.region), sizeof(contents.region));
+        stream.write(reinterpret_cast<const char *>(&contentsOffset), sizeof(contentsOffset));
+        stream.write(TABLE_OF_CONTENTS_MARKER, 3);
+    }
+
+    // reads the table of contents written at the end of the graph, if there is one, with the
+    // offsets of the maps made into positions in the stream
+    bool readWrittenTableOfContents(std::istream &stream, std::streampos start,
+                                    MetaGraphReadWrite::TableOfContents &contents) {
+        stream.seekg(0, std::ios::end);
+        std::streamoff length = stream.tellg() - start;
+        if (stream.fail() || length < GRAPH_HEADER_SIZE + TABLE_OF_CONTENTS_TRAILER_SIZE) {
+            return false;
+        }
+        stream.seekg(start + (length - TABLE_OF_CONTENTS_TRAILER_SIZE));
+        int64_t contentsOffset = -1;
+        char marker[3] = {0, 0, 0};
+        stream.read(reinterpret_cast<char *>(&contentsOffset), sizeof(contentsOffset));
+        stream.read(marker, 3);
+        if (stream.fail() || !std::equal(marker, marker + 3, TABLE_OF_CONTENTS_MARKER) ||
+            contentsOffset < GRAPH_HEADER_SIZE ||
+            contentsOffset > length - TABLE_OF_CONTENTS_TRAILER_SIZE) {
+            return false;
+        }
+        stream.seekg(start + static_cast<std::streamoff>(contentsOffset));
+        char type = 0;
+        stream.read(&type, 1);
+        if (type != TABLE_OF_CONTENTS_TYPE) {
+            return false;
+        }
+        unsigned int count = 0;
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        std::vector<MetaGraphReadWrite::MapLocation> maps;
+        for (unsigned int i = 0; i < count && !stream.fail(); i++) {
+            MetaGraphReadWrite::MapLocation location;
+            int section = 0;
+            stream.read(reinterpret_cast<char *>(&section), sizeof(section));
+            location.section = static_cast<MetaGraphReadWrite::MapSection>(section);
+            stream.read(reinterpret_cast<char *>(&location.drawingFile),
+                        sizeof(location.drawingFile));
+            stream.read(reinterpret_cast<char *>(&location.index), sizeof(location.index));
+            stream.read(reinterpret_cast<char *>(&location.mapType), sizeof(location.mapType));
+            stream.read(reinterpret_cast<char *>(&location.offset), sizeof(location.offset));
+            stream.read(reinterpret_cast<char *>(&location.size), sizeof(location.size));
+            location.name = dXstring::readString(stream);
+            if (location.offset < GRAPH_HEADER_SIZE || location.size < 0 ||
+                location.offset + location.size > contentsOffset) {
+                return false;
+            }
+            location.offset += static_cast<int64_t>(start);
+            maps.push_back(std::move(location));
+        }
+        stream.read(reinterpret_cast<char *>(&contents.region), sizeof(contents.region));
+        if (stream.fail()) {
+            return false;
+        }
+        contents.maps = std::move(maps);
+        contents.written = true;
+        return true;
+    }
+
+    const MetaGraphReadWrite::MapLocation &
+    findMap(const MetaGraphReadWrite::TableOfContents &contents,
+            MetaGraphReadWrite::MapSection section, int drawingFile, size_t index) {
+        for (const auto &location : contents.maps) {
+            if (location.section == section && location.drawingFile == drawingFile &&
+                location.index == index) {
+                return location;
+            }
+        }
+        throw MetaGraphReadWrite::MetaGraphReadError("Map " + std::to_string(index) +
+                                                     " not found in the graph");
+    }
+
+    // moves the stream to where a map starts, throwing if it can not read it from there
+    void seekMap(std::istream &stream, const MetaGraphReadWrite::MapLocation &location) {
+        stream.clear();
+        stream.seekg(static_cast<std::streamoff>(location.offset));
+        if (stream.fail()) {
+            throw MetaGraphReadWrite::MetaGraphReadError(MetaGraphReadWrite::getReadMessage(
+                MetaGraphReadWrite::ReadWriteStatus::DAMAGED_FILE));
+        }
+    }
+
+    void checkMapRead(std::istream &stream) {
+        if (stream.fail()) {
+            throw MetaGraphReadWrite::MetaGraphReadError(MetaGraphReadWrite::getReadMessage(
+                MetaGraphReadWrite::ReadWriteStatus::DAMAGED_FILE));
+        }
+    }
+
 } // namespace
 
 MetaGraphReadWrite::MetaGraphData MetaGraphReadWrite::readFromFile(const std::string &filename) {
@@ -49,6 +198,16 @@ MetaGraphReadWrite::MetaGraphData MetaGraphReadWrite::readFromFile(const std::st
         throw MetaGraphReadError("File is not a MetaGraph");
     }
 
+    // read straight from the file mapped into memory where possible, which also allows the
+    // larger blocks in it to be read in parallel
+    genlib::MappedFile mappedFile(filename);
+    if (mappedFile.isMapped()) {
+        const char *data = mappedFile.data();
+        genlib::MemoryStreamBuffer buffer(data, data + mappedFile.size());
+        std::istream stream(&buffer);
+        return MetaGraphReadWrite::readFromStream(stream);
+    }
+
 #ifdef _WIN32
     std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
 #else
@@ -221,6 +380,187 @@ MetaGraphReadWrite::MetaGraphData MetaGraphReadWrite::readFromStream(std::istrea
     return mgd;
 }
 
+MetaGraphReadWrite::TableOfContents MetaGraphReadWrite::readTableOfContents(std::istream &stream) {
+
+    TableOfContents contents;
+    std::streampos start = stream.tellg();
+
+    char header[3];
+    stream.read(header, 3);
+    if (stream.fail() || header[0] != 'g' || header[1] != 'r' || header[2] != 'f') {
+        throw MetaGraphReadError(getReadMessage(ReadWriteStatus::NOT_A_GRAPH));
+    }
+    stream.read(reinterpret_cast<char *>(&contents.version), sizeof(contents.version));
+    if (contents.version > METAGRAPH_VERSION) {
+        throw MetaGraphReadError(getReadMessage(ReadWriteStatus::NEWER_VERSION));
+    }
+    if (contents.version < METAGRAPH_VERSION) {
+        throw MetaGraphReadError(getReadMessage(ReadWriteStatus::DEPRECATED_VERSION));
+    }
+    if (start == std::streampos(-1)) {
+        throw MetaGraphReadError("Graph can not be read from a stream without positions");
+    }
+    if (readWrittenTableOfContents(stream, start, contents)) {
+        return contents;
+    }
+
+    // no table of contents was written, so the maps are found by skimming through the sections
+    // in the order readFromStream reads them
+    stream.clear();
+    stream.seekg(start + GRAPH_HEADER_SIZE);
+
+    auto skimMap = [&stream, &contents](MapSection section, int drawingFile, unsigned int index) {
+        MapLocation location;
+        location.offset = static_cast<int64_t>(stream.tellg());
+        if (section == MapSection::LATTICE_MAPS) {
+            location.name = LatticeMap::skip(stream);
+        } else if (section == MapSection::SHAPE_GRAPHS) {
+            std::tie(location.name, location.mapType) = ShapeGraph::skip(stream);
+        } else {
+            std::tie(location.name, location.mapType) = ShapeMap::skip(stream);
+        }
+        if (stream.fail()) {
+            throw MetaGraphReadError(getReadMessage(ReadWriteStatus::DAMAGED_FILE));
+        }
+        location.size = static_cast<int64_t>(stream.tellg()) - location.offset;
+        location.section = section;
+        location.drawingFile = drawingFile;
+        location.index = index;
+        contents.maps.push_back(std::move(location));
+    };
+
+    char type = 0;
+    stream.read(&type, 1);
+    if (type == 'd') {
+        throw MetaGraphReadError(getReadMessage(ReadWriteStatus::DEPRECATED_VERSION));
+    }
+    if (type == 'x') {
+        FileProperties().read(stream);
+        if (stream.eof()) {
+            throw MetaGraphReadError(getReadMessage(ReadWriteStatus::DAMAGED_FILE));
+        }
+        stream.read(&type, 1);
+    }
+    if (stream.eof()) {
+        return contents;
+    }
+    if (type == 'v') {
+        skipVirtualMem(stream);
+        if (stream.eof()) {
+            throw MetaGraphReadError(getReadMessage(ReadWriteStatus::DAMAGED_FILE));
+        }
+        stream.read(&type, 1);
+    }
+    if (type == 'l') {
+        dXstring::skipString(stream);
+        contents.region = readRegion(stream);
+        int count = 0;
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        for (int i = 0; i < count && !stream.fail(); i++) {
+            // the name and region of the drawing file
+            dXstring::skipString(stream);
+            readRegion(stream);
+            int mapCount = 0;
+            stream.read(reinterpret_cast<char *>(&mapCount), sizeof(mapCount));
+            for (int j = 0; j < mapCount; j++) {
+                skimMap(MapSection::DRAWING_MAPS, i, static_cast<unsigned int>(j));
+            }
+        }
+        if (!stream.eof()) {
+            stream.read(&type, 1);
+        }
+    }
+    if (type == 'p') {
+        // the displayed map and the number of maps
+        int displayedMap = -1, count = 0;
+        stream.read(reinterpret_cast<char *>(&displayedMap), sizeof(displayedMap));
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        for (int i = 0; i < count; i++) {
+            skimMap(MapSection::LATTICE_MAPS, -1, static_cast<unsigned int>(i));
+        }
+        if (!stream.eof()) {
+            stream.read(&type, 1);
+        }
+        if (type == 'g' && !stream.eof()) {
+            stream.read(&type, 1);
+        }
+    }
+    if (type == 'a' && !stream.eof()) {
+        stream.read(&type, 1);
+    }
+    if (type == 'x') {
+        int displayedMap = -1;
+        unsigned int count = 0;
+        stream.read(reinterpret_cast<char *>(&displayedMap), sizeof(displayedMap));
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        for (unsigned int i = 0; i < count; i++) {
+            skimMap(MapSection::SHAPE_GRAPHS, -1, i);
+        }
+        // the all-line map data follow the shape graphs, as readShapeGraphs reads them
+        bool hasAllLineMap =
+            std::any_of(contents.maps.begin(), contents.maps.end(), [](const MapLocation &map) {
+                return map.section == MapSection::SHAPE_GRAPHS &&
+                       map.mapType == ShapeMap::ALLLINEMAP;
+            });
+        if (hasAllLineMap) {
+            dXreadwrite::skipVector<PolyConnector>(stream);
+            dXreadwrite::skipVector<RadialLine>(stream);
+        } else {
+            stream.ignore(sizeof(unsigned int) * 2);
+        }
+        if (!stream.eof()) {
+            stream.read(&type, 1);
+        }
+    }
+    if (type == 's') {
+        int displayedMap = -1;
+        unsigned int count = 0;
+        stream.read(reinterpret_cast<char *>(&displayedMap), sizeof(displayedMap));
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        for (unsigned int i = 0; i < count; i++) {
+            skimMap(MapSection::DATA_MAPS, -1, i);
+        }
+    }
+    return contents;
+}
+
+LatticeMap MetaGraphReadWrite::readLatticeMap(std::istream &stream,
+                                              const TableOfContents &contents, size_t index) {
+    seekMap(stream, findMap(contents, MapSection::LATTICE_MAPS, -1, index));
+    LatticeMap latticeMap(contents.region);
+    latticeMap.read(stream);
+    checkMapRead(stream);
+    return latticeMap;
+}
+
+ShapeGraph MetaGraphReadWrite::readShapeGraph(std::istream &stream,
+                                              const TableOfContents &contents, size_t index) {
+    seekMap(stream, findMap(contents, MapSection::SHAPE_GRAPHS, -1, index));
+    ShapeGraph shapeGraph;
+    shapeGraph.read(stream);
+    checkMapRead(stream);
+    return shapeGraph;
+}
+
+ShapeMap MetaGraphReadWrite::readDataMap(std::istream &stream, const TableOfContents &contents,
+                                         size_t index) {
+    seekMap(stream, findMap(contents, MapSection::DATA_MAPS, -1, index));
+    ShapeMap dataMap;
+    dataMap.read(stream);
+    checkMapRead(stream);
+    return dataMap;
+}
+
+ShapeMap MetaGraphReadWrite::readDrawingMap(std::istream &stream, const TableOfContents &contents,
+                                            size_t drawingFile, size_t index) {
+    seekMap(stream,
+            findMap(contents, MapSection::DRAWING_MAPS, static_cast<int>(drawingFile), index));
+    ShapeMap drawingMap;
+    drawingMap.read(stream);
+    checkMapRead(stream);
+    return drawingMap;
+}
+
 MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToFile(const std::string &filename,
                                                                     const MetaGraphData &mgd) {
     auto &dd = mgd.displayData;
@@ -288,18 +628,25 @@ template <typename LatticeMapOrRef>
 bool MetaGraphReadWrite::writeLatticeMaps(std::ostream &stream,
                                           const std::vector<LatticeMapOrRef> &latticeMaps,
                                           const std::vector<int> &displayData,
-                                          const std::optional<unsigned int> &displayedMap) {
+                                          const std::optional<unsigned int> &displayedMap,
+                                          std::vector<std::streampos> *mapPositions) {
     int displayedLatticeMap = displayedMap.has_value() ? static_cast<int>(*displayedMap) : -1;
     stream.write(reinterpret_cast<const char *>(&displayedLatticeMap), sizeof(displayedLatticeMap));
     auto count = latticeMaps.size();
     stream.write(reinterpret_cast<const char *>(&count), sizeof(static_cast<int>(count)));
     auto it = displayData.begin();
     for (auto &latticeMap : latticeMaps) {
+        if (mapPositions != nullptr) {
+            mapPositions->push_back(stream.tellp());
+        }
         getMapRef(std::forward<const LatticeMapOrRef>(latticeMap),
                   is_reference_wrapper<std::decay_t<const LatticeMapOrRef>>{})
             .write(stream, *it);
         it++;
     }
+    if (mapPositions != nullptr) {
+        mapPositions->push_back(stream.tellp());
+    }
     return true;
 }
 
@@ -333,7 +680,8 @@ template <typename ShapeMapOrRef>
 bool MetaGraphReadWrite::writeDataMaps(std::ostream &stream,
                                        const std::vector<ShapeMapOrRef> &dataMaps,
                                        const std::vector<ShapeMapDisplayData> &displayData,
-                                       const std::optional<unsigned int> &displayedMap) {
+                                       const std::optional<unsigned int> &displayedMap,
+                                       std::vector<std::streampos> *mapPositions) {
     // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion
     // problems
     int displayedDataMap = displayedMap.has_value() ? static_cast<int>(*displayedMap) : -1;
@@ -345,29 +693,41 @@ bool MetaGraphReadWrite::writeDataMaps(std::ostream &stream,
     stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
     auto it = displayData.begin();
     for (auto &dataMap : dataMaps) {
+        if (mapPositions != nullptr) {
+            mapPositions->push_back(stream.tellp());
+        }
         getMapRef(std::forward<const ShapeMapOrRef>(dataMap),
                   is_reference_wrapper<std::decay_t<const ShapeMapOrRef>>{})
             .write(stream, *it);
         it++;
     }
+    if (mapPositions != nullptr) {
+        mapPositions->push_back(stream.tellp());
+    }
     return true;
 }
 
 template <typename ShapeMapOrRef>
 bool MetaGraphReadWrite::writeSpacePixels(
     std::ostream &stream, const std::vector<ShapeMapOrRef> &spacePixels,
-    const std::vector<std::tuple<bool, bool, int>> &displayData) {
+    const std::vector<std::tuple<bool, bool, int>> &displayData,
+    std::vector<std::streampos> *mapPositions) {
 
     int count = static_cast<int>(spacePixels.size());
     stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
     auto it = displayData.begin();
     for (auto &spacePixel : spacePixels) {
-
+        if (mapPositions != nullptr) {
+            mapPositions->push_back(stream.tellp());
+        }
         getMapRef(std::forward<const ShapeMapOrRef>(spacePixel),
                   is_reference_wrapper<std::decay_t<const ShapeMapOrRef>>{})
             .write(stream, *it);
         it++;
     }
+    if (mapPositions != nullptr) {
+        mapPositions->push_back(stream.tellp());
+    }
     return true;
 }
 
@@ -439,7 +799,7 @@ bool MetaGraphReadWrite::writeShapeGraphs(
     std::ostream &stream, const std::vector<ShapeGraphOrRef> &shapeGraphs,
     const std::optional<AllLine::MapData> &allLineMapData,
     const std::vector<std::tuple<bool, bool, int>> &displayData,
-    const std::optional<unsigned int> &displayedMap) {
+    const std::optional<unsigned int> &displayedMap, std::vector<std::streampos> *mapPositions) {
     // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion
     // problems
     int displayedShapeGraph = displayedMap.has_value() ? static_cast<int>(*displayedMap) : -1;
@@ -451,11 +811,17 @@ bool MetaGraphReadWrite::writeShapeGraphs(
     stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
     auto it = displayData.begin();
     for (auto &shapeGraphPtr : shapeGraphs) {
+        if (mapPositions != nullptr) {
+            mapPositions->push_back(stream.tellp());
+        }
         getMapRef(std::forward<const ShapeGraphOrRef>(shapeGraphPtr),
                   is_reference_wrapper<std::decay_t<const ShapeGraphOrRef>>{})
             .write(stream, *it);
         it++;
     }
+    if (mapPositions != nullptr) {
+        mapPositions->push_back(stream.tellp());
+    }
 
     if (!allLineMapData.has_value()) {
         // There's still a reference to this data in the metagraph,
@@ -533,6 +899,14 @@ MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToStream(
 
     char type;
 
+    // the maps are found again from where they are written, which only streams that can give
+    // their position can tell
+    std::streampos start = stream.tellp();
+    TableOfContents contents;
+    contents.region = drawingFiles.empty() ? Region4f() : region;
+    std::vector<std::streampos> positions;
+    std::vector<std::streampos> *mapPositions = start == std::streampos(-1) ? nullptr : &positions;
+
     stream.write("grf", 3);
     stream.write(reinterpret_cast<const char *>(&version), sizeof(version));
 
@@ -554,24 +928,28 @@ MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToStream(
 
         int count = static_cast<int>(drawingFiles.size());
         stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
-        if (perDrawingMap.empty()) {
-            for (auto &spacePixel : drawingFiles) {
-                spacePixel.first.writeOutNameAndRegion(stream);
+        int drawingFile = 0;
+        auto it = perDrawingMap.begin();
+        for (auto &spacePixel : drawingFiles) {
+            spacePixel.first.writeOutNameAndRegion(stream);
+            if (perDrawingMap.empty()) {
                 std::vector<ShapeMapDisplayData> displayData(spacePixel.second.size());
                 for (auto &dd : displayData) {
                     std::get<0>(dd) = true;
                     std::get<1>(dd) = true;
                     std::get<2>(dd) = -1;
                 }
-                writeSpacePixels(stream, spacePixel.second, displayData);
-            }
-        } else {
-            auto it = perDrawingMap.begin();
-            for (auto &spacePixel : drawingFiles) {
-                spacePixel.first.writeOutNameAndRegion(stream);
-                writeSpacePixels(stream, spacePixel.second, *it);
+                writeSpacePixels(stream, spacePixel.second, displayData, mapPositions);
+            } else {
+                writeSpacePixels(stream, spacePixel.second, *it, mapPositions);
                 it++;
             }
+            if (mapPositions != nullptr) {
+                addToContents(contents, MapSection::DRAWING_MAPS, drawingFile, spacePixel.second,
+                              positions, start);
+                positions.clear();
+            }
+            drawingFile++;
         }
     }
     if (!latticeMaps.empty()) {
@@ -579,9 +957,14 @@ MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToStream(
         stream.write(&type, 1);
         if (perLatticeMap.empty()) {
             std::vector<int> displayData(latticeMaps.size(), -1);
-            writeLatticeMaps(stream, latticeMaps, displayData, displayedLatticeMap);
+            writeLatticeMaps(stream, latticeMaps, displayData, displayedLatticeMap, mapPositions);
         } else {
-            writeLatticeMaps(stream, latticeMaps, perLatticeMap, displayedLatticeMap);
+            writeLatticeMaps(stream, latticeMaps, perLatticeMap, displayedLatticeMap,
+                             mapPositions);
+        }
+        if (mapPositions != nullptr) {
+            addToContents(contents, MapSection::LATTICE_MAPS, -1, latticeMaps, positions, start);
+            positions.clear();
         }
     }
     if (!shapeGraphs.empty()) {
@@ -594,10 +977,15 @@ MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToStream(
                 std::get<1>(dd) = true;
                 std::get<2>(dd) = -1;
             }
-            writeShapeGraphs(stream, shapeGraphs, allLineMapData, displayData, displayedShapeGraph);
+            writeShapeGraphs(stream, shapeGraphs, allLineMapData, displayData, displayedShapeGraph,
+                             mapPositions);
         } else {
             writeShapeGraphs(stream, shapeGraphs, allLineMapData, perShapeGraph,
-                             displayedShapeGraph);
+                             displayedShapeGraph, mapPositions);
+        }
+        if (mapPositions != nullptr) {
+            addToContents(contents, MapSection::SHAPE_GRAPHS, -1, shapeGraphs, positions, start);
+            positions.clear();
         }
     }
     if (!dataMaps.empty()) {
@@ -610,11 +998,18 @@ MetaGraphReadWrite::ReadWriteStatus MetaGraphReadWrite::writeToStream(
                 std::get<1>(dd) = true;
                 std::get<2>(dd) = -1;
             }
-            writeDataMaps(stream, dataMaps, displayData, std::nullopt);
+            writeDataMaps(stream, dataMaps, displayData, std::nullopt, mapPositions);
         } else {
-            writeDataMaps(stream, dataMaps, perDataMap, displayedDataMap);
+            writeDataMaps(stream, dataMaps, perDataMap, displayedDataMap, mapPositions);
+        }
+        if (mapPositions != nullptr) {
+            addToContents(contents, MapSection::DATA_MAPS, -1, dataMaps, positions, start);
+            positions.clear();
         }
     }
+    if (mapPositions != nullptr) {
+        writeTableOfContents(stream, contents, start);
+    }
 
     return ReadWriteStatus::OK;
 }
@@ -85,6 +85,43 @@ namespace MetaGraphReadWrite {
               displayData() {}
     };
 
+    // the sections of a graph file holding maps
+    enum class MapSection { DRAWING_MAPS, LATTICE_MAPS, SHAPE_GRAPHS, DATA_MAPS };
+
+    // where a map is found in a graph file
+    struct MapLocation {
+        std::string name = "";
+        // the position of the map in the stream the table of contents was read from, and its
+        // size, in bytes
+        int64_t offset = 0;
+        int64_t size = 0;
+        MapSection section = MapSection::DATA_MAPS;
+        // the index of the map in its section, or in its drawing file for drawing maps
+        unsigned int index = 0;
+        // the drawing file of a drawing map, -1 for other maps
+        int drawingFile = -1;
+        // the type of a shape map or graph, -1 for lattice maps
+        int mapType = -1;
+    };
+
+    // The maps of a graph file and where to find them, so that they can be listed and read one at
+    // a time. Files may have it written at their end, otherwise it is found by skimming through
+    // the maps without reading them in
+    struct TableOfContents {
+        std::vector<MapLocation> maps;
+        // lattice maps are read with the region of the drawing files
+        Region4f region;
+        int version = 0;
+        // whether the table was written in the file, rather than found by skimming through it
+        bool written = false;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 3 * 8;
+
+      public:
+        TableOfContents() : maps(), region(), version(0), written(false), _padding0(0) {}
+    };
+
     Region4f readRegion(std::istream &stream);
 
     std::tuple<std::vector<std::pair<ShapeMapGroupData, std::vector<ShapeMap>>>,
@@ -95,11 +132,15 @@ namespace MetaGraphReadWrite {
                std::vector<ShapeMapDisplayData>, std::optional<unsigned int>>
     readShapeGraphs(std::istream &stream);
 
+    // the write functions for each kind of map may also give the position in the stream where
+    // each map starts, followed by the position after the last one
+
     template <typename ShapeGraphOrRef>
     bool writeShapeGraphs(std::ostream &stream, const std::vector<ShapeGraphOrRef> &shapeGraphs,
                           const std::optional<AllLine::MapData> &allLineMapData,
                           const std::vector<std::tuple<bool, bool, int>> &perShapeGraph,
-                          const std::optional<unsigned int> &displayedMap);
+                          const std::optional<unsigned int> &displayedMap,
+                          std::vector<std::streampos> *mapPositions = nullptr);
 
     std::tuple<std::vector<ShapeMap>, std::vector<std::tuple<bool, bool, int>>,
                std::optional<unsigned int>>
@@ -109,7 +150,8 @@ namespace MetaGraphReadWrite {
     bool writeDataMaps(
         std::ostream &stream, const std::vector<ShapeMapOrRef> &dataMaps,
         const std::vector<ShapeMapDisplayData> &displayData = std::vector<ShapeMapDisplayData>(),
-        const std::optional<unsigned int> &displayedMap = 0);
+        const std::optional<unsigned int> &displayedMap = 0,
+        std::vector<std::streampos> *mapPositions = nullptr);
 
     std::tuple<std::vector<LatticeMap>, std::vector<int>, std::optional<unsigned int>>
     readLatticeMaps(std::istream &stream, Region4f defaultRegion);
@@ -117,16 +159,29 @@ namespace MetaGraphReadWrite {
     template <typename LatticeMapOrRef>
     bool writeLatticeMaps(std::ostream &stream, const std::vector<LatticeMapOrRef> &latticeMaps,
                           const std::vector<int> &displayData = std::vector<int>(),
-                          const std::optional<unsigned int> &displayedMap = 0);
+                          const std::optional<unsigned int> &displayedMap = 0,
+                          std::vector<std::streampos> *mapPositions = nullptr);
 
     template <typename ShapeMapOrRef>
     bool writeSpacePixels(std::ostream &stream, const std::vector<ShapeMapOrRef> &spacePixels,
-                          const std::vector<std::tuple<bool, bool, int>> &displayData);
+                          const std::vector<std::tuple<bool, bool, int>> &displayData,
+                          std::vector<std::streampos> *mapPositions = nullptr);
     std::streampos skipVirtualMem(std::istream &stream);
 
     MetaGraphData readFromFile(const std::string &filename);
     MetaGraphData readFromStream(std::istream &stream);
 
+    // read the table of contents of the graph starting at the current position of the stream,
+    // throwing if it does not hold a graph that can be read
+    TableOfContents readTableOfContents(std::istream &stream);
+
+    // read a single map from the stream the table of contents was read from
+    LatticeMap readLatticeMap(std::istream &stream, const TableOfContents &contents, size_t index);
+    ShapeGraph readShapeGraph(std::istream &stream, const TableOfContents &contents, size_t index);
+    ShapeMap readDataMap(std::istream &stream, const TableOfContents &contents, size_t index);
+    ShapeMap readDrawingMap(std::istream &stream, const TableOfContents &contents,
+                            size_t drawingFile, size_t index);
+
     ReadWriteStatus writeToFile(const std::string &filename, const MetaGraphData &mgd);
 
     template <typename LatticeMapOrRef, typename ShapeMapOrRef, typename ShapeGraphOrRef>
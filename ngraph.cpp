@@ -149,6 +149,16 @@ std::istream &Node::read(std::istream &stream) {
     return stream;
 }
 
+void Node::skip(std::istream &stream) {
+    for (int i = 0; i < 32; i++) {
+        Bin::skip(stream);
+    }
+
+    for (int i = 0; i < 32; i++) {
+        dXreadwrite::skipVector<PixelRef>(stream);
+    }
+}
+
 std::ostream &Node::write(std::ostream &stream) {
     int i;
     for (i = 0; i < 32; i++) {
@@ -310,6 +320,27 @@ std::istream &Bin::read(std::istream &stream) {
     return stream;
 }
 
+void Bin::skip(std::istream &stream) {
+    int8_t binDir;
+    unsigned short nodeCount;
+    stream.read(reinterpret_cast<char *>(&binDir), sizeof(binDir));
+    stream.read(reinterpret_cast<char *>(&nodeCount), sizeof(nodeCount));
+    stream.seekg(sizeof(m_distance) + sizeof(m_occDistance), std::ios::cur);
+
+    if (nodeCount) {
+        if (binDir & PixelRef::DIAGONAL) {
+            PixelVec::skip(stream);
+        } else {
+            unsigned short length;
+            stream.read(reinterpret_cast<char *>(&length), sizeof(length));
+            PixelVec::skip(stream);
+            for (size_t i = 1; i < length; i++) {
+                PixelVec::skip(stream, true);
+            }
+        }
+    }
+}
+
 std::ostream &Bin::write(std::ostream &stream) {
     stream.write(reinterpret_cast<const char *>(&dir), sizeof(dir));
     stream.write(reinterpret_cast<const char *>(&m_nodeCount), sizeof(m_nodeCount));
@@ -422,6 +453,15 @@ std::istream &PixelVec::read(std::istream &stream, const int8_t dir, const Pixel
     return stream;
 }
 
+void PixelVec::skip(std::istream &stream, bool withContext) {
+    if (withContext) {
+        // only the primary coordinate and the shift and length from the context
+        stream.seekg(sizeof(short) + sizeof(ShiftLength), std::ios::cur);
+    } else {
+        stream.seekg(sizeof(m_start) + sizeof(unsigned short), std::ios::cur);
+    }
+}
+
 std::ostream &PixelVec::write(std::ostream &stream, const int8_t dir, const PixelVec &context) {
     ShiftLength shiftlength;
     shiftlength.runlength = 0;
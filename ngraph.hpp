@@ -22,6 +22,8 @@ struct PixelVec {
     std::istream &read(std::istream &stream, const int8_t dir, const PixelVec &context);
     std::ostream &write(std::ostream &stream, const int8_t dir);
     std::ostream &write(std::ostream &stream, const int8_t dir, const PixelVec &context);
+    // move past what read would read, without reading it in
+    static void skip(std::istream &stream, bool withContext = false);
 
   private:
     PixelRef m_start;
@@ -73,6 +75,7 @@ class Bin {
 
     std::istream &read(std::istream &stream);
     std::ostream &write(std::ostream &stream);
+    static void skip(std::istream &stream);
 
     friend std::ostream &operator<<(std::ostream &stream, const Bin &bin);
 };
@@ -127,6 +130,7 @@ class Node {
     //
     std::istream &read(std::istream &stream);
     std::ostream &write(std::ostream &stream);
+    static void skip(std::istream &stream);
     //
     friend std::ostream &operator<<(std::ostream &stream, const Node &node);
 };
@@ -547,6 +547,15 @@ std::istream &MapInfoData::read(std::istream &stream) {
     return stream;
 }
 
+void MapInfoData::skip(std::istream &stream) {
+    dXstring::skipString(stream); // version
+    dXstring::skipString(stream); // charset
+    stream.get();                 // delimiter
+    dXstring::skipString(stream); // index
+    dXstring::skipString(stream); // coordsys
+    dXstring::skipString(stream); // bounds
+}
+
 std::ostream &MapInfoData::write(std::ostream &stream) const {
     dXstring::writeString(stream, m_version);
     dXstring::writeString(stream, m_charset);
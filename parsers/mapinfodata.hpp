@@ -63,4 +63,5 @@ class MapInfoData {
     //
     std::istream &read(std::istream &stream);
     std::ostream &write(std::ostream &stream) const;
+    static void skip(std::istream &stream);
 };
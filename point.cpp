@@ -32,6 +32,18 @@ std::istream &Point::read(std::istream &stream) {
     return stream;
 }
 
+void Point::skip(std::istream &stream) {
+    stream.seekg(sizeof(m_state) + sizeof(m_block) + sizeof(int) + sizeof(m_gridConnections) +
+                     sizeof(m_merge),
+                 std::ios::cur);
+    bool ngraph = false;
+    stream.read(reinterpret_cast<char *>(&ngraph), sizeof(ngraph));
+    if (ngraph) {
+        Node::skip(stream);
+    }
+    stream.seekg(sizeof(m_location), std::ios::cur);
+}
+
 std::ostream &Point::write(std::ostream &stream) const {
     stream.write(reinterpret_cast<const char *>(&m_state), sizeof(m_state));
     // block is the same size as m_noderef used to be for ease of replacement:
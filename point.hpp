@@ -169,4 +169,6 @@ class Point {
   public:
     std::istream &read(std::istream &stream);
     std::ostream &write(std::ostream &stream) const;
+    // move past what read would read, without reading it in
+    static void skip(std::istream &stream);
 };
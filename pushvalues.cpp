@@ -8,6 +8,288 @@
 
 #include "attributetable.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // lattice points closer than this (in cells) to an edge of a polygon are left to the point in
+    // polygon test of the shape map, as the crossings of the scanline can not tell on which side
+    // of the edge it would find them
+    constexpr double SCANLINE_TOLERANCE = 1e-6;
+
+    // whether the points of the lattice are all at the centres of their cells, which grids read
+    // from elsewhere do not have to be
+    bool isRegularGrid(const LatticeMap &map) {
+        for (const auto &row : map.getAttributeTable()) {
+            PixelRef pix = row.getKey().value;
+            if (!(map.getPoint(pix).getLocation() == map.depixelate(pix))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the first and last rows (or columns) of cells with centres from one coordinate to another,
+    // widened by a cell either side and constrained to the lattice
+    std::pair<int, int> getCellRange(double from, double to, double origin, double spacing,
+                                     size_t cells) {
+        double first = std::max(std::floor((from - origin) / spacing) - 1.0, 0.0);
+        double last = std::min(std::ceil((to - origin) / spacing) + 1.0,
+                               static_cast<double>(cells) - 1.0);
+        if (first > last) {
+            return std::make_pair(0, -1);
+        }
+        return std::make_pair(static_cast<int>(first), static_cast<int>(last));
+    }
+
+    std::pair<int, int> getRowRange(const LatticeMap &lattice, const SalaShape &shape) {
+        const Region4f &region = shape.getBoundingBox();
+        return getCellRange(region.bottomLeft.y, region.topRight.y,
+                            lattice.depixelate(PixelRef(0, 0)).y, lattice.getSpacing(),
+                            lattice.getRows());
+    }
+
+    // whether a coordinate is on the border of two pixels of the shape map, where the point in
+    // polygon test depends on which of the two it is taken to be in
+    bool isOnPixelBorder(double coord, double start, double size, size_t pixels,
+                         double tolerance) {
+        double pixelSize = size / static_cast<double>(pixels);
+        double pos = (coord - start) / pixelSize;
+        return std::fabs(pos - std::round(pos)) * pixelSize <= tolerance;
+    }
+
+    // scanline fill of a closed shape of the map on a row of the lattice: the points inside are
+    // those with an odd number of crossings of the edges of the shape to their left. The point in
+    // polygon test of the map may look along either axis within its pixels, so points next to a
+    // crossing, in line with a vertex or on the border of a pixel of the map, or all the points
+    // across the shape if the row is, or the shape is not a polygon, are given as uncertain, to
+    // be tested by the map
+    void scanRow(const LatticeMap &lattice, const ShapeMap &map, const SalaShape &shape, short y,
+                 std::vector<PixelRef> &inside, std::vector<PixelRef> &uncertain) {
+        inside.clear();
+        uncertain.clear();
+        double tolerance = lattice.getSpacing() * SCANLINE_TOLERANCE;
+        const Region4f &region = shape.getBoundingBox();
+        const Region4f &mapRegion = map.getRegion();
+        Point2f origin = lattice.depixelate(PixelRef(0, y));
+        if (origin.y < region.bottomLeft.y - tolerance ||
+            origin.y > region.topRight.y + tolerance) {
+            return;
+        }
+        bool exact = !shape.isPolygon() ||
+                     isOnPixelBorder(origin.y, mapRegion.bottomLeft.y, mapRegion.height(),
+                                     map.getRows(), tolerance);
+        std::vector<double> crossings;
+        std::vector<double> vertices;
+        const std::vector<Point2f> &points = shape.points;
+        for (size_t k = 0; k < points.size() && !exact; k++) {
+            const Point2f &a = points[k];
+            const Point2f &b = points[(k + 1) % points.size()];
+            if (std::fabs(a.y - origin.y) <= tolerance) {
+                exact = true;
+            } else if ((a.y > origin.y) != (b.y > origin.y)) {
+                crossings.push_back(a.x + (origin.y - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+            vertices.push_back(a.x);
+        }
+        std::sort(crossings.begin(), crossings.end());
+        std::sort(vertices.begin(), vertices.end());
+
+        auto [first, last] = getCellRange(region.bottomLeft.x, region.topRight.x, origin.x,
+                                          lattice.getSpacing(), lattice.getCols());
+        size_t left = 0;     // the crossings to the left of the current point
+        size_t leftVert = 0; // and the vertices
+        for (int x = first; x <= last; x++) {
+            PixelRef pix(static_cast<short>(x), y);
+            double px = lattice.depixelate(pix).x;
+            if (px < region.bottomLeft.x - tolerance || px > region.topRight.x + tolerance) {
+                continue;
+            }
+            while (left < crossings.size() && crossings[left] < px - tolerance) {
+                left++;
+            }
+            while (leftVert < vertices.size() && vertices[leftVert] < px - tolerance) {
+                leftVert++;
+            }
+            if (exact || (left < crossings.size() && crossings[left] <= px + tolerance) ||
+                (leftVert < vertices.size() && vertices[leftVert] <= px + tolerance) ||
+                isOnPixelBorder(px, mapRegion.bottomLeft.x, mapRegion.width(), map.getCols(),
+                                tolerance)) {
+                uncertain.push_back(pix);
+            } else if (left % 2 == 1) {
+                inside.push_back(pix);
+            }
+        }
+    }
+
+    bool isPointInShape(const ShapeMap &map, size_t shapeIdx, const Point2f &p) {
+        auto shapeIndices = map.pointInPolyList(p);
+        return std::binary_search(shapeIndices.begin(), shapeIndices.end(), shapeIdx);
+    }
+
+    // shapeInPolyList for many shapes at once, skipping those not given. The open shapes are
+    // tested in parallel, while the closed ones have to be added to the map to be tested, so are
+    // tested one after the other. If any of them would grow the map, and thus its pixels, all the
+    // shapes are tested in turn as the results of those after it depend on it
+    std::vector<std::vector<size_t>>
+    getShapesInPolyLists(ShapeMap &map, const std::vector<const SalaShape *> &shapes) {
+        std::vector<std::vector<size_t>> gateLists(shapes.size());
+
+        bool growsMap = false;
+        for (const SalaShape *shape : shapes) {
+            if (shape == nullptr || shape->isPoint() || shape->isLine() || shape->isPolyLine() ||
+                !map.getRegion().intersects(shape->getBoundingBox())) {
+                continue;
+            }
+            if (shape->points.size() < 3) {
+                growsMap = true;
+                break;
+            }
+            Region4f region(shape->points[0], shape->points[0]);
+            for (const Point2f &point : shape->points) {
+                region.encompass(point);
+            }
+            if (!map.getRegion().contains_touch(region.bottomLeft) ||
+                !map.getRegion().contains_touch(region.topRight)) {
+                growsMap = true;
+                break;
+            }
+        }
+        if (growsMap) {
+            for (size_t i = 0; i < shapes.size(); i++) {
+                if (shapes[i] != nullptr) {
+                    gateLists[i] = map.shapeInPolyList(*shapes[i]);
+                }
+            }
+            return gateLists;
+        }
+
+        // the pixels of a shape may reach into a cell beyond its region, so shapes with nothing
+        // of the map within two cells of their regions, as found from its shape tree, are skipped
+        double marginX = 2.0 * map.getRegion().width() / static_cast<double>(map.getCols());
+        double marginY = 2.0 * map.getRegion().height() / static_cast<double>(map.getRows());
+        std::vector<Region4f> regions;
+        regions.reserve(shapes.size());
+        for (const SalaShape *shape : shapes) {
+            if (shape == nullptr) {
+                regions.emplace_back();
+                continue;
+            }
+            const Region4f &region = shape->getBoundingBox();
+            regions.emplace_back(
+                Point2f(region.bottomLeft.x - marginX, region.bottomLeft.y - marginY),
+                Point2f(region.topRight.x + marginX, region.topRight.y + marginY));
+        }
+        auto nearShapes = map.getShapeRefsInRegions(regions);
+
+        auto n = static_cast<int>(shapes.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+        for (int i = 0; i < n; i++) {
+            auto idx = static_cast<size_t>(i);
+            const SalaShape *shape = shapes[idx];
+            if (shape != nullptr && !nearShapes[idx].empty() &&
+                (shape->isPoint() || shape->isLine() || shape->isPolyLine())) {
+                gateLists[idx] = map.openShapeInPolyList(*shape);
+            }
+        }
+        for (size_t i = 0; i < shapes.size(); i++) {
+            const SalaShape *shape = shapes[i];
+            if (shape != nullptr && !nearShapes[i].empty() && !shape->isPoint() &&
+                !shape->isLine() && !shape->isPolyLine()) {
+                gateLists[i] = map.shapeInPolyList(*shape);
+            }
+        }
+        return gateLists;
+    }
+
+    // the values of the points of the lattice pushed to the closed shapes of the map they are in,
+    // taking the points in order for each shape
+    void pushPointsToShapes(const LatticeMap &sourceMap, std::optional<size_t> colInIdx,
+                            const ShapeMap &destMap, PushValues::Func pushFunc,
+                            std::vector<double> &vals, std::vector<int> &counts) {
+        auto &tableIn = sourceMap.getAttributeTable();
+        std::vector<const SalaShape *> shapes;
+        shapes.reserve(destMap.getAllShapes().size());
+        for (const auto &shape : destMap.getAllShapes()) {
+            shapes.push_back(&shape.second);
+        }
+
+        if (isRegularGrid(sourceMap)) {
+            // each shape is filled by scanline with the points of the lattice, and so is done
+            // separately
+            auto n = static_cast<int>(shapes.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+            for (int i = 0; i < n; i++) {
+                auto idx = static_cast<size_t>(i);
+                const SalaShape &shape = *shapes[idx];
+                if (!shape.isClosed() ||
+                    !isObjectVisible(destMap.getLayers(),
+                                     destMap.getAttributeRowFromShapeIndex(idx))) {
+                    continue;
+                }
+                std::vector<int> keysIn;
+                std::vector<PixelRef> inside, uncertain;
+                auto [first, last] = getRowRange(sourceMap, shape);
+                for (int y = first; y <= last; y++) {
+                    scanRow(sourceMap, destMap, shape, static_cast<short>(y), inside, uncertain);
+                    keysIn.insert(keysIn.end(), inside.begin(), inside.end());
+                    for (PixelRef pix : uncertain) {
+                        if (isPointInShape(destMap, idx, sourceMap.getPoint(pix).getLocation())) {
+                            keysIn.push_back(pix);
+                        }
+                    }
+                }
+                std::sort(keysIn.begin(), keysIn.end());
+                for (int keyIn : keysIn) {
+                    const AttributeRow *rowIn = tableIn.getRowPtr(AttributeKey(keyIn));
+                    if (rowIn == nullptr || !isObjectVisible(sourceMap.getLayers(), *rowIn)) {
+                        continue;
+                    }
+                    double thisval = keyIn;
+                    if (colInIdx.has_value())
+                        thisval = rowIn->getValue(colInIdx.value());
+                    PushValues::pushValue(vals[idx], counts[idx], thisval, pushFunc);
+                }
+            }
+            return;
+        }
+
+        // otherwise each point is looked up in the map
+        std::vector<const AttributeRow *> rowsIn;
+        std::vector<int> keysIn;
+        for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++) {
+            if (isObjectVisible(sourceMap.getLayers(), iterIn->getRow())) {
+                rowsIn.push_back(&iterIn->getRow());
+                keysIn.push_back(iterIn->getKey().value);
+            }
+        }
+        std::vector<std::vector<size_t>> gateLists(keysIn.size());
+        auto n = static_cast<int>(keysIn.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+        for (int i = 0; i < n; i++) {
+            auto idx = static_cast<size_t>(i);
+            gateLists[idx] = destMap.pointInPolyList(sourceMap.getPoint(keysIn[idx]).getLocation());
+        }
+        for (size_t i = 0; i < keysIn.size(); i++) {
+            double thisval = keysIn[i];
+            if (colInIdx.has_value())
+                thisval = rowsIn[i]->getValue(colInIdx.value());
+            for (auto gate : gateLists[i]) {
+                if (isObjectVisible(destMap.getLayers(),
+                                    destMap.getAttributeRowFromShapeIndex(gate))) {
+                    PushValues::pushValue(vals[gate], counts[gate], thisval, pushFunc);
+                }
+            }
+        }
+    }
+} // namespace
+
 void PushValues::pushValue(double &val, int &count, double thisval, Func pushFunc) {
     if (thisval != -1) {
         switch (pushFunc) {
@@ -99,82 +381,125 @@ void PushValues::shapeToPoint(const ShapeMap &sourceMap, const std::string &colI
     // with lines). Thus, in this case a composite approach is implemented,
     // which takes both options from the other parts of this conditional.
 
-    struct ValueCountRow {
-        double value = -1;
-        AttributeRow &row;
-        int count = 0;
-
-      private:
-        [[maybe_unused]] unsigned _padding0 : 4 * 8;
-
-      public:
-        ValueCountRow(AttributeRow &rowIn) : row(rowIn), _padding0(0) {}
+    // prepare a temporary value grid to store counts and values
+    size_t cols = destMap.getCols();
+    std::vector<double> vals(cols * destMap.getRows(), -1);
+    std::vector<int> counts(cols * destMap.getRows(), 0); // count set to zero for all
+    auto cell = [cols](PixelRef pix) {
+        return static_cast<size_t>(pix.y) * cols + static_cast<size_t>(pix.x);
     };
 
-    // prepare a temporary value table to store counts and values
-    std::map<AttributeKey, ValueCountRow> valCounts;
+    std::vector<const SalaShape *> shapes;
+    shapes.reserve(sourceMap.getAllShapes().size());
+    for (auto &shape : sourceMap.getAllShapes()) {
+        shapes.push_back(&shape.second);
+    }
+    auto n = static_cast<int>(shapes.size());
+
+    // first collect the lines by pixelating them using the vga map, all at
+    // once, and push their values in the order of the shapes
+    std::vector<PixelRefVector> shapePixels(shapes.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        auto idx = static_cast<size_t>(i);
+        const SalaShape &shape = *shapes[idx];
+        PixelRefVector &pixels = shapePixels[idx];
+        if (shape.isLine()) {
+            pixels = destMap.pixelateLine(shape.getLine());
+        } else if (shape.isPolyLine()) {
+            for (size_t j = 1; j < shape.points.size(); j++) {
+                Line4f li(shape.points[j - 1], shape.points[j]);
+                PixelRefVector linePixels = destMap.pixelateLine(li);
+                pixels.insert(pixels.end(), linePixels.begin(), linePixels.end());
+            }
+            std::sort(pixels.begin(), pixels.end());
+            pixels.erase(std::unique(pixels.begin(), pixels.end()), pixels.end());
+        }
+    }
+    for (size_t i = 0; i < shapes.size(); i++) {
+        float thisval = sourceMap.getAttributeRowFromShapeIndex(i).getValue(colInIdx);
+        for (const PixelRef &pix : shapePixels[i]) {
+            if (!destMap.getPoint(pix).filled())
+                continue;
+            pushValue(vals[cell(pix)], counts[cell(pix)], thisval, pushFunc);
+        }
+    }
 
-    for (auto &row : tableOut) {
-        valCounts.insert(std::make_pair(row.getKey(),
-                                        ValueCountRow(row.getRow()))); // count set to zero for all
-    }
-
-    // first collect the lines by pixelating them using the vga map
-    auto &shapeMap = sourceMap.getAllShapes();
-    for (auto &shape : shapeMap) {
-        float thisval = tableIn.getRow(AttributeKey(shape.first)).getValue(colInIdx);
-        if (shape.second.isLine()) {
-            PixelRefVector linePixels = destMap.pixelateLine(shape.second.getLine());
-            for (const PixelRef &pix : linePixels) {
-                if (!destMap.getPoint(pix).filled())
-                    continue;
-                auto valCount = valCounts.find(AttributeKey(pix));
-                if (valCount != valCounts.end()) {
-                    pushValue(valCount->second.value, valCount->second.count, thisval, pushFunc);
+    // then collect the polygons and push to vga map
+    if (isRegularGrid(destMap)) {
+        // the polygons are filled into the grid a row at a time, by scanline,
+        // each row taking the polygons on it in the order of the shapes
+        std::vector<std::vector<size_t>> rowShapes(destMap.getRows());
+        for (size_t i = 0; i < shapes.size(); i++) {
+            if (!shapes[i]->isClosed() ||
+                !isObjectVisible(sourceMap.getLayers(), sourceMap.getAttributeRowFromShapeIndex(i)))
+                continue;
+            auto [first, last] = getRowRange(destMap, *shapes[i]);
+            for (int y = first; y <= last; y++) {
+                rowShapes[static_cast<size_t>(y)].push_back(i);
+            }
+        }
+        auto rows = static_cast<int>(destMap.getRows());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+        for (int y = 0; y < rows; y++) {
+            std::vector<PixelRef> inside, uncertain;
+            for (size_t shapeIdx : rowShapes[static_cast<size_t>(y)]) {
+                double thisval =
+                    sourceMap.getAttributeRowFromShapeIndex(shapeIdx).getValue(colInIdx);
+                scanRow(destMap, sourceMap, *shapes[shapeIdx], static_cast<short>(y), inside,
+                        uncertain);
+                for (const PixelRef &pix : inside) {
+                    pushValue(vals[cell(pix)], counts[cell(pix)], thisval, pushFunc);
+                }
+                for (const PixelRef &pix : uncertain) {
+                    if (isPointInShape(sourceMap, shapeIdx, destMap.getPoint(pix).getLocation())) {
+                        pushValue(vals[cell(pix)], counts[cell(pix)], thisval, pushFunc);
+                    }
                 }
             }
-        } else if (shape.second.isPolyLine()) {
-            std::set<PixelRef> polylinePixels;
-            for (size_t i = 1; i < shape.second.points.size(); i++) {
-                Line4f li(shape.second.points[i - 1], shape.second.points[i]);
-                PixelRefVector linePixels = destMap.pixelateLine(li);
-                polylinePixels.insert(linePixels.begin(), linePixels.end());
+        }
+    } else {
+        // otherwise each point is looked up in the shape map
+        std::vector<PixelRef> pixelsOut;
+        for (auto &row : tableOut) {
+            if (isObjectVisible(destMap.getLayers(), row.getRow())) {
+                pixelsOut.push_back(row.getKey().value);
             }
-            for (const PixelRef &pix : polylinePixels) {
-                if (!destMap.getPoint(pix).filled())
-                    continue;
-                auto valCount = valCounts.find(AttributeKey(pix));
-                if (valCount != valCounts.end()) {
-                    pushValue(valCount->second.value, valCount->second.count, thisval, pushFunc);
+        }
+        auto m = static_cast<int>(pixelsOut.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+        for (int i = 0; i < m; i++) {
+            PixelRef pix = pixelsOut[static_cast<size_t>(i)];
+            auto gatelist = sourceMap.pointInPolyList(destMap.getPoint(pix).getLocation());
+            for (auto gate : gatelist) {
+                auto &rowIn = sourceMap.getAttributeRowFromShapeIndex(gate);
+                if (isObjectVisible(sourceMap.getLayers(), rowIn)) {
+                    double thisval = rowIn.getValue(colInIdx);
+                    pushValue(vals[cell(pix)], counts[cell(pix)], thisval, pushFunc);
                 }
             }
         }
     }
 
-    // then collect the polygons and push to vga map
-    for (auto &valCount : valCounts) {
-        int keyOut = valCount.first.value;
-        double &val = valCount.second.value;
-        int &count = valCount.second.count;
-        AttributeRow &row = valCount.second.row;
-        std::vector<size_t> gatelist;
-        if (!isObjectVisible(destMap.getLayers(), row)) {
+    for (auto &row : tableOut) {
+        if (!isObjectVisible(destMap.getLayers(), row.getRow())) {
             continue;
         }
-        gatelist = sourceMap.pointInPolyList(destMap.getPoint(keyOut).getLocation());
-        for (auto gate : gatelist) {
-            auto &rowIn = sourceMap.getAttributeRowFromShapeIndex(gate);
-            if (isObjectVisible(sourceMap.getLayers(), rowIn)) {
-                double thisval = rowIn.getValue(colInIdx);
-                pushValue(val, count, thisval, pushFunc);
-            }
-        }
+        size_t idx = cell(row.getKey().value);
+        double val = vals[idx];
+        int count = counts[idx];
         if (pushFunc == Func::AVG && val != -1.0) {
             val /= static_cast<double>(count);
         }
-        row.setValue(colOutIdx, static_cast<float>(val));
+        row.getRow().setValue(colOutIdx, static_cast<float>(val));
         if (countColIdx.has_value()) {
-            row.setValue(countColIdx.value(), static_cast<float>(count));
+            row.getRow().setValue(countColIdx.value(), static_cast<float>(count));
         }
     }
 }
@@ -189,18 +514,25 @@ void PushValues::shapeToAxial(ShapeMap &sourceMap, const std::optional<const std
     auto [colInIdx, colOutIdx, countColIdx] =
         getColumnIndices(tableIn, colIn, tableOut, colOut, countCol);
 
+    const auto &shapeMap = destMap.getAllShapes();
+    std::vector<const SalaShape *> shapesOut;
     for (auto iterOut = tableOut.begin(); iterOut != tableOut.end(); iterOut++) {
-        int keyOut = iterOut->getKey().value;
-        std::vector<size_t> gatelist;
         if (!isObjectVisible(destMap.getLayers(), iterOut->getRow())) {
+            shapesOut.push_back(nullptr);
             continue;
         }
-        auto shapeMap = destMap.getAllShapes();
-        gatelist = sourceMap.shapeInPolyList(shapeMap[keyOut]);
+        shapesOut.push_back(&shapeMap.at(iterOut->getKey().value));
+    }
+    auto gatelists = getShapesInPolyLists(sourceMap, shapesOut);
 
+    size_t i = 0;
+    for (auto iterOut = tableOut.begin(); iterOut != tableOut.end(); iterOut++, i++) {
+        if (shapesOut[i] == nullptr) {
+            continue;
+        }
         double val = -1.0;
         int count = 0;
-        for (auto gate : gatelist) {
+        for (auto gate : gatelists[i]) {
             auto &rowIn = sourceMap.getAttributeRowFromShapeIndex(gate);
 
             if (isObjectVisible(sourceMap.getLayers(), rowIn)) {
@@ -229,19 +561,25 @@ void PushValues::shapeToShape(ShapeMap &sourceMap, const std::optional<const std
     auto [colInIdx, colOutIdx, countColIdx] =
         getColumnIndices(tableIn, colIn, tableOut, colOut, countCol);
 
+    const auto &dataMap = destMap.getAllShapes();
+    std::vector<const SalaShape *> shapesOut;
     for (auto iterOut = tableOut.begin(); iterOut != tableOut.end(); iterOut++) {
-        int keyOut = iterOut->getKey().value;
-        std::vector<size_t> gatelist;
-
         if (!isObjectVisible(destMap.getLayers(), iterOut->getRow())) {
+            shapesOut.push_back(nullptr);
             continue;
         }
-        auto dataMap = destMap.getAllShapes();
-        gatelist = sourceMap.shapeInPolyList(dataMap[keyOut]);
+        shapesOut.push_back(&dataMap.at(iterOut->getKey().value));
+    }
+    auto gatelists = getShapesInPolyLists(sourceMap, shapesOut);
 
+    size_t i = 0;
+    for (auto iterOut = tableOut.begin(); iterOut != tableOut.end(); iterOut++, i++) {
+        if (shapesOut[i] == nullptr) {
+            continue;
+        }
         double val = -1.0;
         int count = 0;
-        for (auto gate : gatelist) {
+        for (auto gate : gatelists[i]) {
             auto &rowIn = sourceMap.getAttributeRowFromShapeIndex(gate);
 
             if (isObjectVisible(sourceMap.getLayers(), rowIn)) {
@@ -281,25 +619,8 @@ void PushValues::pointToShape(const LatticeMap &sourceMap,
         vals[i] = -1;
     }
 
-    for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++) {
-        int pixIn = iterIn->getKey().value;
-        if (!isObjectVisible(sourceMap.getLayers(), iterIn->getRow())) {
-            continue;
-        }
-        std::vector<size_t> gatelist;
-        gatelist = destMap.pointInPolyList(sourceMap.getPoint(pixIn).getLocation());
-        double thisval = iterIn->getKey().value;
-        if (colInIdx.has_value())
-            thisval = iterIn->getRow().getValue(colInIdx.value());
-        for (auto gate : gatelist) {
-            AttributeRow &rowOut = destMap.getAttributeRowFromShapeIndex(gate);
-            if (isObjectVisible(destMap.getLayers(), rowOut)) {
-                double &val = vals[gate];
-                int &count = counts[gate];
-                pushValue(val, count, thisval, pushFunc);
-            }
-        }
-    }
+    pushPointsToShapes(sourceMap, colInIdx, destMap, pushFunc, vals, counts);
+
     size_t i = 0;
     for (auto iter = tableOut.begin(); iter != tableOut.end(); iter++) {
 
@@ -338,28 +659,10 @@ void PushValues::pointToAxial(const LatticeMap &sourceMap,
         vals[i] = -1;
     }
 
-    for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++) {
-        int pixIn = iterIn->getKey().value;
-        if (!isObjectVisible(sourceMap.getLayers(), iterIn->getRow())) {
-            continue;
-        }
-        std::vector<size_t> gatelist;
-        // note, "axial" could be convex map, and hence this would be a valid
-        // operation
-        gatelist = destMap.pointInPolyList(sourceMap.getPoint(pixIn).getLocation());
-        double thisval = iterIn->getKey().value;
-        if (colInIdx.has_value())
-            thisval = iterIn->getRow().getValue(colInIdx.value());
-        for (auto gate : gatelist) {
-            int keyOut = destMap.getShapeRefFromIndex(gate)->first;
-            AttributeRow &rowOut = tableOut.getRow(AttributeKey(keyOut));
-            if (isObjectVisible(destMap.getLayers(), rowOut)) {
-                double &val = vals[gate];
-                int &count = counts[gate];
-                pushValue(val, count, thisval, pushFunc);
-            }
-        }
-    }
+    // note, "axial" could be convex map, and hence this would be a valid
+    // operation
+    pushPointsToShapes(sourceMap, colInIdx, destMap, pushFunc, vals, counts);
+
     size_t i = 0;
     for (auto iter = tableOut.begin(); iter != tableOut.end(); iter++) {
 
@@ -399,18 +702,26 @@ void PushValues::axialToShape(const ShapeGraph &sourceMap,
     }
     // note, in the spirit of mapping fewer objects in the gate list, it is
     // *usually* best to perform axial -> gate map in this direction
+    const auto &dataMap = sourceMap.getAllShapes();
+    std::vector<const SalaShape *> shapesIn;
     for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++) {
-        int keyIn = iterIn->getKey().value;
         if (!isObjectVisible(sourceMap.getLayers(), iterIn->getRow())) {
+            shapesIn.push_back(nullptr);
+            continue;
+        }
+        shapesIn.push_back(&dataMap.at(iterIn->getKey().value));
+    }
+    auto gatelists = getShapesInPolyLists(destMap, shapesIn);
+
+    size_t j = 0;
+    for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++, j++) {
+        if (shapesIn[j] == nullptr) {
             continue;
         }
-        std::vector<size_t> gatelist;
-        auto dataMap = sourceMap.getAllShapes();
-        gatelist = destMap.shapeInPolyList(dataMap[keyIn]);
         double thisval = iterIn->getKey().value;
         if (colInIdx.has_value())
             thisval = iterIn->getRow().getValue(colInIdx.value());
-        for (auto gate : gatelist) {
+        for (auto gate : gatelists[j]) {
             int keyOut = destMap.getShapeRefFromIndex(gate)->first;
             AttributeRow &rowOut = tableOut.getRow(AttributeKey(keyOut));
             if (isObjectVisible(destMap.getLayers(), rowOut)) {
@@ -458,18 +769,26 @@ void PushValues::axialToAxial(const ShapeGraph &sourceMap,
     }
     // note, in the spirit of mapping fewer objects in the gate list, it is
     // *usually* best to perform axial -> gate map in this direction
+    const auto &shapeMap = sourceMap.getAllShapes();
+    std::vector<const SalaShape *> shapesIn;
     for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++) {
-        int keyIn = iterIn->getKey().value;
         if (!isObjectVisible(sourceMap.getLayers(), iterIn->getRow())) {
+            shapesIn.push_back(nullptr);
+            continue;
+        }
+        shapesIn.push_back(&shapeMap.at(iterIn->getKey().value));
+    }
+    auto gatelists = getShapesInPolyLists(destMap, shapesIn);
+
+    size_t j = 0;
+    for (auto iterIn = tableIn.begin(); iterIn != tableIn.end(); iterIn++, j++) {
+        if (shapesIn[j] == nullptr) {
             continue;
         }
-        std::vector<size_t> gatelist;
-        auto shapeMap = sourceMap.getAllShapes();
-        gatelist = destMap.shapeInPolyList(shapeMap[keyIn]);
         double thisval = iterIn->getKey().value;
         if (colInIdx.has_value())
             thisval = iterIn->getRow().getValue(colInIdx.value());
-        for (auto gate : gatelist) {
+        for (auto gate : gatelists[j]) {
             int keyOut = destMap.getShapeRefFromIndex(gate)->first;
             AttributeRow &rowOut = tableOut.getRow(AttributeKey(keyOut));
             if (isObjectVisible(destMap.getLayers(), rowOut)) {
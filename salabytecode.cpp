@@ -0,0 +1,479 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "salabytecode.hpp"
+
+#include "genlib/pafmath.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+std::optional<SalaBytecode> SalaBytecode::compile(const SalaProgram &program,
+                                                  const AttributeTable &table) {
+    // only a program of a single expression, which is then the result
+    const SalaCommand &root = program.m_rootCommand;
+    if (root.m_children.size() != 1) {
+        return std::nullopt;
+    }
+    const SalaCommand &command = root.m_children.front();
+    if ((command.m_command != SalaCommand::SC_EXPR &&
+         command.m_command != SalaCommand::SC_RETURN) ||
+        !command.m_children.empty()) {
+        return std::nullopt;
+    }
+    SalaBytecode bytecode(program, table);
+    int pointer = static_cast<int>(command.m_evalStack.size()) - 1;
+    auto result = bytecode.compile(command.m_evalStack, pointer, true);
+    if (!result.has_value()) {
+        return std::nullopt;
+    }
+    bytecode.m_result = result->reg;
+    return bytecode;
+}
+
+// follows SalaCommand::evaluate, taking the operands off the evaluation stack in the same order
+std::optional<SalaBytecode::Operand>
+SalaBytecode::compile(const std::vector<SalaObj> &evalStack, int &pointer, bool isRoot) {
+    if (pointer < 0) {
+        return std::nullopt;
+    }
+    const SalaObj &data = evalStack[static_cast<size_t>(pointer)];
+    pointer--;
+    switch (data.m_type) {
+    case SalaObj::S_BOOL:
+        return add(OP_CONST, VT_BOOL, 0, 0, data.m_data.b ? 1.0 : 0.0);
+    case SalaObj::S_INT:
+        return add(OP_CONST, VT_INT, 0, 0, static_cast<double>(data.m_data.i));
+    case SalaObj::S_DOUBLE:
+        return add(OP_CONST, VT_DOUBLE, 0, 0, data.m_data.f);
+    case SalaObj::S_FUNCTION:
+        break;
+    default:
+        return std::nullopt;
+    }
+    SalaObj::Func func = data.m_data.func;
+    int group = static_cast<int>(func & SalaObj::S_GROUP);
+    if (group == SalaObj::S_MATH_OPS) {
+        return compileMath(func, evalStack, pointer);
+    } else if (group == SalaObj::S_LOGICAL_OPS) {
+        return compileLogical(func, evalStack, pointer, isRoot);
+    } else if (group == SalaObj::S_GLOBAL_FUNCS) {
+        Op op;
+        switch (func) {
+        case SalaObj::S_SQRT:
+            op = OP_SQRT;
+            break;
+        case SalaObj::S_LOG:
+            op = OP_LOG;
+            break;
+        case SalaObj::S_LN:
+            op = OP_LN;
+            break;
+        case SalaObj::S_SIN:
+            op = OP_SIN;
+            break;
+        case SalaObj::S_COS:
+            op = OP_COS;
+            break;
+        case SalaObj::S_TAN:
+            op = OP_TAN;
+            break;
+        case SalaObj::S_ASIN:
+            op = OP_ASIN;
+            break;
+        case SalaObj::S_ACOS:
+            op = OP_ACOS;
+            break;
+        case SalaObj::S_ATAN:
+            op = OP_ATAN;
+            break;
+        default:
+            // random, len and range
+            return std::nullopt;
+        }
+        auto operand = compile(evalStack, pointer, false);
+        if (!operand.has_value()) {
+            return std::nullopt;
+        }
+        return add(op, VT_DOUBLE, operand->reg);
+    } else if (group == SalaObj::S_MEMBER_FUNCS && func == SalaObj::S_FVALUE) {
+        return compileValue(evalStack, pointer);
+    }
+    return std::nullopt;
+}
+
+std::optional<SalaBytecode::Operand>
+SalaBytecode::compileMath(SalaObj::Func func, const std::vector<SalaObj> &evalStack,
+                          int &pointer) {
+    switch (func) {
+    case SalaObj::S_PLUS:
+        return compile(evalStack, pointer, false);
+    case SalaObj::S_MINUS: {
+        auto operand = compile(evalStack, pointer, false);
+        if (!operand.has_value() || operand->type == VT_BOOL) {
+            return std::nullopt;
+        }
+        return add(operand->type == VT_INT ? OP_INT_MINUS : OP_MINUS, operand->type,
+                   operand->reg);
+    }
+    case SalaObj::S_POWER: {
+        auto exponent = compile(evalStack, pointer, false);
+        auto base = compile(evalStack, pointer, false);
+        if (!exponent.has_value() || !base.has_value()) {
+            return std::nullopt;
+        }
+        return add(OP_POWER, VT_DOUBLE, base->reg, exponent->reg);
+    }
+    case SalaObj::S_ADD:
+    case SalaObj::S_SUBTRACT:
+    case SalaObj::S_MULTIPLY:
+    case SalaObj::S_DIVIDE:
+    case SalaObj::S_MODULO:
+        break;
+    default:
+        // assignment and list access
+        return std::nullopt;
+    }
+    // the first operand off the stack is the one written last
+    auto first = compile(evalStack, pointer, false);
+    auto second = compile(evalStack, pointer, false);
+    if (!first.has_value() || !second.has_value() || first->type == VT_BOOL ||
+        second->type == VT_BOOL) {
+        return std::nullopt;
+    }
+    bool integer = first->type == VT_INT && second->type == VT_INT;
+    ValueType type = integer ? VT_INT : VT_DOUBLE;
+    // the operands are applied as SalaCommand applies them
+    switch (func) {
+    case SalaObj::S_ADD:
+        return add(integer ? OP_INT_ADD : OP_ADD, type, first->reg, second->reg);
+    case SalaObj::S_SUBTRACT:
+        return add(integer ? OP_INT_SUBTRACT : OP_SUBTRACT, type, first->reg, second->reg);
+    case SalaObj::S_MULTIPLY:
+        return add(integer ? OP_INT_MULTIPLY : OP_MULTIPLY, type, first->reg, second->reg);
+    case SalaObj::S_DIVIDE:
+        return add(integer ? OP_INT_DIVIDE : OP_DIVIDE, type, second->reg, first->reg);
+    default:
+        return add(integer ? OP_INT_MODULO : OP_MODULO, type, second->reg, first->reg);
+    }
+}
+
+std::optional<SalaBytecode::Operand>
+SalaBytecode::compileLogical(SalaObj::Func func, const std::vector<SalaObj> &evalStack,
+                             int &pointer, bool isRoot) {
+    if (func == SalaObj::S_NOT) {
+        auto operand = compile(evalStack, pointer, false);
+        if (!operand.has_value()) {
+            return std::nullopt;
+        }
+        return add(OP_NOT, VT_BOOL, operand->reg);
+    }
+    // SalaCommand only takes the second operand of 'and' off the stack if the first is true,
+    // so whatever comes after depends on the values. At the top of the expression nothing does
+    if (func == SalaObj::S_AND && !isRoot) {
+        return std::nullopt;
+    }
+    Op op;
+    switch (func) {
+    case SalaObj::S_AND:
+        op = OP_AND;
+        break;
+    case SalaObj::S_OR:
+        op = OP_OR;
+        break;
+    case SalaObj::S_EQ:
+        op = OP_EQ;
+        break;
+    case SalaObj::S_NEQ:
+        op = OP_NEQ;
+        break;
+    case SalaObj::S_LT:
+        op = OP_LT;
+        break;
+    case SalaObj::S_GT:
+        op = OP_GT;
+        break;
+    case SalaObj::S_LEQ:
+        op = OP_LEQ;
+        break;
+    case SalaObj::S_GEQ:
+        op = OP_GEQ;
+        break;
+    default:
+        // 'is' compares the objects rather than the values
+        return std::nullopt;
+    }
+    auto first = compile(evalStack, pointer, false);
+    auto second = compile(evalStack, pointer, false);
+    if (!first.has_value() || !second.has_value()) {
+        return std::nullopt;
+    }
+    if (op == OP_AND || op == OP_OR) {
+        return add(op, VT_BOOL, first->reg, second->reg);
+    }
+    // booleans may only be compared with booleans
+    if ((first->type == VT_BOOL) != (second->type == VT_BOOL)) {
+        return std::nullopt;
+    }
+    return add(op, VT_BOOL, second->reg, first->reg);
+}
+
+// value("column") of this row, the column named by a constant
+std::optional<SalaBytecode::Operand>
+SalaBytecode::compileValue(const std::vector<SalaObj> &evalStack, int &pointer) {
+    SalaObj::Type contextType = m_program->m_thisobj.m_type;
+    if (pointer < 1 || (contextType != SalaObj::S_SHAPEMAPOBJ &&
+                        contextType != SalaObj::S_LATTICEMAPOBJ)) {
+        return std::nullopt;
+    }
+    const SalaObj &param = evalStack[static_cast<size_t>(pointer)];
+    const SalaObj &obj = evalStack[static_cast<size_t>(pointer - 1)];
+    if (param.m_type != SalaObj::S_STRING || obj.m_type != SalaObj::S_THIS) {
+        return std::nullopt;
+    }
+    pointer -= 2;
+    const std::string &name = *param.m_data.str.string;
+    if (name == "Ref Number") {
+        return add(OP_KEY, VT_INT);
+    }
+    auto colIndex = m_table->getColumnIndexOptional(name);
+    if (!colIndex.has_value()) {
+        return std::nullopt;
+    }
+    return add(OP_COLUMN, VT_DOUBLE, 0, 0, 0.0, *colIndex);
+}
+
+SalaBytecode::Operand SalaBytecode::add(Op op, ValueType type, size_t lhs, size_t rhs,
+                                        double constant, size_t column) {
+    m_instructions.push_back(Instruction(op, type, lhs, rhs, constant, column));
+    return Operand(m_instructions.size() - 1, type);
+}
+
+void SalaBytecode::run(const std::vector<int> &keys, const std::vector<size_t> &rowIndices,
+                       std::vector<double> &results, std::vector<char> &failed) const {
+    size_t count = keys.size();
+    results.assign(count, 0.0);
+    failed.assign(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        if (rowIndices[i] == static_cast<size_t>(-1)) {
+            failed[i] = 1;
+        }
+    }
+    std::vector<double> constRegisters(m_instructions.size() * BLOCK_SIZE);
+    // constants are the same for every block, so their registers are only filled once
+    for (size_t idx = 0; idx < m_instructions.size(); idx++) {
+        if (m_instructions[idx].op == OP_CONST) {
+            auto regStart =
+                constRegisters.begin() + static_cast<std::ptrdiff_t>(idx * BLOCK_SIZE);
+            std::fill(regStart, regStart + BLOCK_SIZE, m_instructions[idx].constant);
+        }
+    }
+    // the blocks share nothing but the table being read, so they are run in parallel
+    auto blockCount = static_cast<int>((count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+#if defined(_OPENMP)
+#pragma omp parallel default(shared) if (count >= PARALLEL_THRESHOLD)
+#endif
+    {
+        std::vector<double> registers = constRegisters;
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+        for (int block = 0; block < blockCount; block++) {
+            size_t start = static_cast<size_t>(block) * BLOCK_SIZE;
+            runBlock(&keys[start], &rowIndices[start], std::min(BLOCK_SIZE, count - start),
+                     registers, &results[start], &failed[start]);
+        }
+    }
+}
+
+void SalaBytecode::runBlock(const int *keys, const size_t *rowIndices, size_t count,
+                            std::vector<double> &registers, double *results,
+                            char *failed) const {
+    for (size_t idx = 0; idx < m_instructions.size(); idx++) {
+        const Instruction &instruction = m_instructions[idx];
+        double *out = &registers[idx * BLOCK_SIZE];
+        const double *lhs = &registers[instruction.lhs * BLOCK_SIZE];
+        const double *rhs = &registers[instruction.rhs * BLOCK_SIZE];
+        switch (instruction.op) {
+        case OP_CONST:
+            break;
+        case OP_COLUMN: {
+            const std::vector<float> &values = m_table->getColumnValues(instruction.column);
+            for (size_t i = 0; i < count; i++) {
+                out[i] = rowIndices[i] == static_cast<size_t>(-1)
+                             ? 0.0
+                             : static_cast<double>(values[rowIndices[i]]);
+            }
+        } break;
+        case OP_KEY:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<double>(keys[i]);
+            }
+            break;
+        case OP_ADD:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] + rhs[i];
+            }
+            break;
+        case OP_SUBTRACT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] - rhs[i];
+            }
+            break;
+        case OP_MULTIPLY:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] * rhs[i];
+            }
+            break;
+        case OP_DIVIDE:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] / rhs[i];
+            }
+            break;
+        case OP_MODULO:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = std::fmod(lhs[i], rhs[i]);
+            }
+            break;
+        case OP_MINUS:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = -lhs[i];
+            }
+            break;
+        case OP_INT_ADD:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<double>(static_cast<int>(lhs[i]) + static_cast<int>(rhs[i]));
+            }
+            break;
+        case OP_INT_SUBTRACT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<double>(static_cast<int>(lhs[i]) - static_cast<int>(rhs[i]));
+            }
+            break;
+        case OP_INT_MULTIPLY:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<double>(static_cast<int>(lhs[i]) * static_cast<int>(rhs[i]));
+            }
+            break;
+        case OP_INT_DIVIDE:
+        case OP_INT_MODULO:
+            for (size_t i = 0; i < count; i++) {
+                int divisor = static_cast<int>(rhs[i]);
+                if (divisor == 0) {
+                    // an error for SalaProgram to report
+                    failed[i] = 1;
+                    out[i] = 0.0;
+                } else {
+                    int dividend = static_cast<int>(lhs[i]);
+                    out[i] = static_cast<double>(instruction.op == OP_INT_DIVIDE
+                                                     ? dividend / divisor
+                                                     : dividend % divisor);
+                }
+            }
+            break;
+        case OP_INT_MINUS:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<double>(-static_cast<int>(lhs[i]));
+            }
+            break;
+        case OP_POWER:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = pow(lhs[i], rhs[i]);
+            }
+            break;
+        case OP_SQRT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = sqrt(lhs[i]);
+            }
+            break;
+        case OP_LOG:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = log10(lhs[i]);
+            }
+            break;
+        case OP_LN:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = pafmath::ln(lhs[i]);
+            }
+            break;
+        case OP_SIN:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = sin(lhs[i]);
+            }
+            break;
+        case OP_COS:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = cos(lhs[i]);
+            }
+            break;
+        case OP_TAN:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = tan(lhs[i]);
+            }
+            break;
+        case OP_ASIN:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = asin(lhs[i]);
+            }
+            break;
+        case OP_ACOS:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = acos(lhs[i]);
+            }
+            break;
+        case OP_ATAN:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = atan(lhs[i]);
+            }
+            break;
+        case OP_LT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] < rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_GT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] > rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_LEQ:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] <= rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_GEQ:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] >= rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_EQ:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] == rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_NEQ:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] != rhs[i] ? 1.0 : 0.0;
+            }
+            break;
+        case OP_AND:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] != 0.0 && rhs[i] != 0.0 ? 1.0 : 0.0;
+            }
+            break;
+        case OP_OR:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] != 0.0 || rhs[i] != 0.0 ? 1.0 : 0.0;
+            }
+            break;
+        case OP_NOT:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = lhs[i] != 0.0 ? 0.0 : 1.0;
+            }
+            break;
+        }
+    }
+    std::copy(&registers[m_result * BLOCK_SIZE], &registers[m_result * BLOCK_SIZE] + count,
+              results);
+}
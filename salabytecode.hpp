@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// SalaScripting language, compiled to run over whole columns
+
+#pragma once
+
+#include "salaprogram.hpp"
+
+#include <optional>
+#include <vector>
+
+///
+/// A SalaScript program made of a single arithmetic expression over the values of the current
+/// row, compiled to a list of register instructions. Rather than walking the commands of the
+/// program once for each row, each instruction is run over a block of rows at a time, reading the
+/// values straight from the columns of the table. Programs using anything else (variables,
+/// strings, lists, loops, or graph functions such as connections) are not compiled, and are left
+/// for SalaProgram to run
+///
+class SalaBytecode {
+  public:
+    // the number of rows each instruction is run over at a time
+    static constexpr size_t BLOCK_SIZE = 256;
+    // the number of rows from which the blocks are run on several threads
+    static constexpr size_t PARALLEL_THRESHOLD = 1 << 14;
+
+    SalaBytecode(const SalaBytecode &) = default;
+    SalaBytecode &operator=(const SalaBytecode &) = default;
+
+    ///
+    /// \brief Compile a parsed program for the table of its context
+    /// The expression is compiled in the order SalaCommand would evaluate it, with the same types,
+    /// so that the results are the same
+    /// \return the compiled program, or nothing if the program can not be compiled, including if
+    /// it would fail with an error whatever the row
+    ///
+    static std::optional<SalaBytecode> compile(const SalaProgram &program,
+                                               const AttributeTable &table);
+
+    ///
+    /// \brief Run the program on rows of the table it was compiled for, in parallel if there are
+    /// many. The results do not depend on the number of threads
+    /// \param keys the keys of the rows
+    /// \param rowIndices the dense index of each row in the table, -1 if it is not in the table
+    /// \param results the result of each row, as a number (booleans as 1 or 0)
+    /// \param failed for each row, whether the program could not be run on it here, as the row is
+    /// not in the table or an error was found while running (such as integer division by zero).
+    /// These rows have to be run by SalaProgram to find out what happens
+    ///
+    void run(const std::vector<int> &keys, const std::vector<size_t> &rowIndices,
+             std::vector<double> &results, std::vector<char> &failed) const;
+
+  private:
+    enum ValueType { VT_BOOL, VT_INT, VT_DOUBLE };
+
+    enum Op {
+        OP_CONST,
+        OP_COLUMN,
+        OP_KEY,
+        OP_ADD,
+        OP_SUBTRACT,
+        OP_MULTIPLY,
+        OP_DIVIDE,
+        OP_MODULO,
+        OP_MINUS,
+        OP_INT_ADD,
+        OP_INT_SUBTRACT,
+        OP_INT_MULTIPLY,
+        OP_INT_DIVIDE,
+        OP_INT_MODULO,
+        OP_INT_MINUS,
+        OP_POWER,
+        OP_SQRT,
+        OP_LOG,
+        OP_LN,
+        OP_SIN,
+        OP_COS,
+        OP_TAN,
+        OP_ASIN,
+        OP_ACOS,
+        OP_ATAN,
+        OP_LT,
+        OP_GT,
+        OP_LEQ,
+        OP_GEQ,
+        OP_EQ,
+        OP_NEQ,
+        OP_AND,
+        OP_OR,
+        OP_NOT
+    };
+
+    // each instruction writes to the register of the same index, from the registers of the
+    // operands
+    struct Instruction {
+        Instruction(Op o, ValueType t, size_t l = 0, size_t r = 0, double c = 0.0,
+                    size_t col = 0)
+            : constant(c), column(col), lhs(l), rhs(r), op(o), type(t) {}
+        double constant;
+        size_t column;
+        size_t lhs;
+        size_t rhs;
+        Op op;
+        ValueType type;
+    };
+
+    // a compiled operand: the register holding it and the type SalaObj would give it
+    struct Operand {
+        size_t reg;
+        ValueType type;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
+      public:
+        Operand(size_t r, ValueType t) : reg(r), type(t), _padding0(0) {}
+    };
+
+    const AttributeTable *m_table;
+    const SalaProgram *m_program;
+    std::vector<Instruction> m_instructions;
+    // the register of the value of the whole expression
+    size_t m_result;
+
+    SalaBytecode(const SalaProgram &program, const AttributeTable &table)
+        : m_table(&table), m_program(&program), m_instructions(), m_result(0) {}
+
+    std::optional<Operand> compile(const std::vector<SalaObj> &evalStack, int &pointer,
+                                   bool isRoot);
+    std::optional<Operand> compileMath(SalaObj::Func func, const std::vector<SalaObj> &evalStack,
+                                       int &pointer);
+    std::optional<Operand> compileLogical(SalaObj::Func func,
+                                          const std::vector<SalaObj> &evalStack, int &pointer,
+                                          bool isRoot);
+    std::optional<Operand> compileValue(const std::vector<SalaObj> &evalStack, int &pointer);
+    Operand add(Op op, ValueType type, size_t lhs = 0, size_t rhs = 0, double constant = 0.0,
+                size_t column = 0);
+
+    void runBlock(const int *keys, const size_t *rowIndices, size_t count,
+                  std::vector<double> &registers, double *results, char *failed) const;
+};
@@ -24,12 +24,19 @@
 #include "connector.hpp"
 #include "latticemap.hpp"
 #include "ngraph.hpp"
+#include "salabytecode.hpp"
 #include "shapemap.hpp"
 
 #include <cmath>
 #include <cstring>
+#include <iterator>
+#include <sstream>
 #include <time.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 // Assign and list access rather incongruently in math ops, but never mind:
@@ -119,7 +126,7 @@ namespace {
 
 SalaProgram::SalaProgram(SalaObj context)
     : m_rootCommand(), m_varStack(), m_errorStack(), m_col(), m_marked(false), _padding0(0),
-      m_thisobj(), m_marks() {
+      m_thisobj(), m_marks(), m_source() {
     if (!g_sala_loaded) {
         loadSalaProgram();
     }
@@ -134,7 +141,10 @@ SalaProgram::~SalaProgram() {}
 // use istrstream to make an istream from a string:
 // istrstream file(char *);
 
-bool SalaProgram::parse(std::istream &program) {
+bool SalaProgram::parse(std::istream &input) {
+    m_source.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    std::istringstream program(m_source);
+
     m_varStack.clear();
     m_errorStack.clear();
 
@@ -294,6 +304,23 @@ bool SalaProgram::runupdate(int col, const std::set<int> &selset) {
     // commands running the program
     int &row = m_thisobj.m_data.graph.node;
     m_col = col;
+    // simple expressions run compiled over the columns instead, and programs that only read
+    // their own row on several threads. Either way the values are set in order after
+    auto bytecode = SalaBytecode::compile(*this, *table);
+    size_t rowCount = selset.size() ? selset.size() : table->getNumRows();
+    if (bytecode.has_value() || canRunInParallel(rowCount)) {
+        std::vector<int> keys;
+        std::vector<size_t> rowIndices;
+        getRunRows(selset, keys, rowIndices);
+        std::vector<double> results;
+        std::vector<char> failed;
+        if (bytecode.has_value()) {
+            bytecode->run(keys, rowIndices, results, failed);
+        } else {
+            evaluateInParallel(keys, false, results, failed);
+        }
+        return setValues(keys, rowIndices, results, failed);
+    }
     if (selset.size()) {
         for (auto &sel : selset) {
             row = sel;
@@ -337,9 +364,26 @@ bool SalaProgram::runupdate(int col, const std::set<int> &selset) {
 
 bool SalaProgram::runselect(std::vector<int> &selsetout, const std::set<int> &selsetin) {
     AttributeTable *table = m_thisobj.getTable();
+    int &row = m_thisobj.m_data.graph.node;
+    auto bytecode = SalaBytecode::compile(*this, *table);
+    size_t rowCount = selsetin.size() ? selsetin.size() : table->getNumRows();
+    if (bytecode.has_value() || canRunInParallel(rowCount)) {
+        std::vector<int> keys;
+        std::vector<size_t> rowIndices;
+        getRunRows(selsetin, keys, rowIndices);
+        std::vector<double> results;
+        std::vector<char> failed;
+        if (bytecode.has_value()) {
+            bytecode->run(keys, rowIndices, results, failed);
+        } else {
+            evaluateInParallel(keys, true, results, failed);
+        }
+        return selectRows(keys, results, failed, selsetout);
+    }
 
     if (selsetin.size()) {
         for (auto &key : selsetin) {
+            row = key;
             try {
                 SalaObj val = evaluate();
                 bool v = val.toBool(); // note, toBool will type check and throw if
@@ -356,6 +400,7 @@ bool SalaProgram::runselect(std::vector<int> &selsetout, const std::set<int> &se
     } else {
         for (auto iter = table->begin(); iter != table->end(); iter++) {
             int key = iter->getKey().value;
+            row = key;
             try {
                 SalaObj val = evaluate();
                 bool v = val.toBool(); // note, toBool will type check and throw if
@@ -373,6 +418,117 @@ bool SalaProgram::runselect(std::vector<int> &selsetout, const std::set<int> &se
     return true;
 }
 
+void SalaProgram::getRunRows(const std::set<int> &selset, std::vector<int> &keys,
+                             std::vector<size_t> &rowIndices) {
+    AttributeTable *table = m_thisobj.getTable();
+    keys.clear();
+    rowIndices.clear();
+    if (selset.size()) {
+        keys.assign(selset.begin(), selset.end());
+        rowIndices.reserve(keys.size());
+        for (int key : keys) {
+            rowIndices.push_back(
+                table->getDenseRowIndex(AttributeKey(key)).value_or(static_cast<size_t>(-1)));
+        }
+    } else {
+        keys.reserve(table->getNumRows());
+        for (auto iter = table->begin(); iter != table->end(); iter++) {
+            keys.push_back(iter->getKey().value);
+        }
+        rowIndices = table->getDenseRowIndices();
+    }
+}
+
+bool SalaProgram::canRunInParallel(size_t rowCount) const {
+#if defined(_OPENMP)
+    // fewer rows are not worth parsing a copy of the program for each thread
+    constexpr size_t PARALLEL_THRESHOLD = 4096;
+    return rowCount >= PARALLEL_THRESHOLD && omp_get_max_threads() > 1 &&
+           m_rootCommand.isRowLocal();
+#else
+    (void)rowCount;
+    return false;
+#endif
+}
+
+void SalaProgram::evaluateInParallel(const std::vector<int> &keys, bool select,
+                                     std::vector<double> &results, std::vector<char> &failed) {
+    auto n = static_cast<int>(keys.size());
+    results.assign(keys.size(), 0.0);
+    failed.assign(keys.size(), 0);
+#if defined(_OPENMP)
+#pragma omp parallel default(shared)
+#endif
+    {
+        // every thread parses its own copy of the program, so that the variables and the
+        // reference counts of the objects are never shared between threads
+        SalaProgram program(m_thisobj);
+        std::istringstream source(m_source);
+        program.parse(source);
+        int &row = program.m_thisobj.m_data.graph.node;
+
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < n; i++) {
+            auto idx = static_cast<size_t>(i);
+            row = keys[idx];
+            try {
+                SalaObj val = program.evaluate();
+                results[idx] = select ? (val.toBool() ? 1.0 : 0.0) : val.toDouble();
+            } catch (...) {
+                // run again in order to report the error at the right row
+                failed[idx] = 1;
+            }
+        }
+    }
+}
+
+// rows that failed are run as normal, so that any error stops the update at the same row
+bool SalaProgram::setValues(const std::vector<int> &keys, const std::vector<size_t> &rowIndices,
+                            const std::vector<double> &results, const std::vector<char> &failed) {
+    AttributeTable *table = m_thisobj.getTable();
+    int &row = m_thisobj.m_data.graph.node;
+    for (size_t i = 0; i < keys.size(); i++) {
+        row = keys[i];
+        try {
+            double value = failed[i] ? evaluate().toDouble() : results[i];
+            auto v = static_cast<float>(value);
+            if (!std::isfinite(v)) {
+                v = -1.0f;
+            }
+            if (rowIndices[i] == static_cast<size_t>(-1)) {
+                table->getRow(AttributeKey(keys[i])).setValue(static_cast<size_t>(m_col), v);
+            } else {
+                table->getDenseRow(rowIndices[i]).setValue(static_cast<size_t>(m_col), v);
+            }
+        } catch (SalaError e) {
+            // error
+            m_errorStack.push_back(e);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SalaProgram::selectRows(const std::vector<int> &keys, const std::vector<double> &results,
+                             const std::vector<char> &failed, std::vector<int> &selsetout) {
+    int &row = m_thisobj.m_data.graph.node;
+    for (size_t i = 0; i < keys.size(); i++) {
+        row = keys[i];
+        try {
+            if (failed[i] ? evaluate().toBool() : results[i] != 0.0) {
+                selsetout.push_back(keys[i]);
+            }
+        } catch (SalaError e) {
+            // error
+            m_errorStack.push_back(e);
+            return false;
+        }
+    }
+    return true;
+}
+
 std::string SalaProgram::getLastErrorMessage() const {
     const SalaError &error = m_errorStack.back();
     if (error.lineno == -1) {
@@ -1527,6 +1683,22 @@ SalaObj SalaCommand::evaluate(int &pointer, SalaObj *&pObj) {
     return data;
 }
 
+bool SalaCommand::isRowLocal() const {
+    for (const auto &obj : m_evalStack) {
+        if (obj.m_type == SalaObj::S_FUNCTION &&
+            (obj.m_data.func == SalaObj::S_RAND || obj.m_data.func == SalaObj::S_FSETVALUE ||
+             obj.m_data.func == SalaObj::S_FCONNECTIONS)) {
+            return false;
+        }
+    }
+    for (const auto &child : m_children) {
+        if (!child.isRowLocal()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 
 SalaObj SalaCommand::connections(SalaObj graphobj, SalaObj param) {
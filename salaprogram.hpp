@@ -17,6 +17,7 @@
 
 class AttributeTable;
 class LatticeMap;
+class SalaBytecode;
 class ShapeMap;
 
 inline bool isalphanum_(char c) {
@@ -117,6 +118,7 @@ class SalaObj {
     friend class SalaProgram;
     friend class SalaCommand;
     friend class SalaArray;
+    friend class SalaBytecode;
 
   public:
     // Object types
@@ -319,6 +321,7 @@ class SalaProgram;
 
 class SalaCommand {
     friend class SalaProgram;
+    friend class SalaBytecode;
     //
     enum Command {
         SC_NONE,
@@ -383,10 +386,14 @@ class SalaCommand {
     void evaluate(SalaObj &obj, bool &ret, bool &ifhandled);
     SalaObj evaluate(int &pointer, SalaObj *&pObj);
     SalaObj connections(SalaObj graphnode, SalaObj param);
+    // whether the command and its children only read the row they are run on and change
+    // nothing outside the program, so that rows can be run in any order
+    bool isRowLocal() const;
 };
 
 class SalaProgram {
     friend class SalaCommand;
+    friend class SalaBytecode;
     //
     SalaCommand m_rootCommand;
     std::vector<SalaObj> m_varStack;
@@ -407,6 +414,23 @@ class SalaProgram {
     // marks for state management in maps
     std::map<int, SalaObj> m_marks;
     char read(std::istream &program) { return static_cast<char>(program.get()); }
+    // the text of the program, kept so that copies can be parsed to run on other threads
+    std::string m_source;
+    // the keys and dense indices (-1 if not in the table) of the rows to run on, all of the rows
+    // of the table if there is no selection
+    void getRunRows(const std::set<int> &selset, std::vector<int> &keys,
+                    std::vector<size_t> &rowIndices);
+    bool canRunInParallel(size_t rowCount) const;
+    // runs the program on the rows on copies of the program, one for each thread, giving either
+    // the value or the truth of each. Rows that throw are marked as failed
+    void evaluateInParallel(const std::vector<int> &keys, bool select,
+                            std::vector<double> &results, std::vector<char> &failed);
+    // set the values or select the rows in order from results found beforehand, running the
+    // program as normal on the rows marked as failed
+    bool setValues(const std::vector<int> &keys, const std::vector<size_t> &rowIndices,
+                   const std::vector<double> &results, const std::vector<char> &failed);
+    bool selectRows(const std::vector<int> &keys, const std::vector<double> &results,
+                    const std::vector<char> &failed, std::vector<int> &selsetout);
 
   public:
     SalaProgram(SalaObj context);
@@ -26,6 +26,13 @@ bool SalaShape::read(std::istream &stream) {
     return true;
 }
 
+void SalaShape::skip(std::istream &stream) {
+    stream.seekg(sizeof(m_type) + sizeof(m_region) + sizeof(m_centroid) + sizeof(m_area) +
+                     sizeof(m_perimeter),
+                 std::ios::cur);
+    dXreadwrite::skipVector<Point2f>(stream);
+}
+
 bool SalaShape::write(std::ostream &stream) const {
     stream.write(reinterpret_cast<const char *>(&m_type), sizeof(m_type));
     stream.write(reinterpret_cast<const char *>(&m_region), sizeof(m_region));
@@ -103,6 +103,7 @@ class SalaShape {
     //
     bool read(std::istream &stream);
     bool write(std::ostream &stream) const;
+    static void skip(std::istream &stream);
 
     std::vector<Line4f> getAsLines() const {
         std::vector<Line4f> lines;
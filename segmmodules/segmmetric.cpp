@@ -8,12 +8,21 @@
 
 #include "segmhelpers.hpp"
 
+#include "../genlib/dependencysweep.hpp"
+
 AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
 
     AttributeTable &attributes = map.getAttributeTable();
 
     AnalysisResult result;
 
+    if (m_selSet.has_value() && m_sourceSampling.has_value()) {
+        if (comm) {
+            comm->logError("Source sampling is not available when running on selected segments");
+        }
+        return result;
+    }
+
     time_t atime = 0;
 
     if (comm) {
@@ -48,12 +57,17 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
     std::string totaldcol = getFormattedColumn(Column::METRIC_TOTAL_DEPTH, m_radius);
     std::string totalcol = getFormattedColumn(Column::METRIC_TOTAL_NODES, m_radius);
     std::string wtotalcol = getFormattedColumn(Column::METRIC_TOTAL_LENGTH, m_radius);
+    std::string choiceerrorcol = getFormattedColumn(Column::METRIC_CHOICE_STD_ERROR, m_radius);
 
     if (!m_selSet.has_value()) {
         attributes.insertOrResetColumn(choicecol.c_str());
         result.addAttribute(choicecol);
         attributes.insertOrResetColumn(wchoicecol.c_str());
         result.addAttribute(wchoicecol);
+        if (m_sourceSampling.has_value()) {
+            attributes.insertOrResetColumn(choiceerrorcol.c_str());
+            result.addAttribute(choiceerrorcol);
+        }
     }
     attributes.insertOrResetColumn(meandepthcol.c_str());
     result.addAttribute(meandepthcol);
@@ -69,6 +83,37 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
     std::vector<unsigned int> seen(map.getShapeCount());
     std::vector<TopoMetSegmentRef> audittrail(map.getShapeCount());
     std::vector<TopoMetSegmentChoice> choicevals(map.getShapeCount());
+    // for choice accumulated in one reverse sweep per root
+    // (sampled choice is always accumulated this way, as it is scaled per root)
+    bool sampling = m_sourceSampling.has_value();
+    bool sweepChoice = !m_selSet.has_value() &&
+                       (m_choiceAccumulation != ChoiceAccumulation::BACKTRACK || sampling);
+    genlib::DependencySweep sweep(sweepChoice ? map.getShapeCount() : 0);
+
+    // for source sampling, the measures of every segment are estimated from the searches of the
+    // sampled roots that reach it
+    SampledRoots sampledRoots;
+    std::vector<double> sampledTotal, sampledWTotal, sampledTotalDepth, sampledWTotalDepth,
+        sampledChoiceSquares;
+    if (sampling) {
+        sampledRoots = SampledRoots::draw(*m_sourceSampling, map.getShapeCount(), seglengths);
+        sampledTotal.resize(map.getShapeCount(), 0.0);
+        sampledWTotal.resize(map.getShapeCount(), 0.0);
+        sampledTotalDepth.resize(map.getShapeCount(), 0.0);
+        sampledWTotalDepth.resize(map.getShapeCount(), 0.0);
+        sampledChoiceSquares.resize(map.getShapeCount(), 0.0);
+    }
+
+    auto setDepthValues = [&](AttributeRow &row, double total, double wtotal, double totalmetdepth,
+                              double wtotaldepth, double rootseglength) {
+        row.setValue(meandepthcol.c_str(), static_cast<float>(totalmetdepth / (total - 1)));
+        row.setValue(totaldcol.c_str(), static_cast<float>(totalmetdepth));
+        row.setValue(wmeandepthcol.c_str(),
+                     static_cast<float>(wtotaldepth / (wtotal - rootseglength)));
+        row.setValue(totalcol.c_str(), static_cast<float>(total));
+        row.setValue(wtotalcol.c_str(), static_cast<float>(wtotal));
+    };
+
     for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
         AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
         auto &shapeRef = map.getShapeRefFromIndex(cursor);
@@ -76,6 +121,10 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
             m_selSet.value().find(shapeRef->first) == m_selSet.value().end()) {
             continue;
         }
+        if (sampling && !sampledRoots.isSampled(cursor)) {
+            continue;
+        }
+        double rootScale = sampling ? sampledRoots.rootScale(cursor) : 1.0;
         for (size_t i = 0; i < map.getShapeCount(); i++) {
             seen[i] = 0xffffffff;
         }
@@ -85,6 +134,10 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
         double rootseglength = seglengths[cursor];
         audittrail[cursor] = TopoMetSegmentRef(static_cast<int>(cursor), Connector::SEG_CONN_ALL,
                                                rootseglength * 0.5, -1);
+        if (sweepChoice) {
+            sweep.reset();
+            sweep.settleRoot(cursor);
+        }
         int open = 1;
         unsigned int segdepth = 0;
         double total = 0.0, wtotal = 0.0, wtotaldepth = 0.0, totalmetdepth = 0.0;
@@ -112,6 +165,14 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
             wtotal += len;
             wtotaldepth += len * (here.dist - len * 0.5);
             total += 1;
+            if (sampling) {
+                // this root as seen from the segment reached
+                auto reached = static_cast<size_t>(here.ref);
+                sampledTotal[reached] += rootScale;
+                sampledWTotal[reached] += rootScale * rootseglength;
+                sampledTotalDepth[reached] += rootScale * (here.dist - len * 0.5);
+                sampledWTotalDepth[reached] += rootScale * rootseglength * (here.dist - len * 0.5);
+            }
             //
             Connector &axline = map.getConnections().at(static_cast<size_t>(here.ref));
             int connectedCursor = -2;
@@ -138,6 +199,10 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
                     audittrail[static_cast<size_t>(connectedCursor)] =
                         TopoMetSegmentRef(connectedCursor, here.dir, here.dist + length, here.ref);
                     seen[static_cast<size_t>(connectedCursor)] = segdepth;
+                    if (sweepChoice && !seenalready) {
+                        sweep.settle(static_cast<size_t>(connectedCursor),
+                                     static_cast<size_t>(here.ref));
+                    }
                     if (m_radius == -1 || here.dist + length < m_radius) {
                         // puts in a suitable bin ahead of us...
                         open++;
@@ -153,7 +218,8 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
                     // can go twice)
 
                     // Quick mod - TV
-                    if (!m_selSet.has_value() && connectedCursor > static_cast<int>(cursor) &&
+                    if (!m_selSet.has_value() && !sweepChoice &&
+                        connectedCursor > static_cast<int>(cursor) &&
                         !seenalready) { // only one way paths, saves doing this twice
                         int subcur = connectedCursor;
                         while (subcur != -1) {
@@ -168,14 +234,35 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
                 iter++;
             }
         }
+        if (sweepChoice) {
+            // push all paths from this root back towards it at once, only one way paths as
+            // above, and again with the start and end lines included. From a sample of roots
+            // there are no pairs to skip, so paths are taken both ways and halved instead
+            auto isTarget = [&](size_t node) { return sampling ? node != cursor : node > cursor; };
+            double choiceScale = sampling ? 0.5 * rootScale : 1.0;
+            sweep.accumulate(
+                [&](size_t node) { return isTarget(node) ? 1.0 : 0.0; },
+                [&](size_t node, double dependency) {
+                    double choice = dependency + (isTarget(node) ? 1.0 : 0.0);
+                    choicevals[node].choice += choiceScale * choice;
+                    if (sampling) {
+                        double contribution = 0.5 * sampledRoots.drawScale[cursor] * choice;
+                        sampledChoiceSquares[node] +=
+                            sampledRoots.multiplicity[cursor] * contribution * contribution;
+                    }
+                });
+            auto lengthTarget = [&](size_t node) {
+                return isTarget(node) ? rootseglength * seglengths[node] : 0.0;
+            };
+            sweep.accumulate(lengthTarget, [&](size_t node, double dependency) {
+                choicevals[node].wchoice += choiceScale * (dependency + lengthTarget(node));
+            });
+        }
         // also put in mean depth:
         //
-        row.setValue(meandepthcol.c_str(), static_cast<float>(totalmetdepth / (total - 1)));
-        row.setValue(totaldcol.c_str(), static_cast<float>(totalmetdepth));
-        row.setValue(wmeandepthcol.c_str(),
-                     static_cast<float>(wtotaldepth / (wtotal - rootseglength)));
-        row.setValue(totalcol.c_str(), static_cast<float>(total));
-        row.setValue(wtotalcol.c_str(), static_cast<float>(wtotal));
+        if (!sampling) {
+            setDepthValues(row, total, wtotal, totalmetdepth, wtotaldepth, rootseglength);
+        }
         //
         if (comm) {
             if (qtimer(atime, 500)) {
@@ -193,6 +280,14 @@ AnalysisResult SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
             AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
             row.setValue(choicecol.c_str(), static_cast<float>(choicevals[cursor].choice));
             row.setValue(wchoicecol.c_str(), static_cast<float>(choicevals[cursor].wchoice));
+            if (sampling) {
+                row.setValue(choiceerrorcol.c_str(),
+                             static_cast<float>(sampledRoots.standardError(
+                                 choicevals[cursor].choice, sampledChoiceSquares[cursor])));
+                setDepthValues(row, sampledTotal[cursor], sampledWTotal[cursor],
+                               sampledTotalDepth[cursor], sampledWTotalDepth[cursor],
+                               seglengths[cursor]);
+            }
         }
     }
 
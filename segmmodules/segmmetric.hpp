@@ -6,22 +6,33 @@
 
 #pragma once
 
+#include "../choiceaccumulation.hpp"
 #include "../isegment.hpp"
 
+#include "segmsampling.hpp"
+
 class SegmentMetric : ISegment {
     double m_radius;
     std::optional<std::set<int>> m_selSet;
+    std::optional<SourceSampling> m_sourceSampling = std::nullopt;
+
+    // the search settles each segment from its first discoverer, thus ALL_PATHS accumulates
+    // along that single path too
+    ChoiceAccumulation m_choiceAccumulation = ChoiceAccumulation::BACKTRACK;
+
+    [[maybe_unused]] unsigned _padding0 : 4 * 8;
 
   public:
     struct Column {
-        inline static const std::string                        //
-            METRIC_CHOICE = "Metric Choice",                   //
-            METRIC_CHOICE_SLW = "Metric Choice [SLW]",         //
-            METRIC_MEAN_DEPTH = "Metric Mean Depth",           //
-            METRIC_MEAN_DEPTH_SLW = "Metric Mean Depth [SLW]", //
-            METRIC_TOTAL_DEPTH = "Metric Total Depth",         //
-            METRIC_TOTAL_NODES = "Metric Total Nodes",         //
-            METRIC_TOTAL_LENGTH = "Metric Total Length";       //
+        inline static const std::string                          //
+            METRIC_CHOICE = "Metric Choice",                     //
+            METRIC_CHOICE_SLW = "Metric Choice [SLW]",           //
+            METRIC_CHOICE_STD_ERROR = "Metric Choice Std. Error", //
+            METRIC_MEAN_DEPTH = "Metric Mean Depth",             //
+            METRIC_MEAN_DEPTH_SLW = "Metric Mean Depth [SLW]",   //
+            METRIC_TOTAL_DEPTH = "Metric Total Depth",           //
+            METRIC_TOTAL_NODES = "Metric Total Nodes",           //
+            METRIC_TOTAL_LENGTH = "Metric Total Length";         //
     };
     static std::string getFormattedColumn(const std::string &column, double radius) {
         std::string colName = column;
@@ -33,7 +44,14 @@ class SegmentMetric : ISegment {
 
   public:
     SegmentMetric(double radius, std::optional<std::set<int>> selSet)
-        : m_radius(radius), m_selSet(std::move(selSet)) {}
+        : m_radius(radius), m_selSet(std::move(selSet)), _padding0(0) {}
+    void setChoiceAccumulation(ChoiceAccumulation choiceAccumulation) {
+        m_choiceAccumulation = choiceAccumulation;
+    }
+    // Only run searches from a sample of the roots and extrapolate choice and depth from them.
+    // Weighted sampling draws roots by segment length. The standard error of the choice
+    // estimate is given in an extra column
+    void setSourceSampling(SourceSampling sourceSampling) { m_sourceSampling = sourceSampling; }
     std::string getAnalysisName() const override { return "Metric Analysis"; }
     AnalysisResult run(Communicator *comm, ShapeGraph &map, bool) override;
 };
@@ -8,32 +8,16 @@
 
 #include "segmhelpers.hpp"
 
-AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
-
-    AttributeTable &attributes = map.getAttributeTable();
+std::vector<float> SegmentMetricPD::traverse(const ShapeGraph &map,
+                                             const std::vector<float> &seglengths,
+                                             float maxseglength,
+                                             const std::set<int> &originRefs) const {
 
-    AnalysisResult result;
-
-    // record axial line refs for topological analysis
-    std::vector<int> axialrefs;
-    // quick through to find the longest seg length
-    std::vector<float> seglengths;
-    float maxseglength = 0.0f;
-    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
-        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
-        axialrefs.push_back(static_cast<int>(row.getValue("Axial Line Ref")));
-        seglengths.push_back(row.getValue("Segment Length"));
-        if (seglengths.back() > maxseglength) {
-            maxseglength = seglengths.back();
-        }
-    }
+    std::vector<float> stepDepths(map.getShapeCount(), -1.0f);
 
     int maxbin;
     maxbin = 512;
 
-    auto sdColIdx = attributes.insertOrResetColumn(Column::METRIC_STEP_DEPTH);
-    result.addAttribute(Column::METRIC_STEP_DEPTH);
-
     std::vector<unsigned int> seen(map.getShapeCount());
     std::vector<TopoMetSegmentRef> audittrail(map.getShapeCount());
     std::vector<int> list[512]; // 512 bins!
@@ -42,7 +26,7 @@ AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
     for (size_t i = 0; i < map.getShapeCount(); i++) {
         seen[i] = 0xffffffff;
     }
-    for (auto &cursor : m_originRefs) {
+    for (auto &cursor : originRefs) {
         seen[static_cast<size_t>(cursor)] = 0;
         open++;
         double length = seglengths[static_cast<size_t>(cursor)];
@@ -51,8 +35,7 @@ AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
         // better to divide by 511 but have 512 bins...
         list[(static_cast<int>(floor(0.5 + 511 * length / maxseglength))) % 512].push_back(
             static_cast<int>(cursor));
-        AttributeRow &row = map.getAttributeRowFromShapeIndex(static_cast<size_t>(cursor));
-        row.setValue(sdColIdx, 0);
+        stepDepths[static_cast<size_t>(cursor)] = 0;
     }
 
     unsigned int segdepth = 0;
@@ -77,7 +60,7 @@ AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
             here.done = true;
         }
 
-        Connector &axline = map.getConnections().at(static_cast<size_t>(here.ref));
+        const Connector &axline = map.getConnections().at(static_cast<size_t>(here.ref));
         int connectedCursor = -2;
 
         auto iter = axline.backSegconns.begin();
@@ -104,14 +87,63 @@ AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
                 // better to divide by 511 but have 512 bins...
                 list[(bin + static_cast<int>(floor(0.5 + 511 * length / maxseglength))) % 512]
                     .push_back(connectedCursor);
-                AttributeRow &row =
-                    map.getAttributeRowFromShapeIndex(static_cast<size_t>(connectedCursor));
-                row.setValue(sdColIdx, static_cast<float>(here.dist + length * 0.5));
+                stepDepths[static_cast<size_t>(connectedCursor)] =
+                    static_cast<float>(here.dist + length * 0.5);
             }
             iter++;
         }
     }
 
+    return stepDepths;
+}
+
+AnalysisResult SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
+
+    AttributeTable &attributes = map.getAttributeTable();
+
+    AnalysisResult result;
+
+    // quick through to find the longest seg length
+    std::vector<float> seglengths;
+    float maxseglength = 0.0f;
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        seglengths.push_back(row.getValue("Segment Length"));
+        if (seglengths.back() > maxseglength) {
+            maxseglength = seglengths.back();
+        }
+    }
+
+    std::vector<const std::set<int> *> originSets;
+    std::vector<size_t> sdColIdxs;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        std::string sdColText = getOriginSetColumn(Column::METRIC_STEP_DEPTH, originSetName);
+        sdColIdxs.push_back(attributes.insertOrResetColumn(sdColText));
+        result.addAttribute(sdColText);
+        originSets.push_back(&originRefs);
+    }
+
+    std::vector<std::vector<float>> stepDepths(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        stepDepths[static_cast<size_t>(i)] =
+            traverse(map, seglengths, maxseglength, *originSets[static_cast<size_t>(i)]);
+    }
+
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        for (size_t i = 0; i < originSets.size(); i++) {
+            if (stepDepths[i][cursor] >= 0) {
+                row.setValue(sdColIdxs[i], stepDepths[i][cursor]);
+            }
+        }
+    }
+
     result.completed = true;
 
     return result;
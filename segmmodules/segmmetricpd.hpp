@@ -10,7 +10,11 @@
 
 class SegmentMetricPD : ISegment {
 
-    std::set<int> m_originRefs;
+    // named sets of origins, each given its own step depth column
+    std::map<std::string, std::set<int>> m_originSets;
+
+    std::vector<float> traverse(const ShapeGraph &map, const std::vector<float> &seglengths,
+                                float maxseglength, const std::set<int> &originRefs) const;
 
   public:
     struct Column {
@@ -19,7 +23,10 @@ class SegmentMetricPD : ISegment {
     };
 
   public:
-    SegmentMetricPD(std::set<int> originRefs) : m_originRefs(std::move(originRefs)) {}
+    SegmentMetricPD(std::set<int> originRefs) : m_originSets({{"", std::move(originRefs)}}) {}
+    // one search per set, run in parallel, sharing the reading of the map
+    SegmentMetricPD(std::map<std::string, std::set<int>> originSets)
+        : m_originSets(std::move(originSets)) {}
     std::string getAnalysisName() const override { return "Metric Analysis"; }
     AnalysisResult run(Communicator *, ShapeGraph &map, bool) override;
 };
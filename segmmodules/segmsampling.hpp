@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+// Source sampling for approximate segment analysis: searches are only run from a sample of the
+// roots, and their contributions are extrapolated to all roots
+
+#include "../genlib/pafmath.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SourceSampling {
+    size_t sampleCount;
+    uint64_t seed;
+    // draw roots with probability proportional to the weighting column instead of uniformly
+    bool weighted;
+
+  private:
+    [[maybe_unused]] unsigned _padding0 : 3 * 8;
+    [[maybe_unused]] unsigned _padding1 : 4 * 8;
+
+  public:
+    SourceSampling(size_t count = 0, uint64_t sd = 0, bool wgt = false)
+        : sampleCount(count), seed(sd), weighted(wgt), _padding0(0), _padding1(0) {}
+};
+
+// The roots drawn (with replacement) for every root index. Each draw of a root extrapolates its
+// contributions by 1 / (draws * probability of drawing it), the Hansen-Hurwitz estimator
+struct SampledRoots {
+    std::vector<unsigned int> multiplicity;
+    std::vector<double> drawScale;
+    size_t draws;
+
+    SampledRoots() : multiplicity(), drawScale(), draws(0) {}
+
+    bool isSampled(size_t root) const { return multiplicity[root] != 0; }
+
+    // the factor all contributions of a root are extrapolated by
+    double rootScale(size_t root) const { return multiplicity[root] * drawScale[root]; }
+
+    // standard error of an extrapolated total, given the sum over the roots drawn of
+    // multiplicity * (drawScale * contribution)^2
+    double standardError(double total, double sumOfSquares) const {
+        if (draws < 2) {
+            return -1.0;
+        }
+        double n = static_cast<double>(draws);
+        return std::sqrt(std::max(0.0, (n * sumOfSquares - total * total) / (n - 1.0)));
+    }
+
+    // weights are only used for weighted sampling, and roots with no weight are never drawn
+    static SampledRoots draw(const SourceSampling &sampling, size_t rootCount,
+                             const std::vector<float> &weights = std::vector<float>()) {
+        SampledRoots sampled;
+        sampled.multiplicity.resize(rootCount, 0);
+        sampled.drawScale.resize(rootCount, 0.0);
+        if (rootCount == 0 || sampling.sampleCount == 0) {
+            return sampled;
+        }
+        sampled.draws = sampling.sampleCount;
+        double draws = static_cast<double>(sampled.draws);
+
+        if (!sampling.weighted || weights.size() != rootCount) {
+            for (size_t i = 0; i < sampled.draws; i++) {
+                auto root = static_cast<size_t>(pafmath::counterrand(sampling.seed, i) %
+                                                static_cast<uint64_t>(rootCount));
+                sampled.multiplicity[root]++;
+            }
+            std::fill(sampled.drawScale.begin(), sampled.drawScale.end(),
+                      static_cast<double>(rootCount) / draws);
+            return sampled;
+        }
+
+        std::vector<double> cumulative(rootCount);
+        double total = 0.0;
+        for (size_t i = 0; i < rootCount; i++) {
+            total += std::max(0.0, static_cast<double>(weights[i]));
+            cumulative[i] = total;
+        }
+        if (total <= 0.0) {
+            sampled.draws = 0;
+            return sampled;
+        }
+        for (size_t i = 0; i < sampled.draws; i++) {
+            double pick = pafmath::counterrandr(sampling.seed, i) * total;
+            auto root = static_cast<size_t>(
+                std::upper_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin());
+            sampled.multiplicity[std::min(root, rootCount - 1)]++;
+        }
+        for (size_t i = 0; i < rootCount; i++) {
+            if (weights[i] > 0.0f) {
+                sampled.drawScale[i] = total / (draws * static_cast<double>(weights[i]));
+            }
+        }
+        return sampled;
+    }
+};
@@ -0,0 +1,451 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmshortestpaths.hpp"
+
+#include "segmhelpers.hpp"
+
+#include "../genlib/pafmath.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+SegmentShortestPaths::SegmentGraph SegmentShortestPaths::compileGraph() const {
+    SegmentGraph graph;
+    size_t shapeCount = m_map.getShapeCount();
+    const auto &connections = m_map.getConnections();
+
+    graph.firstEdge.reserve(shapeCount + 1);
+    graph.firstBackEdge.reserve(shapeCount);
+    for (size_t i = 0; i < shapeCount; i++) {
+        graph.firstEdge.push_back(graph.edges.size());
+        for (auto &segconn : connections[i].forwardSegconns) {
+            graph.edges.emplace_back(segconn.second, segconn.first.ref, segconn.first.dir);
+        }
+        graph.firstBackEdge.push_back(graph.edges.size());
+        for (auto &segconn : connections[i].backSegconns) {
+            graph.edges.emplace_back(segconn.second, segconn.first.ref, segconn.first.dir);
+        }
+    }
+    graph.firstEdge.push_back(graph.edges.size());
+
+    if (m_pathType != PathType::ANGULAR) {
+        const AttributeTable &attributes = m_map.getAttributeTable();
+        size_t lengthCol = attributes.getColumnIndex("Segment Length");
+        size_t axialRefCol = attributes.getColumnIndex("Axial Line Ref");
+        graph.lengths.reserve(shapeCount);
+        graph.axialRefs.reserve(shapeCount);
+        for (size_t i = 0; i < shapeCount; i++) {
+            const AttributeRow &row = m_map.getAttributeRowFromShapeIndex(i);
+            graph.lengths.push_back(row.getValue(lengthCol));
+            graph.axialRefs.push_back(static_cast<int>(row.getValue(axialRefCol)));
+            if (graph.lengths.back() > graph.maxLength) {
+                graph.maxLength = graph.lengths.back();
+            }
+        }
+    }
+    return graph;
+}
+
+// as SegmentTulipShortestPath, but the parent of a segment is the one it is settled from, and
+// equal paths are picked from a random stream seeded by the origin so that searches can run in
+// parallel and give the same paths every time
+
+SegmentShortestPaths::SearchTree
+SegmentShortestPaths::searchAngular(const SegmentGraph &graph, size_t from,
+                                    std::vector<bool> &destinations,
+                                    size_t destinationCount) const {
+    size_t shapeCount = m_map.getShapeCount();
+    SearchTree tree(shapeCount);
+
+    size_t tulipBins = m_tulipBins;
+    tulipBins /= 2; // <- actually use semicircle of tulip bins
+    tulipBins += 1;
+
+    std::vector<bool> covered(shapeCount, false);
+    std::vector<std::vector<SegmentData>> bins(tulipBins);
+    bins[0].push_back(SegmentData(0, static_cast<int>(from), SegmentRef(), 0, 0.0, 0));
+    int opencount = 1;
+    uint64_t picks = 0;
+
+    int depthlevel = 0;
+    size_t currentbin = 0;
+    while (opencount != 0 && destinationCount != 0) {
+        while (bins[currentbin].empty()) {
+            depthlevel++;
+            currentbin++;
+            if (currentbin == tulipBins) {
+                currentbin = 0;
+            }
+        }
+        auto &bin = bins[currentbin];
+        SegmentData lineindex;
+        if (bin.size() > 1) {
+            auto curr = pafmath::counterrand(from, picks++) % bin.size();
+            auto currIter = bin.begin() + static_cast<long>(curr);
+            lineindex = *currIter;
+            bin.erase(currIter);
+        } else {
+            lineindex = bin.front();
+            bin.pop_back();
+        }
+        opencount--;
+        auto lineRef = static_cast<size_t>(lineindex.ref);
+        if (covered[lineRef]) {
+            continue;
+        }
+        covered[lineRef] = true;
+        // convert depth from tulip_bins normalised to standard angle
+        // (note the -1)
+        tree.cost[lineRef] = depthlevel / (static_cast<double>(tulipBins - 1) * 0.5);
+        tree.parent[lineRef] = lineindex.previous.ref;
+        if (destinations[lineRef]) {
+            destinations[lineRef] = false;
+            destinationCount--;
+        }
+        // forward connections unless heading back, then back connections unless heading forward
+        size_t edgeFrom =
+            lineindex.dir != -1 ? graph.firstEdge[lineRef] : graph.firstBackEdge[lineRef];
+        size_t edgeTo =
+            lineindex.dir != 1 ? graph.firstEdge[lineRef + 1] : graph.firstBackEdge[lineRef];
+        for (size_t e = edgeFrom; e < edgeTo; e++) {
+            const SegmentEdge &edge = graph.edges[e];
+            if (!covered[static_cast<size_t>(edge.ref)]) {
+                auto extradepth =
+                    static_cast<size_t>(floor(edge.angle * static_cast<double>(tulipBins) * 0.5));
+                bins[(currentbin + tulipBins + extradepth) % tulipBins].push_back(
+                    SegmentData(SegmentRef(edge.dir, edge.ref),
+                                SegmentRef(lineindex.dir, lineindex.ref),
+                                lineindex.segdepth + 1, 0.0, 0));
+                opencount++;
+            }
+        }
+    }
+    return tree;
+}
+
+// as SegmentMetricShortestPath, segments are given their distance and parent when first found
+
+SegmentShortestPaths::SearchTree
+SegmentShortestPaths::searchMetric(const SegmentGraph &graph, size_t from,
+                                   std::vector<bool> &destinations,
+                                   size_t destinationCount) const {
+    size_t shapeCount = m_map.getShapeCount();
+    SearchTree tree(shapeCount);
+
+    const size_t maxbin = 512;
+
+    std::vector<unsigned int> seen(shapeCount, 0xffffffff);
+    std::vector<TopoMetSegmentRef> audittrail(shapeCount);
+    std::vector<std::vector<int>> list(maxbin);
+    int open = 0;
+
+    seen[from] = 0;
+    open++;
+    double length = graph.lengths[from];
+    audittrail[from] =
+        TopoMetSegmentRef(static_cast<int>(from), Connector::SEG_CONN_ALL, length * 0.5, -1);
+    // better to divide by 511 but have 512 bins...
+    list[static_cast<size_t>(floor(0.5 + 511 * length / graph.maxLength)) % maxbin].push_back(
+        static_cast<int>(from));
+    tree.cost[from] = 0;
+    if (destinations[from]) {
+        destinations[from] = false;
+        destinationCount--;
+    }
+
+    unsigned int segdepth = 0;
+    size_t bin = 0;
+
+    while (open != 0 && destinationCount != 0) {
+        while (list[bin].empty()) {
+            bin++;
+            segdepth += 1;
+            if (bin == maxbin) {
+                bin = 0;
+            }
+        }
+        //
+        TopoMetSegmentRef &here = audittrail[static_cast<size_t>(list[bin].back())];
+        list[bin].pop_back();
+        open--;
+        // this is necessary using unsigned ints for "seen", as it is possible to add a node twice
+        if (here.done) {
+            continue;
+        } else {
+            here.done = true;
+        }
+
+        auto hereRef = static_cast<size_t>(here.ref);
+        // back connections first, as in the single query
+        const std::pair<size_t, size_t> edgeRanges[] = {
+            {graph.firstBackEdge[hereRef], graph.firstEdge[hereRef + 1]},
+            {graph.firstEdge[hereRef], graph.firstBackEdge[hereRef]}};
+        for (auto [edgeFrom, edgeTo] : edgeRanges) {
+            for (size_t e = edgeFrom; e < edgeTo && destinationCount != 0; e++) {
+                auto connectedCursor = static_cast<size_t>(graph.edges[e].ref);
+                if (seen[connectedCursor] > segdepth) {
+                    float connectedLength = graph.lengths[connectedCursor];
+                    seen[connectedCursor] = segdepth;
+                    audittrail[connectedCursor] =
+                        TopoMetSegmentRef(static_cast<int>(connectedCursor), here.dir,
+                                          here.dist + connectedLength, here.ref);
+                    tree.parent[connectedCursor] = here.ref;
+                    tree.cost[connectedCursor] = here.dist + connectedLength * 0.5;
+                    if (destinations[connectedCursor]) {
+                        destinations[connectedCursor] = false;
+                        destinationCount--;
+                    }
+                    // puts in a suitable bin ahead of us...
+                    open++;
+                    //
+                    // better to divide by 511 but have 512 bins...
+                    list[(bin + static_cast<size_t>(
+                                    floor(0.5 + 511 * connectedLength / graph.maxLength))) %
+                         maxbin]
+                        .push_back(static_cast<int>(connectedCursor));
+                }
+            }
+        }
+    }
+    return tree;
+}
+
+// as SegmentTopologicalShortestPath, but a destination is only final once it is settled, as it
+// may be found again at a lower depth through a segment of the same axial line
+
+SegmentShortestPaths::SearchTree
+SegmentShortestPaths::searchTopological(const SegmentGraph &graph, size_t from,
+                                        std::vector<bool> &destinations,
+                                        size_t destinationCount) const {
+    size_t shapeCount = m_map.getShapeCount();
+    SearchTree tree(shapeCount);
+
+    const size_t maxbin = 2;
+
+    std::vector<unsigned int> seen(shapeCount, 0xffffffff);
+    std::vector<TopoMetSegmentRef> audittrail(shapeCount);
+    std::vector<std::vector<int>> list(maxbin);
+    int open = 0;
+
+    seen[from] = 0;
+    open++;
+    double length = graph.lengths[from];
+    audittrail[from] =
+        TopoMetSegmentRef(static_cast<int>(from), Connector::SEG_CONN_ALL, length * 0.5, -1);
+    list[0].push_back(static_cast<int>(from));
+    tree.cost[from] = 0;
+
+    unsigned int segdepth = 0;
+    size_t bin = 0;
+
+    while (open != 0 && destinationCount != 0) {
+        while (list[bin].empty()) {
+            bin++;
+            segdepth += 1;
+            if (bin == maxbin) {
+                bin = 0;
+            }
+        }
+        //
+        TopoMetSegmentRef &here = audittrail[static_cast<size_t>(list[bin].back())];
+        list[bin].pop_back();
+        open--;
+        // this is necessary using unsigned ints for "seen", as it is possible to add a node twice
+        if (here.done) {
+            continue;
+        } else {
+            here.done = true;
+        }
+
+        auto hereRef = static_cast<size_t>(here.ref);
+        if (destinations[hereRef]) {
+            destinations[hereRef] = false;
+            destinationCount--;
+        }
+        // back connections first, as in the single query
+        const std::pair<size_t, size_t> edgeRanges[] = {
+            {graph.firstBackEdge[hereRef], graph.firstEdge[hereRef + 1]},
+            {graph.firstEdge[hereRef], graph.firstBackEdge[hereRef]}};
+        for (auto [edgeFrom, edgeTo] : edgeRanges) {
+            for (size_t e = edgeFrom; e < edgeTo; e++) {
+                auto connectedCursor = static_cast<size_t>(graph.edges[e].ref);
+                if (seen[connectedCursor] > segdepth) {
+                    float seglength = graph.lengths[connectedCursor];
+                    seen[connectedCursor] = segdepth;
+                    audittrail[connectedCursor] =
+                        TopoMetSegmentRef(static_cast<int>(connectedCursor), here.dir,
+                                          here.dist + seglength, here.ref);
+                    tree.parent[connectedCursor] = here.ref;
+                    // puts in a suitable bin ahead of us...
+                    open++;
+                    //
+                    if (graph.axialRefs[hereRef] == graph.axialRefs[connectedCursor]) {
+                        list[bin].push_back(static_cast<int>(connectedCursor));
+                        tree.cost[connectedCursor] = segdepth;
+                    } else {
+                        list[(bin + 1) % maxbin].push_back(static_cast<int>(connectedCursor));
+                        // this is so if another node is connected directly to this one but is
+                        // found later it is still handled
+                        seen[connectedCursor] = segdepth + 1;
+                        tree.cost[connectedCursor] = segdepth + 1;
+                    }
+                }
+            }
+        }
+    }
+    return tree;
+}
+
+AnalysisResult SegmentShortestPaths::run(Communicator *comm) {
+
+#if !defined(_OPENMP)
+    if (comm)
+        comm->logWarning("OpenMP NOT available, only running on a single core");
+    m_forceCommUpdatesMasterThread = false;
+#else
+    if (m_limitToThreads.has_value()) {
+        omp_set_num_threads(m_limitToThreads.value());
+    }
+#endif
+
+    AnalysisResult result;
+
+    size_t shapeCount = m_map.getShapeCount();
+
+    // segment indices of the query refs, and the queries grouped by origin so that each origin
+    // is only searched from once
+    std::vector<int> shapeRefs;
+    shapeRefs.reserve(shapeCount);
+    for (auto &shape : m_map.getAllShapes()) {
+        shapeRefs.push_back(shape.first);
+    }
+    auto getShapeIndex = [&shapeRefs](int ref) -> std::optional<size_t> {
+        auto it = std::lower_bound(shapeRefs.begin(), shapeRefs.end(), ref);
+        if (it == shapeRefs.end() || *it != ref) {
+            return std::nullopt;
+        }
+        return static_cast<size_t>(std::distance(shapeRefs.begin(), it));
+    };
+
+    m_paths.clear();
+    m_paths.reserve(m_queries.size());
+    std::map<size_t, std::vector<size_t>> originQueries;
+    for (size_t q = 0; q < m_queries.size(); q++) {
+        const Query &query = m_queries[q];
+        m_paths.emplace_back(query.refFrom, query.refTo);
+        auto from = getShapeIndex(query.refFrom);
+        auto to = getShapeIndex(query.refTo);
+        if (!from.has_value() || !to.has_value()) {
+            if (comm) {
+                comm->logWarning("Shortest path query from " + std::to_string(query.refFrom) +
+                                 " to " + std::to_string(query.refTo) +
+                                 " refers to a segment not in the map");
+            }
+            continue;
+        }
+        originQueries[*from].push_back(q);
+    }
+    std::vector<std::pair<size_t, std::vector<size_t>>> origins(originQueries.begin(),
+                                                                 originQueries.end());
+
+    time_t atime = 0;
+    if (comm) {
+        qtimer(atime, 0);
+        comm->CommPostMessage(Communicator::NUM_RECORDS, origins.size());
+    }
+
+    const SegmentGraph graph = compileGraph();
+
+    size_t count = 0;
+    auto n = static_cast<int>(origins.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        auto &[from, queries] = origins[static_cast<size_t>(i)];
+
+        std::vector<bool> destinations(shapeCount, false);
+        size_t destinationCount = 0;
+        for (size_t q : queries) {
+            auto to = *getShapeIndex(m_queries[q].refTo);
+            if (!destinations[to]) {
+                destinations[to] = true;
+                destinationCount++;
+            }
+        }
+
+        SearchTree tree(0);
+        switch (m_pathType) {
+        case PathType::ANGULAR:
+            tree = searchAngular(graph, from, destinations, destinationCount);
+            break;
+        case PathType::METRIC:
+            tree = searchMetric(graph, from, destinations, destinationCount);
+            break;
+        case PathType::TOPOLOGICAL:
+            tree = searchTopological(graph, from, destinations, destinationCount);
+            break;
+        }
+
+        // every query writes only to its own path
+        for (size_t q : queries) {
+            Path &path = m_paths[q];
+            auto to = *getShapeIndex(m_queries[q].refTo);
+            if (tree.cost[to] < 0) {
+                continue;
+            }
+            path.cost = tree.cost[to];
+            for (int cursor = static_cast<int>(to); cursor != -1;
+                 cursor = tree.parent[static_cast<size_t>(cursor)]) {
+                path.refs.push_back(shapeRefs[static_cast<size_t>(cursor)]);
+            }
+            std::reverse(path.refs.begin(), path.refs.end());
+        }
+
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+        count++; // <- increment count
+
+#if defined(_OPENMP)
+        // only executed by the main thread if requested
+        if (!m_forceCommUpdatesMasterThread || omp_get_thread_num() == 0)
+#endif
+            if (comm) {
+                if (qtimer(atime, 500)) {
+                    if (comm->IsCancelled()) {
+                        throw Communicator::CancelledException();
+                    }
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
+                }
+            }
+    }
+
+    if (m_aggregatePathCount) {
+        std::vector<size_t> pathCounts(shapeCount, 0);
+        for (auto &path : m_paths) {
+            for (int ref : path.refs) {
+                pathCounts[*getShapeIndex(ref)]++;
+            }
+        }
+        std::string pathCountColText = getPathCountColumn();
+        AttributeTable &attributes = m_map.getAttributeTable();
+        size_t pathCountCol = attributes.insertOrResetColumn(pathCountColText);
+        result.addAttribute(pathCountColText);
+        for (size_t i = 0; i < shapeCount; i++) {
+            m_map.getAttributeRowFromShapeIndex(i).setValue(pathCountCol,
+                                                            static_cast<float>(pathCounts[i]));
+        }
+    }
+
+    result.completed = true;
+
+    return result;
+}
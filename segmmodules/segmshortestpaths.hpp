@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "../ianalysis.hpp"
+#include "../shapegraph.hpp"
+
+#include <optional>
+#include <vector>
+
+// Many shortest path queries on the same segment map at once. The connections and segment lengths
+// are read from the map once for all queries, queries from the same origin share a single search,
+// and the searches run in parallel. Instead of a set of columns per query the paths are returned
+// compactly, and optionally the number of paths through every segment is written to a column
+
+class SegmentShortestPaths : public IAnalysis {
+  public:
+    enum class PathType {
+        ANGULAR,    // as SegmentTulipShortestPath
+        METRIC,     // as SegmentMetricShortestPath
+        TOPOLOGICAL // as SegmentTopologicalShortestPath
+    };
+
+    struct Query {
+        int refFrom, refTo;
+        Query(int from = -1, int to = -1) : refFrom(from), refTo(to) {}
+    };
+
+    struct Path {
+        int refFrom, refTo;
+        // angle, distance or depth of the destination as given by the single query analyses,
+        // -1 if it is not reachable from the origin
+        double cost;
+        // refs of the segments on the path, from the origin to the destination
+        std::vector<int> refs;
+        Path(int from = -1, int to = -1) : refFrom(from), refTo(to), cost(-1.0), refs() {}
+    };
+
+    struct Column {
+        inline static const std::string                                          //
+            ANGULAR_SHORTEST_PATH_COUNT = "Angular Shortest Path Count",         //
+            METRIC_SHORTEST_PATH_COUNT = "Metric Shortest Path Count",           //
+            TOPOLOGICAL_SHORTEST_PATH_COUNT = "Topological Shortest Path Count"; //
+    };
+
+  private:
+    ShapeGraph &m_map;
+    size_t m_tulipBins;
+    std::vector<Query> m_queries;
+    std::vector<Path> m_paths;
+    std::optional<int> m_limitToThreads;
+    PathType m_pathType;
+    bool m_aggregatePathCount;
+    bool m_forceCommUpdatesMasterThread = false;
+
+    [[maybe_unused]] unsigned _padding0 : 2 * 8;
+
+    // the connections of all segments, read once from the map. The edges of a segment are
+    // stored forward connections first, then back
+    struct SegmentEdge {
+        float angle;
+        int ref;
+        int8_t dir;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 3 * 8;
+
+      public:
+        SegmentEdge(float a = 0.0f, int r = -1, int8_t d = 0)
+            : angle(a), ref(r), dir(d), _padding0(0) {}
+    };
+    struct SegmentGraph {
+        std::vector<SegmentEdge> edges;
+        std::vector<size_t> firstEdge, firstBackEdge;
+        std::vector<float> lengths;
+        std::vector<int> axialRefs;
+        float maxLength = 0.0f;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
+      public:
+        SegmentGraph()
+            : edges(), firstEdge(), firstBackEdge(), lengths(), axialRefs(), _padding0(0) {}
+    };
+
+    // the cost and the previous segment on the path for every segment settled by a search
+    struct SearchTree {
+        std::vector<double> cost;
+        std::vector<int> parent;
+        SearchTree(size_t n) : cost(n, -1.0), parent(n, -1) {}
+    };
+
+    SegmentGraph compileGraph() const;
+    SearchTree searchAngular(const SegmentGraph &graph, size_t from,
+                             std::vector<bool> &destinations, size_t destinationCount) const;
+    SearchTree searchMetric(const SegmentGraph &graph, size_t from,
+                            std::vector<bool> &destinations, size_t destinationCount) const;
+    SearchTree searchTopological(const SegmentGraph &graph, size_t from,
+                                 std::vector<bool> &destinations, size_t destinationCount) const;
+
+  public:
+    SegmentShortestPaths(ShapeGraph &map, PathType pathType, std::vector<Query> queries,
+                         size_t tulipBins = 1024, bool aggregatePathCount = false,
+                         std::optional<int> limitToThreads = std::nullopt,
+                         bool forceCommUpdatesMasterThread = false)
+        : m_map(map), m_tulipBins(tulipBins), m_queries(std::move(queries)), m_paths(),
+          m_limitToThreads(limitToThreads), m_pathType(pathType),
+          m_aggregatePathCount(aggregatePathCount),
+          m_forceCommUpdatesMasterThread(forceCommUpdatesMasterThread), _padding0(0) {}
+    std::string getAnalysisName() const override { return "Segment Shortest Paths"; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // one path per query, in the order of the queries
+    const std::vector<Path> &getPaths() const { return m_paths; }
+    std::string getPathCountColumn() const {
+        switch (m_pathType) {
+        case PathType::ANGULAR:
+            return Column::ANGULAR_SHORTEST_PATH_COUNT;
+        case PathType::METRIC:
+            return Column::METRIC_SHORTEST_PATH_COUNT;
+        case PathType::TOPOLOGICAL:
+            return Column::TOPOLOGICAL_SHORTEST_PATH_COUNT;
+        }
+        return Column::METRIC_SHORTEST_PATH_COUNT;
+    }
+};
@@ -8,31 +8,15 @@
 
 #include "segmhelpers.hpp"
 
-AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool) {
-
-    AttributeTable &attributes = map.getAttributeTable();
+std::vector<float> SegmentTopologicalPD::traverse(const ShapeGraph &map,
+                                                  const std::vector<int> &axialrefs,
+                                                  const std::vector<float> &seglengths,
+                                                  const std::set<int> &originRefs) const {
 
-    AnalysisResult result;
-
-    // record axial line refs for topological analysis
-    std::vector<int> axialrefs;
-    // quick through to find the longest seg length
-    std::vector<float> seglengths;
-    float maxseglength = 0.0f;
-    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
-        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
-        axialrefs.push_back(static_cast<int>(row.getValue("Axial Line Ref")));
-        seglengths.push_back(row.getValue("Segment Length"));
-        if (seglengths.back() > maxseglength) {
-            maxseglength = seglengths.back();
-        }
-    }
+    std::vector<float> stepDepths(map.getShapeCount(), -1.0f);
 
     int maxbin = 2;
 
-    auto sdColIdx = attributes.insertOrResetColumn(Column::TOPOLOGICAL_STEP_DEPTH);
-    result.addAttribute(Column::TOPOLOGICAL_STEP_DEPTH);
-
     std::vector<unsigned int> seen(map.getShapeCount());
     std::vector<TopoMetSegmentRef> audittrail(map.getShapeCount());
     std::vector<int> list[512]; // 512 bins!
@@ -41,14 +25,14 @@ AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool)
     for (size_t i = 0; i < map.getShapeCount(); i++) {
         seen[i] = 0xffffffff;
     }
-    for (auto &cursor : m_originRefs) {
+    for (auto &cursor : originRefs) {
         seen[static_cast<size_t>(cursor)] = 0;
         open++;
         double length = seglengths[static_cast<size_t>(cursor)];
         audittrail[static_cast<size_t>(cursor)] =
             TopoMetSegmentRef(cursor, Connector::SEG_CONN_ALL, length * 0.5, -1);
         list[0].push_back(cursor);
-        attributes.getRow(AttributeKey(cursor)).setValue(sdColIdx, 0);
+        stepDepths[static_cast<size_t>(cursor)] = 0;
     }
 
     unsigned int segdepth = 0;
@@ -73,7 +57,7 @@ AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool)
             here.done = true;
         }
 
-        Connector &axline = map.getConnections().at(static_cast<size_t>(here.ref));
+        const Connector &axline = map.getConnections().at(static_cast<size_t>(here.ref));
         int connectedCursor = -2;
 
         auto iter = axline.backSegconns.begin();
@@ -89,8 +73,6 @@ AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool)
             }
 
             connectedCursor = iter->first.ref;
-            AttributeRow &row =
-                map.getAttributeRowFromShapeIndex(static_cast<size_t>(connectedCursor));
             if (seen[static_cast<size_t>(connectedCursor)] > segdepth) {
                 float length = seglengths[static_cast<size_t>(connectedCursor)];
                 int axialref = axialrefs[static_cast<size_t>(connectedCursor)];
@@ -102,20 +84,75 @@ AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool)
                 //
                 if (axialrefs[static_cast<size_t>(here.ref)] == axialref) {
                     list[bin].push_back(connectedCursor);
-                    row.setValue(sdColIdx, static_cast<float>(segdepth));
+                    stepDepths[static_cast<size_t>(connectedCursor)] =
+                        static_cast<float>(segdepth);
                 } else {
                     list[(bin + 1) % 2].push_back(connectedCursor);
                     seen[static_cast<size_t>(connectedCursor)] =
                         segdepth + 1; // this is so if another node is connected directly to this
                                       // one but is found later it is still handled -- note it can
                                       // result in the connected cursor being added twice
-                    row.setValue(sdColIdx, static_cast<float>(segdepth + 1));
+                    stepDepths[static_cast<size_t>(connectedCursor)] =
+                        static_cast<float>(segdepth + 1);
                 }
             }
             iter++;
         }
     }
 
+    return stepDepths;
+}
+
+AnalysisResult SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool) {
+
+    AttributeTable &attributes = map.getAttributeTable();
+
+    AnalysisResult result;
+
+    // record axial line refs for topological analysis
+    std::vector<int> axialrefs;
+    // quick through to find the longest seg length
+    std::vector<float> seglengths;
+    float maxseglength = 0.0f;
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        axialrefs.push_back(static_cast<int>(row.getValue("Axial Line Ref")));
+        seglengths.push_back(row.getValue("Segment Length"));
+        if (seglengths.back() > maxseglength) {
+            maxseglength = seglengths.back();
+        }
+    }
+
+    std::vector<const std::set<int> *> originSets;
+    std::vector<size_t> sdColIdxs;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        std::string sdColText = getOriginSetColumn(Column::TOPOLOGICAL_STEP_DEPTH, originSetName);
+        sdColIdxs.push_back(attributes.insertOrResetColumn(sdColText));
+        result.addAttribute(sdColText);
+        originSets.push_back(&originRefs);
+    }
+
+    std::vector<std::vector<float>> stepDepths(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        stepDepths[static_cast<size_t>(i)] =
+            traverse(map, axialrefs, seglengths, *originSets[static_cast<size_t>(i)]);
+    }
+
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        for (size_t i = 0; i < originSets.size(); i++) {
+            if (stepDepths[i][cursor] >= 0) {
+                row.setValue(sdColIdxs[i], stepDepths[i][cursor]);
+            }
+        }
+    }
+
     result.completed = true;
 
     return result;
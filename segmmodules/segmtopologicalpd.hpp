@@ -9,7 +9,12 @@
 #include "../isegment.hpp"
 
 class SegmentTopologicalPD : ISegment {
-    std::set<int> m_originRefs;
+    // named sets of origins, each given its own step depth column
+    std::map<std::string, std::set<int>> m_originSets;
+
+    std::vector<float> traverse(const ShapeGraph &map, const std::vector<int> &axialrefs,
+                                const std::vector<float> &seglengths,
+                                const std::set<int> &originRefs) const;
 
   public:
     struct Column {
@@ -18,7 +23,10 @@ class SegmentTopologicalPD : ISegment {
     };
 
   public:
-    SegmentTopologicalPD(std::set<int> originRefs) : m_originRefs(std::move(originRefs)) {}
+    SegmentTopologicalPD(std::set<int> originRefs) : m_originSets({{"", std::move(originRefs)}}) {}
+    // one search per set, run in parallel, sharing the reading of the map
+    SegmentTopologicalPD(std::map<std::string, std::set<int>> originSets)
+        : m_originSets(std::move(originSets)) {}
     std::string getAnalysisName() const override { return "Topological Analysis"; }
     AnalysisResult run(Communicator *, ShapeGraph &map, bool) override;
 };
@@ -6,8 +6,12 @@
 
 #include "segmtulip.hpp"
 
+#include "../genlib/containerutils.hpp"
+#include "../genlib/dependencysweep.hpp"
 #include "../genlib/stringutils.hpp"
 
+#include <queue>
+
 std::vector<std::string> SegmentTulip::getRequiredColumns(ShapeGraph &map,
                                                           std::vector<double> radii) {
     std::vector<std::string> newColumns;
@@ -183,10 +187,87 @@ std::vector<std::string> SegmentTulip::getRequiredColumns(ShapeGraph &map,
                 }
             }
         }
+        if (m_choice && m_sourceSampling.has_value()) {
+            addColumn(Column::CHOICE_STD_ERROR, radius, m_selSet.has_value(), routeweightColText);
+        }
     }
     return newColumns;
 }
 
+// The roots whose search may reach one of the changed segments within the largest radius. A
+// search reaching a segment costs at least as much as the cheapest path to it with every
+// connection taken at the cheaper of its two directions (or its only one, for one way links), so
+// the roots are found with a single search outwards from the changed segments over these costs.
+// Only the roots found this way can have their searches changed by the edit
+std::set<int> SegmentTulip::findAffectedRoots(ShapeGraph &map, double maxRadius, int tulipBins,
+                                              const std::vector<float> &lengths,
+                                              const std::vector<float> &routeweights) {
+    auto &connections = map.getConnections();
+    auto nconnections = connections.size();
+
+    // the smallest angle of the connections between every pair of segments, both ways
+    std::vector<std::map<size_t, float>> neighbours(nconnections);
+    for (size_t i = 0; i < nconnections; i++) {
+        for (auto *segconns : {&connections[i].forwardSegconns, &connections[i].backSegconns}) {
+            for (auto &segconn : *segconns) {
+                auto j = static_cast<size_t>(segconn.first.ref);
+                for (auto [from, to] : {std::make_pair(i, j), std::make_pair(j, i)}) {
+                    auto it = neighbours[from].find(to);
+                    if (it == neighbours[from].end()) {
+                        neighbours[from].emplace(to, segconn.second);
+                    } else {
+                        it->second = std::min(it->second, segconn.second);
+                    }
+                }
+            }
+        }
+    }
+    auto stepCost = [&](size_t from, size_t to, float angle) {
+        switch (m_radiusType) {
+        case RadiusType::ANGULAR:
+            return floor(angle * static_cast<float>(tulipBins) * 0.5 *
+                         std::min(routeweights[from], routeweights[to]));
+        case RadiusType::METRIC:
+            return 0.5 * (lengths[from] + lengths[to]);
+        case RadiusType::TOPOLOGICAL:
+            return 1.0;
+        case RadiusType::NONE:
+            break;
+        }
+        return 0.0;
+    };
+    // metric depths are accumulated in single precision by the analysis
+    double radiusLimit = maxRadius + 1e-6 * (1.0 + maxRadius);
+
+    std::vector<double> cost(nconnections, -1.0);
+    using QueueItem = std::pair<double, size_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    for (auto idx :
+         genlib::findIndicesFromKeys(map.getAllShapes(), m_incrementalUpdate->changedRefs)) {
+        queue.emplace(0.0, idx);
+    }
+    std::set<int> affectedRefs;
+    while (!queue.empty()) {
+        auto [depth, idx] = queue.top();
+        queue.pop();
+        if (cost[idx] != -1.0) {
+            continue;
+        }
+        cost[idx] = depth;
+        affectedRefs.insert(map.getShapeRefFromIndex(idx)->first);
+        for (auto &[next, angle] : neighbours[idx]) {
+            if (cost[next] != -1.0) {
+                continue;
+            }
+            double nextDepth = depth + stepCost(idx, next, angle);
+            if (maxRadius == -1.0 || nextDepth <= radiusLimit) {
+                queue.emplace(nextDepth, next);
+            }
+        }
+    }
+    return affectedRefs;
+}
+
 AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     AnalysisResult result;
@@ -210,6 +291,23 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         return result;
     }
 
+    if (m_selSet.has_value() && m_sourceSampling.has_value()) {
+        if (comm) {
+            comm->logError("Source sampling is not available when running on selected segments");
+        }
+        return result;
+    }
+
+    if (m_incrementalUpdate.has_value() &&
+        (m_selSet.has_value() || m_sourceSampling.has_value())) {
+        if (comm) {
+            comm->logError("Incremental updates are only available for runs on all segments");
+        }
+        return result;
+    }
+    bool incremental = m_incrementalUpdate.has_value();
+    bool retracting = incremental && m_incrementalUpdate->pass == IncrementalPass::RETRACT;
+
     // TODO: Understand what these parameters do. They were never truly provided in the original
     // function
     int weightingCol2 = m_weightedMeasureCol2;
@@ -302,14 +400,24 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     auto newColumns = getRequiredColumns(map, radiusUnconverted);
     for (auto &col : newColumns) {
-        attributes.insertOrResetColumn(col);
+        if (incremental) {
+            // the columns of the previous run are updated in place
+            if (!attributes.hasColumn(col)) {
+                if (comm) {
+                    comm->logError("Incremental updates require the columns of a previous run");
+                }
+                return result;
+            }
+        } else {
+            attributes.insertOrResetColumn(col);
+        }
         result.addAttribute(col);
     }
 
     std::string tulipText = std::string("T") + dXstring::formatString(tulipBins, "%d");
 
     std::vector<size_t> choiceCol, wChoiceCol, wChoiceCol2, countCol, integCol, wIntegCol, tdCol,
-        wTdCol, totalWeightCol;
+        wTdCol, totalWeightCol, choiceErrorCol;
 
     bool doNonChoiceMetrics = !m_selSet.has_value();
 
@@ -355,6 +463,12 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                 }
                 //*EFEF
             }
+            if (m_sourceSampling.has_value()) {
+                choiceErrorCol.push_back(getFormattedColumnIdx( //
+                    attributes, Column::CHOICE_STD_ERROR, m_tulipBins, m_radiusType, radius,
+                    m_selSet.has_value(),
+                    routeweightCol != -1 ? std::make_optional(routeweightColText) : std::nullopt));
+            }
         }
 
         if (doNonChoiceMetrics) {
@@ -447,11 +561,89 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         lengths.push_back(row.getValue(lengthCol));
     }
 
+    std::vector<bool> affectedRoots;
+    if (incremental) {
+        if (retracting) {
+            m_affectedRefs =
+                findAffectedRoots(map, radius.back(), tulipBins, lengths, routeweights);
+        }
+        affectedRoots.resize(nconnections, false);
+        for (auto idx : genlib::findIndicesFromKeys(map.getAllShapes(), m_affectedRefs)) {
+            affectedRoots[idx] = true;
+        }
+    }
+
     int radiusmask = 0;
     for (size_t i = 0; i < nradii; i++) {
         radiusmask |= (1 << i);
     }
 
+    // for choice accumulated in one reverse sweep per root, each direction of each segment is a
+    // node of its own (ref * 2 + direction index) and every radius has its own search tree
+    // (sampled choice is always accumulated this way, as it is scaled per root)
+    bool sampling = m_sourceSampling.has_value();
+    bool sweepChoice =
+        m_choice && (m_choiceAccumulation != ChoiceAccumulation::BACKTRACK || sampling);
+    bool allPaths = m_choice && m_choiceAccumulation == ChoiceAccumulation::ALL_PATHS;
+    std::vector<genlib::DependencySweep> sweeps(sweepChoice ? nradii : 0,
+                                                genlib::DependencySweep(nconnections * 2));
+    std::vector<bool> sweepTarget(sweepChoice ? nconnections * 2 : 0, false);
+
+    // for source sampling, the measures of every segment are estimated from the searches of the
+    // sampled roots that reach it (assuming depth is the same both ways), per segment and radius
+    SampledRoots sampledRoots;
+    std::vector<double> sampledNodeCount, sampledTotalDepth, sampledTotalWeight,
+        sampledTotalWeightedDepth, sampledChoiceSquares, rootChoice;
+    if (sampling) {
+        sampledRoots = SampledRoots::draw(*m_sourceSampling, nconnections, weights);
+        sampledNodeCount.resize(nconnections * nradii, 0.0);
+        sampledTotalDepth.resize(nconnections * nradii, 0.0);
+        sampledTotalWeight.resize(nconnections * nradii, 0.0);
+        sampledTotalWeightedDepth.resize(nconnections * nradii, 0.0);
+        if (m_choice) {
+            sampledChoiceSquares.resize(nconnections * nradii, 0.0);
+            rootChoice.resize(nconnections, 0.0);
+        }
+    }
+
+    auto setIntegrationValues = [&](AttributeRow &row, size_t k, double nodeCount,
+                                    double totalDepth, double totalWeight,
+                                    double totalWeightedDepth) {
+        double totalDepthConv = totalDepth / (static_cast<float>(tulipBins - 1) * 0.5f);
+        double totalWeightedDepthConv =
+            totalWeightedDepth / (static_cast<float>(tulipBins - 1) * 0.5f);
+        //
+        row.setValue(countCol[k], static_cast<float>(nodeCount));
+        if (nodeCount > 1) {
+            // for dmap 8 and above, mean depth simply isn't calculated as for radius
+            // measures it is meaningless
+            row.setValue(tdCol[k], static_cast<float>(totalDepthConv));
+            if (m_weightedMeasureCol != -1) {
+                row.setValue(totalWeightCol[k], static_cast<float>(totalWeight));
+                row.setValue(wTdCol[k], static_cast<float>(totalWeightedDepthConv));
+            }
+        } else {
+            row.setValue(tdCol[k], -1);
+            if (m_weightedMeasureCol != -1) {
+                row.setValue(totalWeightCol[k], -1.0f);
+                row.setValue(wTdCol[k], -1.0f);
+            }
+        }
+        // for dmap 10 an above, integration is included!
+        if (totalDepthConv > 1e-9) {
+            row.setValue(integCol[k], static_cast<float>(nodeCount * nodeCount / totalDepthConv));
+            if (m_weightedMeasureCol != -1) {
+                row.setValue(wIntegCol[k], static_cast<float>(totalWeight * totalWeight /
+                                                              totalWeightedDepthConv));
+            }
+        } else {
+            row.setValue(integCol[k], -1);
+            if (m_weightedMeasureCol != -1) {
+                row.setValue(wIntegCol[k], -1.0f);
+            }
+        }
+    };
+
     for (size_t cursor = 0; cursor < nconnections; cursor++) {
         auto &shapeRef = map.getShapeRefFromIndex(cursor)->first;
         AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(shapeRef));
@@ -464,6 +656,13 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                 continue;
             }
         }
+        if (sampling && !sampledRoots.isSampled(cursor)) {
+            continue;
+        }
+        if (incremental && !affectedRoots[cursor]) {
+            continue;
+        }
+        double rootScale = sampling ? sampledRoots.rootScale(cursor) : 1.0;
 
         for (int k = 0; k < tulipBins; k++) {
             bins[static_cast<size_t>(k)].clear();
@@ -480,6 +679,12 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         double rootseglength = row.getValue(lengthCol);
         double rootweight = (m_weightedMeasureCol != -1) ? weights[cursor] : 0.0;
 
+        for (auto &sweep : sweeps) {
+            sweep.reset();
+            sweep.settleRoot(cursor * 2);
+            sweep.settleRoot(cursor * 2 + 1);
+        }
+
         // setup: direction 0 (both ways), segment i, previous -1, segdepth (step depth) 0,
         // metricdepth 0.5 * rootseglength, bin 0
         SegmentData segmentData(0, static_cast<int>(cursor), SegmentRef(), 0,
@@ -510,6 +715,18 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
             int ref = lineindex.ref;
             int dir = (lineindex.dir == 1) ? 0 : 1;
+            if (allPaths && lineindex.previous.ref != -1 && ref != static_cast<int>(cursor)) {
+                // arriving again at the depth the segment was settled at is another shortest path
+                auto tied = lineindex.coverage & ~uncovered[ref][dir];
+                for (size_t k = 0; k < nradii; k++) {
+                    if (((tied >> k) & 0x1) == 1 && audittrail[ref][k][dir].depth == depthlevel) {
+                        sweeps[k].addPredecessor(
+                            static_cast<size_t>(ref * 2 + dir),
+                            static_cast<size_t>(lineindex.previous.ref * 2 +
+                                                ((lineindex.previous.dir == 1) ? 0 : 1)));
+                    }
+                }
+            }
             auto coverage = lineindex.coverage & uncovered[ref][dir];
             if (coverage != 0) {
                 int rbin = 0;
@@ -527,6 +744,12 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                             audittrail[lineindex.previous.ref][rbin]
                                       [(lineindex.previous.dir == 1) ? 0 : 1]
                                           .leaf = false;
+                            if (sweepChoice) {
+                                sweeps[static_cast<size_t>(rbin)].settle(
+                                    static_cast<size_t>(ref * 2 + dir),
+                                    static_cast<size_t>(lineindex.previous.ref * 2 +
+                                                        ((lineindex.previous.dir == 1) ? 0 : 1)));
+                            }
                         }
                         rbin++;
                     }
@@ -694,8 +917,21 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                     cursTotalDepth += adtr[dir].depth;
                     cursTotalWeight += weights[j];
                     cursTotalWeightedDepth += static_cast<float>(adtr[dir].depth) * weights[j];
+                    if (sampling) {
+                        // this root as seen from segment j
+                        size_t sampleIdx = j * nradii + k;
+                        sampledNodeCount[sampleIdx] += rootScale;
+                        sampledTotalDepth[sampleIdx] += rootScale * adtr[dir].depth;
+                        sampledTotalWeight[sampleIdx] += rootScale * weights[cursor];
+                        sampledTotalWeightedDepth[sampleIdx] +=
+                            rootScale * static_cast<float>(adtr[dir].depth) * weights[cursor];
+                    }
                     //
-                    if (m_choice && (!m_forceLeafChoice || (m_forceLeafChoice && adtr[dir].leaf))) {
+                    if (sweepChoice && (!m_forceLeafChoice || adtr[dir].leaf) && j != cursor) {
+                        sweepTarget[j * 2 + static_cast<size_t>(dir)] = true;
+                    }
+                    if (m_choice && !sweepChoice &&
+                        (!m_forceLeafChoice || (m_forceLeafChoice && adtr[dir].leaf))) {
                         // note, graph may be directed (e.g., for one way streets), so both ways
                         // must be included from now on:
                         SegmentRef here = SegmentRef(dir == 0 ? 1 : -1, static_cast<int>(j));
@@ -770,42 +1006,77 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                     }
                 }
             }
-            if (!m_selSet.has_value()) {
-                double totalDepthConv = cursTotalDepth / (static_cast<float>(tulipBins - 1) * 0.5f);
-                double totalWeightedDepthConv =
-                    cursTotalWeightedDepth / (static_cast<float>(tulipBins - 1) * 0.5f);
-                //
-                row.setValue(countCol[k], static_cast<float>(cursNodeCount));
-                if (cursNodeCount > 1) {
-                    // for dmap 8 and above, mean depth simply isn't calculated as for radius
-                    // measures it is meaningless
-                    row.setValue(tdCol[k], static_cast<float>(totalDepthConv));
-                    if (m_weightedMeasureCol != -1) {
-                        row.setValue(totalWeightCol[k], static_cast<float>(cursTotalWeight));
-                        row.setValue(wTdCol[k], static_cast<float>(totalWeightedDepthConv));
-                    }
-                } else {
-                    row.setValue(tdCol[k], -1);
-                    if (m_weightedMeasureCol != -1) {
-                        row.setValue(totalWeightCol[k], -1.0f);
-                        row.setValue(wTdCol[k], -1.0f);
+            if (sweepChoice) {
+                // push the targets of all paths from this root back towards it at once. When
+                // following a single path, the segments passed on the way to a target become
+                // targets themselves, as they do when walking each path back
+                auto &sweep = sweeps[k];
+                auto isRoot = [cursor](size_t node) { return node / 2 == cursor; };
+                sweep.accumulate([&](size_t node) { return sweepTarget[node] ? 1.0 : 0.0; },
+                                 [&](size_t node, double dependency) {
+                                     if (isRoot(node)) {
+                                         return;
+                                     }
+                                     if (!allPaths && dependency > 0.0) {
+                                         sweepTarget[node] = true;
+                                     }
+                                     audittrail[node / 2][k][node % 2].choice +=
+                                         rootScale * dependency;
+                                     if (sampling) {
+                                         rootChoice[node / 2] += dependency;
+                                     }
+                                 });
+                if (sampling) {
+                    // keep the spread of the extrapolated contributions of the roots
+                    double drawScale = sampledRoots.drawScale[cursor];
+                    for (auto node : sweep.getSettleOrder()) {
+                        double &contribution = rootChoice[node / 2];
+                        sampledChoiceSquares[node / 2 * nradii + k] +=
+                            sampledRoots.multiplicity[cursor] * (drawScale * contribution) *
+                            (drawScale * contribution);
+                        contribution = 0.0;
                     }
                 }
-                // for dmap 10 an above, integration is included!
-                if (totalDepthConv > 1e-9) {
-                    row.setValue(integCol[k], static_cast<float>(cursNodeCount * cursNodeCount /
-                                                                 totalDepthConv));
-                    if (m_weightedMeasureCol != -1) {
-                        row.setValue(wIntegCol[k],
-                                     static_cast<float>(cursTotalWeight * cursTotalWeight /
-                                                        totalWeightedDepthConv));
-                    }
-                } else {
-                    row.setValue(integCol[k], -1);
-                    if (m_weightedMeasureCol != -1) {
-                        row.setValue(wIntegCol[k], -1.0f);
+                if (m_weightedMeasureCol != -1) {
+                    auto accumulateWeighted = [&](const std::vector<float> &targetWeights,
+                                                  double AnalysisInfo::*weightedChoice) {
+                        // note, for weighted choice, the start and end points have choice added
+                        // to them
+                        double rootWeightedChoice = 0.0;
+                        sweep.accumulate(
+                            [&](size_t node) {
+                                return sweepTarget[node] ? targetWeights[node / 2] * rootweight
+                                                         : 0.0;
+                            },
+                            [&](size_t node, double dependency) {
+                                if (isRoot(node)) {
+                                    return;
+                                }
+                                auto &adt = audittrail[node / 2][k][node % 2];
+                                adt.*weightedChoice += rootScale * dependency;
+                                if (sweepTarget[node]) {
+                                    adt.*weightedChoice +=
+                                        rootScale * (targetWeights[node / 2] * rootweight) / 2.0;
+                                    rootWeightedChoice +=
+                                        rootScale * (targetWeights[node / 2] * rootweight) / 2.0;
+                                }
+                            });
+                        audittrail[cursor][k][0].*weightedChoice += rootWeightedChoice;
+                    };
+                    accumulateWeighted(weights, &AnalysisInfo::weightedChoice);
+                    // EFEF*
+                    if (weightingCol2 != -1) {
+                        accumulateWeighted(weights2, &AnalysisInfo::weightedChoice2);
                     }
+                    //*EFEF
                 }
+                for (auto node : sweep.getSettleOrder()) {
+                    sweepTarget[node] = false;
+                }
+            }
+            if (!m_selSet.has_value() && !sampling && !retracting) {
+                setIntegrationValues(row, k, cursNodeCount, cursTotalDepth, cursTotalWeight,
+                                     cursTotalWeightedDepth);
             }
         }
         //
@@ -835,6 +1106,26 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
             }
         }
     }
+    if (sampling) {
+        for (size_t cursor = 0; cursor < nconnections; cursor++) {
+            auto &shapeRef = map.getShapeRefFromIndex(cursor)->first;
+            AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(shapeRef));
+            for (size_t k = 0; k < nradii; k++) {
+                size_t sampleIdx = cursor * nradii + k;
+                setIntegrationValues(row, k, sampledNodeCount[sampleIdx],
+                                     sampledTotalDepth[sampleIdx], sampledTotalWeight[sampleIdx],
+                                     sampledTotalWeightedDepth[sampleIdx]);
+            }
+        }
+    }
+    // incremental updates take the choice of the affected roots out of the previous values, or
+    // add it back to them
+    auto setChoiceValue = [&](AttributeRow &row, size_t col, double value) {
+        if (incremental) {
+            value = row.getValue(col) + (retracting ? -value : value);
+        }
+        row.setValue(col, static_cast<float>(value));
+    };
     if (m_choice) {
         for (size_t cursor = 0; cursor < nconnections; cursor++) {
             auto &shapeRef = map.getShapeRefFromIndex(cursor)->first;
@@ -860,12 +1151,17 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                 // divide by 2 for the new implementation
                 //
                 //
-                row.setValue(choiceCol[r], static_cast<float>(totalChoice));
+                setChoiceValue(row, choiceCol[r], totalChoice);
+                if (sampling) {
+                    row.setValue(choiceErrorCol[r],
+                                 static_cast<float>(sampledRoots.standardError(
+                                     totalChoice, sampledChoiceSquares[cursor * nradii + r])));
+                }
                 if (m_weightedMeasureCol != -1) {
-                    row.setValue(wChoiceCol[r], static_cast<float>(totalWeightedChoice));
+                    setChoiceValue(row, wChoiceCol[r], totalWeightedChoice);
                     // EFEF*
                     if (weightingCol2 != -1) {
-                        row.setValue(wChoiceCol2[r], static_cast<float>(totalWeightedChoice2));
+                        setChoiceValue(row, wChoiceCol2[r], totalWeightedChoice2);
                     }
                     //*EFEF
                 }
@@ -882,7 +1178,15 @@ AnalysisResult SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     delete[] audittrail;
     delete[] uncovered;
 
-    result.completed = processedRows > 0;
+    if (incremental) {
+        if (retracting) {
+            m_incrementalUpdate->pass = IncrementalPass::APPLY;
+        } else {
+            m_incrementalUpdate.reset();
+        }
+    }
+
+    result.completed = processedRows > 0 || incremental;
 
     return result;
 }
@@ -6,12 +6,39 @@
 
 #pragma once
 
+#include "../choiceaccumulation.hpp"
 #include "../isegment.hpp"
 
+#include "segmsampling.hpp"
+
 class SegmentTulip : ISegment {
+  public:
+    // The two runs of an incremental update, before and after the connections are edited
+    enum class IncrementalPass {
+        RETRACT, // takes the choice of the affected roots out of the previous results
+        APPLY    // recomputes the affected roots and adds their choice back
+    };
+
   private:
+    struct IncrementalUpdate {
+        std::set<int> changedRefs;
+        IncrementalPass pass;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
+      public:
+        IncrementalUpdate(std::set<int> changed)
+            : changedRefs(std::move(changed)), pass(IncrementalPass::RETRACT), _padding0(0) {}
+    };
+
     std::set<double> m_radiusSet;
     std::optional<std::set<int>> m_selSet;
+    std::optional<SourceSampling> m_sourceSampling = std::nullopt;
+    std::optional<IncrementalUpdate> m_incrementalUpdate = std::nullopt;
+    // found in the RETRACT run and kept for the APPLY run, so that choice is taken out and put
+    // back for the same roots
+    std::set<int> m_affectedRefs;
     int m_tulipBins;
     int m_weightedMeasureCol;
     int m_weightedMeasureCol2;
@@ -24,6 +51,10 @@ class SegmentTulip : ISegment {
     // Forces choice to only be calculated from leaf nodes
     bool m_forceLeafChoice = false;
 
+    ChoiceAccumulation m_choiceAccumulation = ChoiceAccumulation::BACKTRACK;
+
+    [[maybe_unused]] unsigned _padding0 : 4 * 8;
+
     // used during angular analysis
     struct AnalysisInfo {
         // lists used for multiple radius analysis
@@ -55,12 +86,13 @@ class SegmentTulip : ISegment {
 
   public:
     struct Column {
-        inline static const std::string  //
-            CHOICE = "Choice",           //
-            INTEGRATION = "Integration", //
-            NODE_COUNT = "Node Count",   //
-            TOTAL_DEPTH = "Total Depth", //
-            TOTAL = "Total";             //
+        inline static const std::string             //
+            CHOICE = "Choice",                      //
+            CHOICE_STD_ERROR = "Choice Std. Error", //
+            INTEGRATION = "Integration",            //
+            NODE_COUNT = "Node Count",              //
+            TOTAL_DEPTH = "Total Depth",            //
+            TOTAL = "Total";                        //
     };
     static std::string
     getFormattedColumn(const std::string &column, int tulipBins, RadiusType radiusType,
@@ -120,19 +152,43 @@ class SegmentTulip : ISegment {
 
   private:
     std::vector<std::string> getRequiredColumns(ShapeGraph &map, std::vector<double> radii);
+    std::set<int> findAffectedRoots(ShapeGraph &map, double maxRadius, int tulipBins,
+                                    const std::vector<float> &lengths,
+                                    const std::vector<float> &routeweights);
 
   public:
     SegmentTulip(std::set<double> radiusSet, std::optional<std::set<int>> selSet, int tulipBins,
                  int weightedMeasureCol, RadiusType radiusType, bool choice,
                  int weightedMeasureCol2 = -1, int routeweightCol = -1, bool interactive = false)
-        : m_radiusSet(std::move(radiusSet)), m_selSet(std::move(selSet)), m_tulipBins(tulipBins),
-          m_weightedMeasureCol(weightedMeasureCol), m_weightedMeasureCol2(weightedMeasureCol2),
-          m_routeweightCol(routeweightCol), m_radiusType(radiusType), m_choice(choice),
-          m_interactive(interactive) {}
+        : m_radiusSet(std::move(radiusSet)), m_selSet(std::move(selSet)), m_affectedRefs(),
+          m_tulipBins(tulipBins), m_weightedMeasureCol(weightedMeasureCol),
+          m_weightedMeasureCol2(weightedMeasureCol2), m_routeweightCol(routeweightCol),
+          m_radiusType(radiusType), m_choice(choice), m_interactive(interactive), _padding0(0) {}
     void setForceLegacyColumnOrder(bool forceLegacyColumnOrder) {
         m_forceLegacyColumnOrder = forceLegacyColumnOrder;
     }
     void setForceLeafChoice(bool forceLeafChoice) { m_forceLeafChoice = forceLeafChoice; }
+    void setChoiceAccumulation(ChoiceAccumulation choiceAccumulation) {
+        m_choiceAccumulation = choiceAccumulation;
+    }
+    // Only run searches from a sample of the roots and extrapolate choice and integration
+    // from them. The standard error of the choice estimate is given in an extra column
+    void setSourceSampling(SourceSampling sourceSampling) { m_sourceSampling = sourceSampling; }
+    // Update the results of a previous full run after the connections of some segments have
+    // been edited (through linking and unlinking, so that the segments keep their indices).
+    // Only the roots whose searches reach a changed segment are run again. The analysis has
+    // to be run twice: once before the edit, where the choice these roots gave is subtracted,
+    // and once after, where their measures are recomputed and their new choice is added. The
+    // changed segments are those at both ends of every link added or removed
+    void setIncrementalUpdate(std::set<int> changedRefs) {
+        m_incrementalUpdate = IncrementalUpdate(std::move(changedRefs));
+    }
+    std::optional<IncrementalPass> getIncrementalPass() const {
+        return m_incrementalUpdate.has_value() ? std::make_optional(m_incrementalUpdate->pass)
+                                               : std::nullopt;
+    }
+    // the roots run again by the last incremental update
+    const std::set<int> &getAffectedRefs() const { return m_affectedRefs; }
     std::string getAnalysisName() const override { return "Tulip Analysis"; }
     AnalysisResult run(Communicator *comm, ShapeGraph &map, bool) override;
 };
@@ -8,14 +8,11 @@
 
 // revised to use tulip bins for faster analysis of large spaces
 
-AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
-
-    AttributeTable &attributes = map.getAttributeTable();
+std::vector<float> SegmentTulipDepth::traverse(const ShapeGraph &map,
+                                               const std::set<int> &originRefs,
+                                               uint64_t seed) const {
 
-    AnalysisResult result;
-
-    auto stepdepthCol = attributes.insertOrResetColumn(Column::ANGULAR_STEP_DEPTH);
-    result.addAttribute(Column::ANGULAR_STEP_DEPTH);
+    std::vector<float> stepDepths(map.getShapeCount(), -1.0f);
 
     // The original code set tulip_bins to 1024, divided by two and added one
     // in order to duplicate previous code (using a semicircle of tulip bins)
@@ -28,8 +25,8 @@ AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
     std::vector<std::vector<SegmentData>> bins(tulipBins);
 
     int opencount = 0;
-    for (auto &sel : m_originRefs) {
-        int row = genlib::getMapAtIndex(map.getAllShapes(), static_cast<size_t>(sel))->first;
+    for (auto &sel : originRefs) {
+        int row = map.getShapeRefFromIndex(static_cast<size_t>(sel))->first;
         if (row != -1) {
             bins[0].push_back(SegmentData(0, row, SegmentRef(), 0, 0.0, 0));
             opencount++;
@@ -38,6 +35,7 @@ AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
     int depthlevel = 0;
     auto binIter = bins.begin();
     int currentbin = 0;
+    uint64_t picks = 0;
     while (opencount) {
         while (binIter->empty()) {
             depthlevel++;
@@ -51,8 +49,8 @@ AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
         if (binIter->size() > 1) {
             // it is slightly slower to delete from an arbitrary place in the bin,
             // but it is necessary to use random paths to even out the number of times through equal
-            // paths
-            auto curr = static_cast<int>(pafmath::pafrand() % binIter->size());
+            // paths (drawn from a stream of the search so that searches can run in parallel)
+            auto curr = static_cast<int>(pafmath::counterrand(seed, picks++) % binIter->size());
             auto currIter = binIter->begin() + curr;
             lineindex = *currIter;
             binIter->erase(currIter);
@@ -64,12 +62,11 @@ AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
         opencount--;
         if (!covered[static_cast<size_t>(lineindex.ref)]) {
             covered[static_cast<size_t>(lineindex.ref)] = true;
-            Connector &line = map.getConnections()[static_cast<size_t>(lineindex.ref)];
+            const Connector &line = map.getConnections()[static_cast<size_t>(lineindex.ref)];
             // convert depth from tulip_bins normalised to standard angle
             // (note the -1)
             double depthToLine = depthlevel / (static_cast<float>(tulipBins - 1) * 0.5);
-            map.getAttributeRowFromShapeIndex(static_cast<size_t>(lineindex.ref))
-                .setValue(stepdepthCol, static_cast<float>(depthToLine));
+            stepDepths[static_cast<size_t>(lineindex.ref)] = static_cast<float>(depthToLine);
             int extradepth;
             if (lineindex.dir != -1) {
                 for (auto &segconn : line.forwardSegconns) {
@@ -104,6 +101,46 @@ AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
         }
     }
 
+    return stepDepths;
+}
+
+AnalysisResult SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
+
+    AttributeTable &attributes = map.getAttributeTable();
+
+    AnalysisResult result;
+
+    std::vector<const std::set<int> *> originSets;
+    std::vector<size_t> stepdepthCols;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        std::string stepdepthColText =
+            getOriginSetColumn(Column::ANGULAR_STEP_DEPTH, originSetName);
+        stepdepthCols.push_back(attributes.insertOrResetColumn(stepdepthColText));
+        result.addAttribute(stepdepthColText);
+        originSets.push_back(&originRefs);
+    }
+
+    std::vector<std::vector<float>> stepDepths(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        stepDepths[static_cast<size_t>(i)] =
+            traverse(map, *originSets[static_cast<size_t>(i)], static_cast<uint64_t>(i));
+    }
+
+    for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        for (size_t i = 0; i < originSets.size(); i++) {
+            if (stepDepths[i][cursor] >= 0) {
+                row.setValue(stepdepthCols[i], stepDepths[i][cursor]);
+            }
+        }
+    }
+
     result.completed = true;
 
     return result;
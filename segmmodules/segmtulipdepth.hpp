@@ -9,11 +9,15 @@
 #include "../isegment.hpp"
 
 class SegmentTulipDepth : ISegment {
-    std::set<int> m_originRefs;
+    // named sets of origins, each given its own step depth column
+    std::map<std::string, std::set<int>> m_originSets;
     int m_tulipBins = 1024;
 
     [[maybe_unused]] unsigned _padding0 : 4 * 8;
 
+    std::vector<float> traverse(const ShapeGraph &map, const std::set<int> &originRefs,
+                                uint64_t seed) const;
+
   public:
     struct Column {
         inline static const std::string                //
@@ -22,7 +26,10 @@ class SegmentTulipDepth : ISegment {
 
   public:
     SegmentTulipDepth(int tulipBins, std::set<int> originRefs)
-        : m_originRefs(std::move(originRefs)), m_tulipBins(tulipBins), _padding0(0) {}
+        : m_originSets({{"", std::move(originRefs)}}), m_tulipBins(tulipBins), _padding0(0) {}
+    // one search per set, run in parallel, sharing the reading of the map
+    SegmentTulipDepth(int tulipBins, std::map<std::string, std::set<int>> originSets)
+        : m_originSets(std::move(originSets)), m_tulipBins(tulipBins), _padding0(0) {}
     std::string getAnalysisName() const override { return "Tulip Analysis"; }
     AnalysisResult run(Communicator *, ShapeGraph &map, bool) override;
 };
@@ -16,6 +16,10 @@
 #include <float.h>
 #include <time.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 ShapeGraph::ShapeGraph(const std::string &name, int type)
@@ -43,14 +47,16 @@ void ShapeGraph::makeConnections(const KeyVertices &keyvertices) {
     auto connCol = m_attributes->getColumnIndex(ShapeGraph::Column::CONNECTIVITY);
     auto lengCol = m_attributes->getColumnIndex(ShapeGraph::Column::LINE_LENGTH);
 
+    auto allConnections =
+        getAllLineConnections(TOLERANCE_B * std::max(m_region.height(), m_region.width()));
+
     size_t i = 0;
     for (const auto &shape : m_shapes) {
         int key = shape.first;
         AttributeRow &row = m_attributes->getRow(AttributeKey(key));
         // all indices should match...
         m_connectors.push_back(Connector());
-        m_connectors[i].connections =
-            getLineConnections(key, TOLERANCE_B * std::max(m_region.height(), m_region.width()));
+        m_connectors[i].connections = std::move(allConnections[i]);
         row.setValue(connCol, static_cast<float>(m_connectors[i].connections.size()));
         row.setValue(lengCol, static_cast<float>(shape.second.getLine().length()));
         if (keyvertices.size()) {
@@ -177,6 +183,16 @@ std::tuple<bool, bool, bool, int> ShapeGraph::read(std::istream &stream) {
     return shapeMapReadResult;
 }
 
+std::tuple<std::string, int> ShapeGraph::skip(std::istream &stream) {
+    stream.seekg(sizeof(m_keyvertexcount), std::ios::cur);
+    int size = 0;
+    stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+    for (int i = 0; i < size; i++) {
+        dXreadwrite::skipVector<int>(stream);
+    }
+    return ShapeMap::skip(stream);
+}
+
 bool ShapeGraph::writeShapeGraphData(std::ostream &stream) const {
     // note keyvertexcount and keyvertices are different things!  (length keyvertices not the same
     // as keyvertexcount!)
@@ -223,14 +239,14 @@ void ShapeGraph::writeLinksUnlinksAsPairsCSV(std::ostream &stream, char delimite
     stream << "refA" << delimiter << "refB" << delimiter << "link" << std::endl;
 
     for (auto &link : m_links) {
-        stream << genlib::getMapAtIndex(m_shapes, static_cast<size_t>(link.a))->first << delimiter
-               << genlib::getMapAtIndex(m_shapes, static_cast<size_t>(link.b))->first << delimiter
+        stream << m_shapeIndex[link.a]->first << delimiter
+               << m_shapeIndex[link.b]->first << delimiter
                << "1" << std::endl;
     }
 
     for (auto &unlink : m_unlinks) {
-        stream << genlib::getMapAtIndex(m_shapes, static_cast<size_t>(unlink.a))->first << delimiter
-               << genlib::getMapAtIndex(m_shapes, static_cast<size_t>(unlink.b))->first << delimiter
+        stream << m_shapeIndex[unlink.a]->first << delimiter
+               << m_shapeIndex[unlink.b]->first << delimiter
                << "0" << std::endl;
     }
     stream.flags(streamFlags);
@@ -345,6 +361,66 @@ void ShapeGraph::unlinkFromShapeMap(const ShapeMap &shapemap) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+    // a junction between two segments: each is added to the forward or back connections of the
+    // other, and alpha and beta lead away from the junction along the first and second
+    struct SegmentJunction {
+        Point2f alpha, beta;
+        int segA, segB;
+        SegmentRef refToB, refToA;
+        float weight;
+        bool forwardA, forwardB;
+        // false for the junctions along a single line, which do not turn
+        bool weighted;
+
+      private:
+        [[maybe_unused]] unsigned _padding0 : 1 * 8;
+
+      public:
+        SegmentJunction(int a, bool fwdA, SegmentRef toB, int b, bool fwdB, SegmentRef toA,
+                        const Point2f &alph = Point2f(), const Point2f &bet = Point2f(),
+                        bool weigh = true)
+            : alpha(alph), beta(bet), segA(a), segB(b), refToB(toB), refToA(toA), weight(0.0f),
+              forwardA(fwdA), forwardB(fwdB), weighted(weigh), _padding0(0) {}
+    };
+
+    // the angular turns are independent of each other, so they are all worked out in one pass
+    // before any are added to the connectors
+    void weighJunctions(std::vector<SegmentJunction> &junctions) {
+        auto n = static_cast<int>(junctions.size());
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static)
+#endif
+        for (int i = 0; i < n; i++) {
+            SegmentJunction &junction = junctions[static_cast<size_t>(i)];
+            if (!junction.weighted) {
+                continue;
+            }
+            Point2f alpha = junction.alpha;
+            Point2f beta = junction.beta;
+            alpha.normalise();
+            beta.normalise();
+            junction.weight = static_cast<float>(
+                2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) / M_PI);
+        }
+    }
+
+    // in order, as the first connection to a segment is kept
+    void addJunctions(const std::vector<SegmentJunction> &junctions,
+                      std::vector<Connector> &connectors) {
+        for (const auto &junction : junctions) {
+            Connector &connectorA = connectors[static_cast<size_t>(junction.segA)];
+            Connector &connectorB = connectors[static_cast<size_t>(junction.segB)];
+            genlib::addIfNotExists(junction.forwardA ? connectorA.forwardSegconns
+                                                     : connectorA.backSegconns,
+                                   junction.refToB, junction.weight);
+            genlib::addIfNotExists(junction.forwardB ? connectorB.forwardSegconns
+                                                     : connectorB.backSegconns,
+                                   junction.refToA, junction.weight);
+        }
+    }
+} // namespace
+
 // Two ways to make a segment map
 
 // Method 1: direct linkage of endpoints where they touch
@@ -353,35 +429,28 @@ void ShapeGraph::makeNewSegMap(Communicator *comm) {
     // now make a connection set from the ends of lines:
     struct LineConnector {
         const Line4f &line;
-        Connector &connector;
         int index;
 
       private:
         [[maybe_unused]] unsigned _padding0 : 4 * 8;
 
       public:
-        LineConnector(const Line4f &lineIn, Connector &connectorIn, int indexIn)
-            : line(lineIn), connector(connectorIn), index(indexIn), _padding0(0) {}
+        LineConnector(const Line4f &lineIn, int indexIn)
+            : line(lineIn), index(indexIn), _padding0(0) {}
     };
 
-    std::vector<Connector> connectionset;
-    for (auto &shape : m_shapes) {
-        if (shape.second.isLine()) {
-            connectionset.emplace_back();
-        }
-    }
     std::map<size_t, LineConnector> lineConnectors;
-    auto connectionIter = connectionset.begin();
+    std::vector<const LineConnector *> lineConnectorList;
     int connectionIdx = 0;
     for (auto &shape : m_shapes) {
         if (shape.second.isLine()) {
-            lineConnectors.insert(
-                std::make_pair(shape.first, LineConnector(shape.second.getLine(), *connectionIter,
-                                                          connectionIdx)));
-            connectionIter++;
+            auto inserted = lineConnectors.insert(std::make_pair(
+                shape.first, LineConnector(shape.second.getLine(), connectionIdx)));
+            lineConnectorList.push_back(&inserted.first->second);
             connectionIdx++;
         }
     }
+    std::vector<Connector> connectionset(lineConnectorList.size());
 
     time_t atime = 0;
     if (comm) {
@@ -391,85 +460,88 @@ void ShapeGraph::makeNewSegMap(Communicator *comm) {
 
     double maxdim = std::max(m_region.width(), m_region.height());
 
+    // the junctions at the ends of each line are found independently, and then added in the
+    // order of the lines
+    std::vector<std::vector<SegmentJunction>> lineJunctions(lineConnectorList.size());
     size_t count = 0;
-    for (auto &lineConnectorA : lineConnectors) {
-        Connector &connectionsetA = lineConnectorA.second.connector;
-        const Line4f &lineA = lineConnectorA.second.line;
-        int idxA = lineConnectorA.second.index;
+    auto n = static_cast<int>(lineConnectorList.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int ii = 0; ii < n; ii++) {
+        const LineConnector &lineConnectorA = *lineConnectorList[static_cast<size_t>(ii)];
+        std::vector<SegmentJunction> &junctions = lineJunctions[static_cast<size_t>(ii)];
+        const Line4f &lineA = lineConnectorA.line;
+        int idxA = lineConnectorA.index;
         // n.b., vector() is based on t_start and t_end, so we must use t_start and t_end here and
         // throughout
         PixelRef pix1 = pixelate(lineA.t_start());
-        std::vector<ShapeRef> &shapes1 =
+        const std::vector<ShapeRef> &shapes1 =
             m_pixelShapes(static_cast<size_t>(pix1.y), static_cast<size_t>(pix1.x));
         for (auto &shape : shapes1) {
             auto lineConnectorB = lineConnectors.find(shape.shapeRef);
             if (lineConnectorB != lineConnectors.end() && idxA < lineConnectorB->second.index) {
-
-                Connector &connectionsetB = lineConnectorB->second.connector;
                 const Line4f &lineB = lineConnectorB->second.line;
                 int idxB = lineConnectorB->second.index;
-
-                Point2f alpha = lineA.vector();
-                Point2f beta = lineB.vector();
-                alpha.normalise();
-                beta.normalise();
                 if (lineA.t_start().approxeq(lineB.t_start(), (maxdim * TOLERANCE_B))) {
-                    auto x = static_cast<float>(
-                        2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) / M_PI);
-                    genlib::addIfNotExists(connectionsetA.backSegconns, SegmentRef(1, idxB), x);
-                    genlib::addIfNotExists(connectionsetB.backSegconns, SegmentRef(1, idxA), x);
+                    junctions.emplace_back(idxA, false, SegmentRef(1, idxB), idxB, false,
+                                           SegmentRef(1, idxA), lineA.vector(), lineB.vector());
                 }
                 if (lineA.t_start().approxeq(lineB.t_end(), (maxdim * TOLERANCE_B))) {
-                    auto x = static_cast<float>(
-                        2.0 * acos(std::min(std::max(-alpha.dot(-beta), -1.0), 1.0)) / M_PI);
-                    genlib::addIfNotExists(connectionsetA.backSegconns, SegmentRef(-1, idxB), x);
-                    genlib::addIfNotExists(connectionsetB.forwardSegconns, SegmentRef(1, idxA), x);
+                    junctions.emplace_back(idxA, false, SegmentRef(-1, idxB), idxB, true,
+                                           SegmentRef(1, idxA), lineA.vector(), -lineB.vector());
                 }
             }
         }
 
         PixelRef pix2 = pixelate(lineA.t_end());
-        std::vector<ShapeRef> &shapes2 =
+        const std::vector<ShapeRef> &shapes2 =
             m_pixelShapes(static_cast<size_t>(pix2.y), static_cast<size_t>(pix2.x));
         for (auto &shape : shapes2) {
             auto lineConnectorB = lineConnectors.find(shape.shapeRef);
             if (lineConnectorB != lineConnectors.end() && idxA < lineConnectorB->second.index) {
-
-                Connector &connectionsetB = lineConnectorB->second.connector;
                 const Line4f &lineB = lineConnectorB->second.line;
                 int idxB = lineConnectorB->second.index;
-
-                Point2f alpha = lineA.vector();
-                Point2f beta = lineB.vector();
-
-                alpha.normalise();
-                beta.normalise();
                 if (lineA.t_end().approxeq(lineB.t_start(), (maxdim * TOLERANCE_B))) {
-                    auto x = static_cast<float>(
-                        2.0 * acos(std::min(std::max(-(-alpha).dot(beta), -1.0), 1.0)) / M_PI);
-                    genlib::addIfNotExists(connectionsetA.forwardSegconns, SegmentRef(1, idxB), x);
-                    genlib::addIfNotExists(connectionsetB.backSegconns, SegmentRef(-1, idxA), x);
+                    junctions.emplace_back(idxA, true, SegmentRef(1, idxB), idxB, false,
+                                           SegmentRef(-1, idxA), -lineA.vector(), lineB.vector());
                 }
                 if (lineA.t_end().approxeq(lineB.t_end(), (maxdim * TOLERANCE_B))) {
-                    auto x = static_cast<float>(
-                        2.0 * acos(std::min(std::max(-(-alpha).dot(-beta), -1.0), 1.0)) / M_PI);
-                    genlib::addIfNotExists(connectionsetA.forwardSegconns, SegmentRef(-1, idxB), x);
-                    genlib::addIfNotExists(connectionsetB.forwardSegconns, SegmentRef(-1, idxA), x);
+                    junctions.emplace_back(idxA, true, SegmentRef(-1, idxB), idxB, true,
+                                           SegmentRef(-1, idxA), -lineA.vector(),
+                                           -lineB.vector());
                 }
             }
         }
 
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+        count++; // <- increment count
+
+#if defined(_OPENMP)
+        // comm updates only from the main thread
+        if (omp_get_thread_num() == 0)
+#endif
+            if (comm) {
+                if (qtimer(atime, 500)) {
+                    if (comm->IsCancelled()) {
+                        throw Communicator::CancelledException();
+                    }
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
             }
-        }
-        count++;
     }
 
+    std::vector<SegmentJunction> junctions;
+    for (auto &lineJunction : lineJunctions) {
+        junctions.insert(junctions.end(), lineJunction.begin(), lineJunction.end());
+        lineJunction = std::vector<SegmentJunction>();
+    }
+    weighJunctions(junctions);
+    addJunctions(junctions, connectionset);
+
     // initialise attributes now separated from making the connections
     makeSegmentConnections(connectionset);
 }
@@ -494,14 +566,45 @@ void ShapeGraph::makeSegmentMap(std::vector<Line4f> &lines, std::vector<Connecto
 
     // this code relies on the polygon order being the same as the connections
 
-    auto iter = m_shapes.begin();
-    for (size_t i = 0; i < m_connectors.size(); i++) {
-        const auto &shape = iter->second;
-        int axialRef = iter->first;
-        iter++;
+    std::vector<std::pair<int, const SalaShape *>> shapes;
+    shapes.reserve(m_shapes.size());
+    for (const auto &shape : m_shapes) {
+        shapes.emplace_back(shape.first, &shape.second);
+    }
+
+    // TOLERANCE_C is introduced as of 01.08.2008 although it is a fix to a bug first
+    // found in July 2006.  It has been set "high" deliberately (1e-6 = a millionth of the line
+    // height / width) in order to catch small errors made by operators or floating point errors
+    // in other systems when drawing, for example, three axial lines intersecting
+    if (stubremoval == 0.0) {
+        // if 0, convert to tolerance
+        stubremoval = TOLERANCE_C;
+    }
+
+    // each line is split at its breaks independently of the others, into segments numbered
+    // from 0 along the line. The segments are joined up once they are all numbered
+    struct LineBreak {
+        std::vector<int> keylist;
+        int segA, segB;
+    };
+    struct LineSegments {
+        std::vector<Line4f> lines;
+        std::vector<LineBreak> breaks;
+        LineSegments() : lines(), breaks() {}
+    };
+    std::vector<LineSegments> lineSegments(m_connectors.size());
+    auto n = static_cast<int>(m_connectors.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int ii = 0; ii < n; ii++) {
+        auto i = static_cast<size_t>(ii);
+        const auto &shape = *shapes[i].second;
         if (!shape.isLine()) {
             continue;
         }
+        LineSegments &segments = lineSegments[i];
         const Line4f &line = shape.getLine();
         std::vector<std::pair<double, int>> breaks; // this is a vector instead of a map because the
                                                     // original code allowed for duplicate keys
@@ -515,8 +618,7 @@ void ShapeGraph::makeSegmentMap(std::vector<Line4f> &lines, std::vector<Connecto
         for (size_t j = 0; j < connections.size(); j++) {
             // find the intersection point and add...
             // note: more than one break at the same place allowed
-            const auto &shapeJ =
-                genlib::getMapAtIndex(m_shapes, static_cast<size_t>(connections[j]))->second;
+            const auto &shapeJ = *shapes[static_cast<size_t>(connections[j])].second;
             if (i != connections[j] && shapeJ.isLine()) {
                 breaks.push_back(std::make_pair(
                     parity * line.intersection_point(shapeJ.getLine(), axis, TOLERANCE_A),
@@ -527,17 +629,8 @@ void ShapeGraph::makeSegmentMap(std::vector<Line4f> &lines, std::vector<Connecto
         // okay, now we have a list from one end of the other of lines this line connects with
         Point2f lastpoint = line.start();
         int segA = -1, segB = -1;
-        double neardist;
-        // TOLERANCE_C is introduced as of 01.08.2008 although it is a fix to a bug first
-        // found in July 2006.  It has been set "high" deliberately (1e-6 = a millionth of the line
-        // height / width) in order to catch small errors made by operators or floating point errors
-        // in other systems when drawing, for example, three axial lines intersecting
-        if (stubremoval == 0.0) {
-            // if 0, convert to tolerance
-            stubremoval = TOLERANCE_C;
-        }
-        neardist = (axis == LineAxis::XAXIS) ? (line.width() * stubremoval)
-                                             : (line.height() * stubremoval);
+        double neardist = (axis == LineAxis::XAXIS) ? (line.width() * stubremoval)
+                                                    : (line.height() * stubremoval);
         double overlapdist = (axis == LineAxis::XAXIS) ? (line.width() * TOLERANCE_C)
                                                        : (line.height() * TOLERANCE_C);
         //
@@ -549,10 +642,8 @@ void ShapeGraph::makeSegmentMap(std::vector<Line4f> &lines, std::vector<Connecto
                     segA = -1;
                     lastpoint = thispoint;
                 } else {
-                    Line4f segmentA(line.start(), thispoint);
-                    lines.push_back(segmentA);
-                    connectors.push_back(Connector(axialRef));
-                    segA = static_cast<int>(lines.size()) - 1;
+                    segments.lines.emplace_back(line.start(), thispoint);
+                    segA = static_cast<int>(segments.lines.size()) - 1;
                 }
                 lastpoint = thispoint;
             }
@@ -574,116 +665,91 @@ void ShapeGraph::makeSegmentMap(std::vector<Line4f> &lines, std::vector<Connecto
                 } else {
                     thispoint = line.end();
                 }
-                Line4f segmentB(lastpoint, thispoint);
-                lines.push_back(segmentB);
-                connectors.push_back(Connector(axialRef));
-                segB = static_cast<int>(lines.size()) - 1;
+                segments.lines.emplace_back(lastpoint, thispoint);
+                segB = static_cast<int>(segments.lines.size()) - 1;
                 //
                 lastpoint = thispoint;
             }
-            //
-            for (size_t j = 0; j < keylist.size(); j++) {
+            segments.breaks.push_back(LineBreak{std::move(keylist), segA, segB});
+            segA = segB;
+        }
+    }
+
+    // number the segments in the order of the lines, and join them up in the same order, as the
+    // first connection made to a segment is kept
+    std::vector<SegmentJunction> junctions;
+    for (size_t i = 0; i < lineSegments.size(); i++) {
+        LineSegments &segments = lineSegments[i];
+        auto offset = static_cast<int>(lines.size());
+        for (auto &segment : segments.lines) {
+            lines.push_back(segment);
+            connectors.push_back(Connector(shapes[i].first));
+        }
+        for (const auto &lineBreak : segments.breaks) {
+            int segA = lineBreak.segA == -1 ? -1 : lineBreak.segA + offset;
+            int segB = lineBreak.segB == -1 ? -1 : lineBreak.segB + offset;
+            for (int key : lineBreak.keylist) {
                 //
-                if (keylist[j] < static_cast<int>(i)) {
+                if (key < static_cast<int>(i)) {
                     // other line already segmented, look up in segment list,
                     // and join segments together nicely
-                    auto segIter =
-                        segmentlist.find(OrderedIntPair(keylist[j], static_cast<int>(i)));
+                    auto segIter = segmentlist.find(OrderedIntPair(key, static_cast<int>(i)));
 
                     if (segIter !=
                         segmentlist.end()) { // <- if it isn't -1 something has gone badly wrong!
                         int seg1 = segIter->second.first;
                         int seg2 = segIter->second.second;
                         if (segA != -1) {
+                            const Line4f &lineA = lines[static_cast<size_t>(segA)];
                             if (seg1 != -1) {
-                                Point2f alpha = lines[static_cast<size_t>(segA)].start() -
-                                                lines[static_cast<size_t>(segA)].end();
-                                Point2f beta = lines[static_cast<size_t>(seg1)].start() -
-                                               lines[static_cast<size_t>(seg1)].end();
-                                alpha.normalise();
-                                beta.normalise();
-                                auto x = static_cast<float>(
-                                    2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) /
-                                    M_PI);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(segA)].forwardSegconns,
-                                    SegmentRef(-1, seg1), x);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(seg1)].forwardSegconns,
-                                    SegmentRef(-1, segA), x);
+                                const Line4f &line1 = lines[static_cast<size_t>(seg1)];
+                                junctions.emplace_back(segA, true, SegmentRef(-1, seg1), seg1,
+                                                       true, SegmentRef(-1, segA),
+                                                       lineA.start() - lineA.end(),
+                                                       line1.start() - line1.end());
                             }
                             if (seg2 != -1) {
-                                Point2f alpha = lines[static_cast<size_t>(segA)].start() -
-                                                lines[static_cast<size_t>(segA)].end();
-                                Point2f beta = lines[static_cast<size_t>(seg2)].end() -
-                                               lines[static_cast<size_t>(seg2)].start();
-                                alpha.normalise();
-                                beta.normalise();
-                                auto x = static_cast<float>(
-                                    2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) /
-                                    M_PI);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(segA)].forwardSegconns,
-                                    SegmentRef(1, seg2), x);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(seg2)].backSegconns,
-                                    SegmentRef(-1, segA), x);
+                                const Line4f &line2 = lines[static_cast<size_t>(seg2)];
+                                junctions.emplace_back(segA, true, SegmentRef(1, seg2), seg2,
+                                                       false, SegmentRef(-1, segA),
+                                                       lineA.start() - lineA.end(),
+                                                       line2.end() - line2.start());
                             }
                         }
                         if (segB != -1) {
+                            const Line4f &lineB = lines[static_cast<size_t>(segB)];
                             if (seg1 != -1) {
-                                Point2f alpha = lines[static_cast<size_t>(segB)].end() -
-                                                lines[static_cast<size_t>(segB)].start();
-                                Point2f beta = lines[static_cast<size_t>(seg1)].start() -
-                                               lines[static_cast<size_t>(seg1)].end();
-                                alpha.normalise();
-                                beta.normalise();
-                                auto x = static_cast<float>(
-                                    2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) /
-                                    M_PI);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(segB)].backSegconns,
-                                    SegmentRef(-1, seg1), x);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(seg1)].forwardSegconns,
-                                    SegmentRef(1, segB), x);
+                                const Line4f &line1 = lines[static_cast<size_t>(seg1)];
+                                junctions.emplace_back(segB, false, SegmentRef(-1, seg1), seg1,
+                                                       true, SegmentRef(1, segB),
+                                                       lineB.end() - lineB.start(),
+                                                       line1.start() - line1.end());
                             }
                             if (seg2 != -1) {
-                                Point2f alpha = lines[static_cast<size_t>(segB)].end() -
-                                                lines[static_cast<size_t>(segB)].start();
-                                Point2f beta = lines[static_cast<size_t>(seg2)].end() -
-                                               lines[static_cast<size_t>(seg2)].start();
-                                alpha.normalise();
-                                beta.normalise();
-                                auto x = static_cast<float>(
-                                    2.0 * acos(std::min(std::max(-alpha.dot(beta), -1.0), 1.0)) /
-                                    M_PI);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(segB)].backSegconns,
-                                    SegmentRef(1, seg2), x);
-                                genlib::addIfNotExists(
-                                    connectors[static_cast<size_t>(seg2)].backSegconns,
-                                    SegmentRef(1, segB), x);
+                                const Line4f &line2 = lines[static_cast<size_t>(seg2)];
+                                junctions.emplace_back(segB, false, SegmentRef(1, seg2), seg2,
+                                                       false, SegmentRef(1, segB),
+                                                       lineB.end() - lineB.start(),
+                                                       line2.end() - line2.start());
                             }
                         }
                     }
                 } else {
                     // other line still to be segmented, add ourselves to segment list
                     // to be added later
-                    segmentlist.insert(
-                        std::make_pair(OrderedIntPair(static_cast<int>(i), keylist[j]),
-                                       std::pair<int, int>(segA, segB)));
+                    segmentlist.insert(std::make_pair(OrderedIntPair(static_cast<int>(i), key),
+                                                      std::pair<int, int>(segA, segB)));
                 }
             }
             if (segA != -1 && segB != -1) {
-                genlib::addIfNotExists(connectors[static_cast<size_t>(segA)].forwardSegconns,
-                                       SegmentRef(1, segB), 0.0f);
-                genlib::addIfNotExists(connectors[static_cast<size_t>(segB)].backSegconns,
-                                       SegmentRef(-1, segA), 0.0f);
+                junctions.emplace_back(segA, true, SegmentRef(1, segB), segB, false,
+                                       SegmentRef(-1, segA), Point2f(), Point2f(), false);
             }
-            segA = segB;
         }
+        segments = LineSegments();
     }
+    weighJunctions(junctions);
+    addJunctions(junctions, connectors);
 }
 
 void ShapeGraph::initialiseAttributesSegment() {
@@ -707,6 +773,7 @@ void ShapeGraph::makeSegmentConnections(std::vector<Connector> &connectionset) {
     auto refCol = m_attributes->getColumnIndex(Column::AXIAL_LINE_REF);
     auto lengCol = m_attributes->getColumnIndex(Column::SEGMENT_LENGTH);
 
+    m_connectors.reserve(connectionset.size());
     int i = -1;
     for (const auto &shape : m_shapes) {
         i++;
@@ -716,8 +783,6 @@ void ShapeGraph::makeSegmentConnections(std::vector<Connector> &connectionset) {
         row.setValue(refCol, static_cast<float>(connector.segmentAxialref));
         row.setValue(lengCol, static_cast<float>(shape.second.getLine().length()));
 
-        // all indices should match... (including lineset/connectionset versus m_shapes)
-        m_connectors.push_back(connector);
         float totalWeight = 0.0f;
         for (auto iter = connector.forwardSegconns.begin(); iter != connector.forwardSegconns.end();
              ++iter) {
@@ -731,8 +796,9 @@ void ShapeGraph::makeSegmentConnections(std::vector<Connector> &connectionset) {
         row.setValue(uwConnCol, static_cast<float>(connector.forwardSegconns.size() +
                                                    connector.backSegconns.size()));
 
-        // free up connectionset as we go along:
-        connectionset[static_cast<size_t>(i)] = Connector();
+        // all indices should match... (including lineset/connectionset versus m_shapes)
+        // moving frees up connectionset as we go along
+        m_connectors.push_back(std::move(connector));
     }
 }
 
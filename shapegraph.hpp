@@ -57,6 +57,7 @@ class ShapeGraph : public ShapeMap {
 
     bool readShapeGraphData(std::istream &stream);
     std::tuple<bool, bool, bool, int> read(std::istream &stream) override;
+    static std::tuple<std::string, int> skip(std::istream &stream);
     bool writeShapeGraphData(std::ostream &stream) const;
     bool write(std::ostream &stream,
                const std::tuple<bool, bool, int> &displayData = std::make_tuple(true, false,
@@ -8,6 +8,7 @@
 
 #include "attributetable.hpp"
 #include "attributetablehelpers.hpp"
+#include "attributetablestats.hpp"
 #include "latticemap.hpp"
 #include "parsers/mapinfodata.hpp" // for mapinfo interface
 #include "tolerances.hpp"
@@ -17,6 +18,7 @@
 #include "genlib/readwritehelpers.hpp"
 #include "genlib/stringutils.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <stdexcept>
@@ -30,9 +32,9 @@
 
 ShapeMap::ShapeMap(const std::string &name, int type)
     : AttributeMap(name, std::unique_ptr<AttributeTable>(new AttributeTable())), m_mapType(type),
-      m_objRef(-1), m_pixelShapes(0, 0), m_shapes(), m_connectors(), m_tolerance(0.0), m_links(),
-      m_unlinks(), m_mapinfodata(), m_hasMapInfoData(false), m_hasgraph(false), _padding0(0),
-      _padding1(0) {
+      m_objRef(-1), m_pixelShapes(0, 0), m_shapeTree(), m_shapes(), m_shapeIndex(),
+      m_connectors(), m_tolerance(0.0), m_links(), m_unlinks(), m_mapinfodata(),
+      m_hasMapInfoData(false), m_hasgraph(false), _padding0(0), _padding1(0) {
 
     // shape and object counters
 
@@ -59,6 +61,7 @@ void ShapeMap::init(size_t size, const Region4f &r) {
     m_tolerance = std::max(m_region.width(), m_region.height()) * TOLERANCE_A;
     //
     m_pixelShapes = genlib::ColumnMatrix<std::vector<ShapeRef>>(m_rows, m_cols);
+    m_shapeTree.clear();
 }
 
 // this makes an exact copy, keep the reference numbers and so on:
@@ -68,7 +71,7 @@ void ShapeMap::copy(const ShapeMap &sourcemap, int copyflags, bool copyMapType)
         m_mapType = sourcemap.m_mapType;
     }
     if ((copyflags & ShapeMap::COPY_GEOMETRY) == ShapeMap::COPY_GEOMETRY) {
-        m_shapes.clear();
+        clearShapes();
         init(sourcemap.m_shapes.size(), sourcemap.m_region);
         for (const auto &shape : sourcemap.m_shapes) {
             // using makeShape is actually easier than thinking about a total copy:
@@ -127,7 +130,7 @@ void ShapeMap::copy(const ShapeMap &sourcemap, int copyflags, bool copyMapType)
 
 // Zaps all memory structures, apart from mapinfodata
 void ShapeMap::clearAll() {
-    m_shapes.clear();
+    clearShapes();
     m_connectors.clear();
     m_attributes->clear();
     m_links.clear();
@@ -137,6 +140,46 @@ void ShapeMap::clearAll() {
     m_objRef = -1;
 }
 
+// Shows or hides a layer, also refreshing the visible stats of the columns
+void ShapeMap::setLayerVisible(size_t layerid, bool show) {
+    m_layers.setLayerVisible(layerid, show);
+    AttributeStats::updateVisibleStats(*m_attributes, m_layers);
+}
+
+void ShapeMap::clearShapes() {
+    m_shapes.clear();
+    m_shapeIndex.clear();
+}
+
+std::map<int, SalaShape>::iterator ShapeMap::insertShape(int shapeRef, SalaShape shape) {
+    auto inserted = m_shapes.insert(std::make_pair(shapeRef, std::move(shape)));
+    if (inserted.second) {
+        // new shapes usually take the next key, so this is almost always a push_back
+        auto position = std::lower_bound(m_shapeIndex.begin(), m_shapeIndex.end(), shapeRef,
+                                         [](const std::map<int, SalaShape>::iterator &iter,
+                                            int key) { return iter->first < key; });
+        m_shapeIndex.insert(position, inserted.first);
+    }
+    return inserted.first;
+}
+
+void ShapeMap::eraseShape(std::map<int, SalaShape>::iterator shapeIter) {
+    auto position = std::lower_bound(m_shapeIndex.begin(), m_shapeIndex.end(), shapeIter->first,
+                                     [](const std::map<int, SalaShape>::iterator &iter, int key) {
+                                         return iter->first < key;
+                                     });
+    m_shapeIndex.erase(position);
+    m_shapes.erase(shapeIter);
+}
+
+void ShapeMap::indexShapes() {
+    m_shapeIndex.clear();
+    m_shapeIndex.reserve(m_shapes.size());
+    for (auto iter = m_shapes.begin(); iter != m_shapes.end(); ++iter) {
+        m_shapeIndex.push_back(iter);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 
 int ShapeMap::makePointShapeWithRef(const Point2f &point, int shapeRef, bool tempshape,
@@ -148,16 +191,14 @@ int ShapeMap::makePointShapeWithRef(const Point2f &point, int shapeRef, bool tem
         init(m_shapes.size(), Region4f(point, point));
     }
 
-    m_shapes.insert(std::make_pair(shapeRef, SalaShape(point)));
+    insertShape(shapeRef, SalaShape(point));
 
     if (boundsGood) {
         // note: also sets polygon bounding box:
         makePolyPixels(shapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     if (!tempshape) {
@@ -186,16 +227,14 @@ int ShapeMap::makeLineShapeWithRef(const Line4f &line, int shapeRef, bool throug
     }
 
     // note, shape constructor sets centroid, length etc
-    m_shapes.insert(std::make_pair(shapeRef, SalaShape(line)));
+    insertShape(shapeRef, SalaShape(line));
 
     if (boundsGood) {
         // note: also sets polygon bounding box:
         makePolyPixels(shapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     if (!tempshape) {
@@ -276,10 +315,9 @@ int ShapeMap::makePolyShapeWithRef(const std::vector<Point2f> &points, bool open
     // we'll soon tell!
 
     if (open) {
-        m_shapes.insert(std::make_pair(shapeRef, SalaShape(SalaShape::SHAPE_POLY)));
+        insertShape(shapeRef, SalaShape(SalaShape::SHAPE_POLY));
     } else {
-        m_shapes.insert(
-            std::make_pair(shapeRef, SalaShape(SalaShape::SHAPE_POLY | SalaShape::SHAPE_CLOSED)));
+        insertShape(shapeRef, SalaShape(SalaShape::SHAPE_POLY | SalaShape::SHAPE_CLOSED));
     }
     for (i = 0; i < len; i++) {
         m_shapes.rbegin()->second.points.push_back(points[i]);
@@ -290,9 +328,7 @@ int ShapeMap::makePolyShapeWithRef(const std::vector<Point2f> &points, bool open
         makePolyPixels(shapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     if (!tempshape) {
@@ -335,16 +371,14 @@ int ShapeMap::makeShape(const SalaShape &poly, int overrideShapeRef,
         shapeRef = overrideShapeRef;
     }
 
-    m_shapes.insert(std::make_pair(shapeRef, poly));
+    insertShape(shapeRef, poly);
 
     if (boundsGood) {
         // note: also sets polygon bounding box:
         makePolyPixels(shapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     auto &row = m_attributes->addRow(AttributeKey(shapeRef));
@@ -412,16 +446,14 @@ int ShapeMap::makeShapeFromPointSet(const LatticeMap &latticemap, const std::set
     poly.setCentroidAreaPerim();
 
     int newShapeRef = getNextShapeKey();
-    m_shapes.insert(std::make_pair(newShapeRef, poly));
+    insertShape(newShapeRef, poly);
 
     if (boundsGood) {
         // note: also sets polygon bounding box:
         makePolyPixels(newShapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     m_attributes->addRow(AttributeKey(newShapeRef));
@@ -493,9 +525,7 @@ bool ShapeMap::convertPointsToPolys(
         // spatially reindex (simplest just to redo everything)
         init(m_shapes.size(), region);
 
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     return true;
@@ -526,9 +556,7 @@ bool ShapeMap::moveShape(int shaperef, const Line4f &line) {
         makePolyPixels(shaperef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     auto rowid = static_cast<size_t>(std::distance(m_shapes.begin(), shapeIter));
@@ -554,7 +582,7 @@ bool ShapeMap::moveShape(int shaperef, const Line4f &line) {
         if (isAxialMap()) {
             auto lengCol = m_attributes->getOrInsertLockedColumn("Line Length");
             row.setValue(lengCol, static_cast<float>(
-                                      genlib::getMapAtIndex(m_shapes, rowid)->second.getLength()));
+                                      m_shapeIndex[rowid]->second.getLength()));
         }
 
         // now go through our old connections, and remove ourself:
@@ -637,7 +665,7 @@ int ShapeMap::polyBegin(const Line4f &line) {
     }
 
     int newShapeRef = getNextShapeKey();
-    m_shapes.insert(std::make_pair(newShapeRef, SalaShape(line)));
+    insertShape(newShapeRef, SalaShape(line));
     m_shapes.rbegin()->second.m_centroid = line.getCentre();
 
     if (boundsGood) {
@@ -645,9 +673,7 @@ int ShapeMap::polyBegin(const Line4f &line) {
         makePolyPixels(newShapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     // insert into attributes
@@ -697,9 +723,7 @@ bool ShapeMap::polyAppend(int shapeRef, const Point2f &point) {
         makePolyPixels(shapeRef);
     } else {
         // pixelate all polys in the pixel new structure:
-        for (const auto &shape : m_shapes) {
-            makePolyPixels(shape.first);
-        }
+        makeAllPolyPixels();
     }
 
     firstShape.setCentroidAreaPerim();
@@ -806,14 +830,14 @@ void ShapeMap::removeShape(int shaperef) {
     }
 
     if (shapeIter != m_shapes.end()) {
-        shapeIter = m_shapes.erase(shapeIter);
+        eraseShape(shapeIter);
     }
     // n.b., shaperef should have been used to create the row in the first place:
     const AttributeKey shapeRefKey(shaperef);
     m_attributes->removeRow(shapeRefKey);
 }
 
-void ShapeMap::makePolyPixels(int polyref) {
+void ShapeMap::makePolyPixels(int polyref, bool addToShapeTree) {
     // first add into pixels, and ensure you have a bl, tr for the set (useful for
     // testing later)
     auto shapeIter = m_shapes.find(polyref);
@@ -993,6 +1017,20 @@ void ShapeMap::makePolyPixels(int polyref) {
         }
         }
     }
+    if (addToShapeTree) {
+        m_shapeTree.insert(poly.m_region, polyref);
+    }
+}
+
+void ShapeMap::makeAllPolyPixels() {
+    // the regions of closed polygons are set as they are pixelated, so the tree is packed after
+    std::vector<genlib::RTree::Entry> entries;
+    entries.reserve(m_shapes.size());
+    for (const auto &shape : m_shapes) {
+        makePolyPixels(shape.first, false);
+        entries.emplace_back(shape.second.m_region, shape.first);
+    }
+    m_shapeTree.build(std::move(entries));
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1063,6 +1101,7 @@ void ShapeMap::removePolyPixels(int polyref) {
         return;
     }
     SalaShape &poly = shapeIter->second;
+    m_shapeTree.remove(poly.m_region, polyref);
     if (poly.isClosed()) {
         // easiest just to use scan lines to find internal pixels rather than trace
         // a complex border:
@@ -1512,6 +1551,26 @@ std::vector<size_t> ShapeMap::polyInPolyList(int polyref, double tolerance) cons
 
 std::vector<size_t>
 ShapeMap::shapeInPolyList(const SalaShape &shape) { // note: no const due to poly in poly testing
+    if (shape.isPoint() || shape.isLine() || shape.isPolyLine()) {
+        return openShapeInPolyList(shape);
+    }
+    std::vector<size_t> shapeindexlist;
+    if (!m_region.intersects(shape.m_region)) {
+        // quick test that actually coincident
+        return shapeindexlist;
+    }
+    // first *add* the poly temporarily (note this may grow pixel set):
+    int ref = makePolyShape(shape.points, false,
+                            true); // false is closed poly, true is temporary shape
+    // do test:
+    shapeindexlist = polyInPolyList(ref);
+    // clean up:
+    removePolyPixels(ref);
+    eraseShape(m_shapes.find(ref));
+    return shapeindexlist;
+}
+
+std::vector<size_t> ShapeMap::openShapeInPolyList(const SalaShape &shape) const {
     std::vector<size_t> shapeindexlist;
     if (!m_region.intersects(shape.m_region)) {
         // quick test that actually coincident
@@ -1526,15 +1585,6 @@ ShapeMap::shapeInPolyList(const SalaShape &shape) { // note: no const due to pol
             Line4f li(shape.points[i], shape.points[i - 1]);
             shapeindexlist = lineInPolyList(li);
         }
-    } else {
-        // first *add* the poly temporarily (note this may grow pixel set):
-        int ref = makePolyShape(shape.points, false,
-                                true); // false is closed poly, true is temporary shape
-        // do test:
-        shapeindexlist = polyInPolyList(ref);
-        // clean up:
-        removePolyPixels(ref);
-        m_shapes.erase(m_shapes.find(ref));
     }
     return shapeindexlist;
 }
@@ -1839,7 +1889,7 @@ Point2f ShapeMap::getClosestVertex(const Point2f &p) const {
 
 // code to add intersections when shapes are added to the graph one by one:
 size_t ShapeMap::connectIntersected(size_t rowid, bool linegraph) {
-    auto shaperefIter = genlib::getMapAtIndex(m_shapes, rowid);
+    auto shaperefIter = m_shapeIndex[rowid];
     auto connCol = m_attributes->getOrInsertLockedColumn("Connectivity");
     size_t lengCol = 0;
     if (linegraph) {
@@ -1938,6 +1988,83 @@ std::vector<size_t> ShapeMap::getLineConnections(int lineref, double tolerance)
     return connections;
 }
 
+// all the line connections of the map at once, as getLineConnections would give them for each
+// line (and none for shapes that are not lines). The pixels double as a grid hash of the shapes,
+// so each line only tests the open shapes that share a pixel with it, and the lines are connected
+// in parallel
+std::vector<std::vector<size_t>> ShapeMap::getAllLineConnections(double tolerance) const {
+    std::vector<int> shapeKeys;
+    std::vector<const SalaShape *> shapes;
+    shapeKeys.reserve(m_shapes.size());
+    shapes.reserve(m_shapes.size());
+    for (const auto &shape : m_shapes) {
+        shapeKeys.push_back(shape.first);
+        shapes.push_back(&shape.second);
+    }
+
+    std::vector<std::vector<size_t>> allConnections(shapes.size());
+    int missingShape = -1;
+    auto n = static_cast<int>(shapes.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int i = 0; i < n; i++) {
+        const SalaShape &poly = *shapes[static_cast<size_t>(i)];
+        if (!poly.isLine()) {
+            continue;
+        }
+        const Line4f &l = poly.getLine();
+        auto lineref = static_cast<unsigned int>(shapeKeys[static_cast<size_t>(i)]);
+
+        // As of version 10, self-connections are *not* added
+        std::vector<unsigned int> shapesToTest;
+        PixelRefVector list = pixelateLine(l);
+        for (size_t j = 0; j < list.size(); j++) {
+            const std::vector<ShapeRef> &shapeRefs =
+                m_pixelShapes(static_cast<size_t>(list[j].y), static_cast<size_t>(list[j].x));
+            for (const ShapeRef &shape : shapeRefs) {
+                if ((shape.tags & ShapeRef::SHAPE_OPEN) == ShapeRef::SHAPE_OPEN &&
+                    shape.shapeRef != lineref) {
+                    shapesToTest.push_back(shape.shapeRef);
+                }
+            }
+        }
+        std::sort(shapesToTest.begin(), shapesToTest.end());
+        shapesToTest.erase(std::unique(shapesToTest.begin(), shapesToTest.end()),
+                           shapesToTest.end());
+
+        // the shapes are tested in order of key, so the connections come out sorted
+        std::vector<size_t> &connections = allConnections[static_cast<size_t>(i)];
+        for (unsigned int shapeRef : shapesToTest) {
+            auto key = std::lower_bound(shapeKeys.begin(), shapeKeys.end(),
+                                        static_cast<int>(shapeRef));
+            if (key == shapeKeys.end() || *key != static_cast<int>(shapeRef)) {
+#if defined(_OPENMP)
+#pragma omp critical
+#endif
+                missingShape = static_cast<int>(shapeRef);
+                continue;
+            }
+            auto shapeIdx = static_cast<size_t>(std::distance(shapeKeys.begin(), key));
+            const Line4f &line = shapes[shapeIdx]->getLine();
+            if (line.Region4f::intersects(l, line.length() * tolerance)) {
+                // n.b. as getLineConnections, the tolerance is scaled by the length of the
+                // line tested against only
+                if (line.Line4f::intersects(l, line.length() * tolerance)) {
+                    connections.push_back(shapeIdx);
+                }
+            }
+        }
+    }
+    if (missingShape != -1) {
+        throw genlib::RuntimeException("Shape " + std::to_string(missingShape) +
+                                       " not found while testing line connections");
+    }
+
+    return allConnections;
+}
+
 // this is only problematic as there is lots of legacy code with shape-in-shape
 // testing,
 std::vector<size_t> ShapeMap::getShapeConnections(int shaperef, double tolerance) const {
@@ -2059,13 +2186,63 @@ const std::map<int, SalaShape> ShapeMap::getShapesInRegion(const Region4f &r) co
     return shapesInRegion;
 }
 
+std::vector<int> ShapeMap::getShapeRefsInRegion(const Region4f &r) const {
+    std::vector<int> shapeRefs;
+    m_shapeTree.query(r, [&shapeRefs](int shapeRef) { shapeRefs.push_back(shapeRef); });
+    std::sort(shapeRefs.begin(), shapeRefs.end());
+    return shapeRefs;
+}
+
+std::vector<std::vector<int>>
+ShapeMap::getShapeRefsInRegions(const std::vector<Region4f> &regions) const {
+    return m_shapeTree.queryAll(regions);
+}
+
+int ShapeMap::getClosestShapeRef(const Point2f &p, double maxdist) const {
+    auto distanceTo = [this, &p](int shapeRef) {
+        auto shapeIter = m_shapes.find(shapeRef);
+        if (shapeIter == m_shapes.end()) {
+            return -1.0;
+        }
+        const SalaShape &shape = shapeIter->second;
+        if (shape.isPoint()) {
+            return p.dist(shape.getPoint());
+        }
+        if (shape.isLine()) {
+            return shape.getLine().dist(p);
+        }
+        if (shape.points.empty()) {
+            return -1.0;
+        }
+        // distance to the closest edge, or zero if inside a closed polygon by the number of
+        // edges a ray to the right of the point crosses
+        double mindist = -1.0;
+        bool inside = false;
+        size_t edges = shape.isClosed() ? shape.points.size() : shape.points.size() - 1;
+        for (size_t k = 0; k < edges; k++) {
+            const Point2f &a = shape.points[k];
+            const Point2f &b = shape.points[(k + 1) % shape.points.size()];
+            double edgedist = Line4f(a, b).dist(p);
+            if (mindist == -1.0 || edgedist < mindist) {
+                mindist = edgedist;
+            }
+            if ((a.y > p.y) != (b.y > p.y) &&
+                p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+                inside = !inside;
+            }
+        }
+        return (shape.isClosed() && inside) ? 0.0 : mindist;
+    };
+    return m_shapeTree.nearest(p, distanceTo, maxdist).first;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ShapeMap::readNameType(std::istream &stream) {
     m_mapType = ShapeMap::EMPTYMAP;
 
     // clear old:
-    m_shapes.clear();
+    clearShapes();
     m_attributes->clear();
     m_connectors.clear();
     m_links.clear();
@@ -2102,7 +2279,7 @@ bool ShapeMap::readPart2(std::istream &stream) {
     for (int j = 0; j < count; j++) {
         int key;
         stream.read(reinterpret_cast<char *>(&key), sizeof(key));
-        auto iter = m_shapes.insert(std::make_pair(key, SalaShape())).first;
+        auto iter = insertShape(key, SalaShape());
         iter->second.read(stream);
     }
 
@@ -2130,9 +2307,7 @@ bool ShapeMap::readPart3(std::istream &stream) {
     m_pixelShapes = genlib::ColumnMatrix<std::vector<ShapeRef>>(m_rows, m_cols);
     // Now add the pixel shapes pixel map:
     // pixelate all polys in the pixel structure:
-    for (const auto &shape : m_shapes) {
-        makePolyPixels(shape.first);
-    }
+    makeAllPolyPixels();
 
     // shape connections:
     int count = 0;
@@ -2180,6 +2355,44 @@ std::tuple<bool, bool, bool, int> ShapeMap::read(std::istream &stream) {
     return std::tie(read, editable, show, displayedAttribute);
 }
 
+std::tuple<std::string, int> ShapeMap::skip(std::istream &stream) {
+    std::string name = dXstring::readString(stream);
+    int mapType = ShapeMap::EMPTYMAP;
+    stream.read(reinterpret_cast<char *>(&mapType), sizeof(mapType));
+
+    // show, editable, region, rows, cols, next object ref and the deprecated int
+    stream.seekg(sizeof(bool) * 2 + sizeof(Region4f) + sizeof(int) * 2 + sizeof(int) * 2,
+                 std::ios::cur);
+    int count = 0;
+    stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+    for (int j = 0; j < count; j++) {
+        stream.seekg(sizeof(int), std::ios::cur);
+        SalaShape::skip(stream);
+    }
+    count = 0;
+    stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+    for (int k = 0; k < count; k++) {
+        stream.seekg(sizeof(int), std::ios::cur);
+        dXreadwrite::skipVector<int>(stream);
+    }
+    AttributeTable::skip(stream);
+
+    // displayed attribute
+    stream.seekg(sizeof(int), std::ios::cur);
+
+    count = 0;
+    stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+    for (int i = 0; i < count; i++) {
+        Connector::skip(stream);
+    }
+    dXreadwrite::skipVector<OrderedIntPair>(stream);
+    dXreadwrite::skipVector<OrderedIntPair>(stream);
+    if (static_cast<char>(stream.get()) == 'm') {
+        MapInfoData::skip(stream);
+    }
+    return std::make_tuple(std::move(name), mapType);
+}
+
 bool ShapeMap::writeNameType(std::ostream &stream) const {
     // name
     dXstring::writeString(stream, m_name);
@@ -2291,7 +2504,7 @@ bool ShapeMap::output(std::ofstream &stream, char delimiter) {
         int key = iter->getKey().value;
         if (isObjectVisible(m_layers, iter->getRow())) {
             stream << key;
-            const auto &shape = m_shapes[key];
+            const auto &shape = m_shapes.at(key);
             if ((m_mapType & LINEMAP) == 0) {
                 stream << delimiter << shape.m_centroid.x << delimiter << shape.m_centroid.y;
             } else {
@@ -2814,8 +3027,8 @@ std::vector<SimpleLine> ShapeMap::getAllLinkLines() {
     std::vector<SimpleLine> linkLines;
     for (size_t i = 0; i < m_links.size(); i++) {
         linkLines.push_back(
-            SimpleLine(genlib::getMapAtIndex(m_shapes, m_links[i].a)->second.getCentroid(),
-                       genlib::getMapAtIndex(m_shapes, m_links[i].b)->second.getCentroid()));
+            SimpleLine(m_shapeIndex[m_links[i].a]->second.getCentroid(),
+                       m_shapeIndex[m_links[i].b]->second.getCentroid()));
     }
     return linkLines;
 }
@@ -2826,10 +3039,10 @@ std::vector<Point2f> ShapeMap::getAllUnlinkPoints() {
     std::vector<Point2f> unlinkPoints;
     for (size_t i = 0; i < m_unlinks.size(); i++) {
         unlinkPoints.push_back(
-            genlib::getMapAtIndex(m_shapes, m_unlinks[i].a)
+            m_shapeIndex[m_unlinks[i].a]
                 ->second.getLine()
                 .intersection_point(
-                    genlib::getMapAtIndex(m_shapes, m_unlinks[i].b)->second.getLine(),
+                    m_shapeIndex[m_unlinks[i].b]->second.getLine(),
                     TOLERANCE_A));
     }
     return unlinkPoints;
@@ -2843,10 +3056,10 @@ void ShapeMap::outputUnlinkPoints(std::ofstream &stream, char delim) {
     for (size_t i = 0; i < m_unlinks.size(); i++) {
         // note, links are stored directly by rowid, not by key:
         Point2f p =
-            genlib::getMapAtIndex(m_shapes, m_unlinks[i].a)
+            m_shapeIndex[m_unlinks[i].a]
                 ->second.getLine()
                 .intersection_point(
-                    genlib::getMapAtIndex(m_shapes, m_unlinks[i].b)->second.getLine(), TOLERANCE_A);
+                    m_shapeIndex[m_unlinks[i].b]->second.getLine(), TOLERANCE_A);
         stream << p.x << delim << p.y << std::endl;
     }
     stream.flags(streamFlags);
@@ -19,6 +19,7 @@
 #include "salashape.hpp"
 #include "shaperef.hpp"
 
+#include "genlib/rtree.hpp"
 #include "genlib/simpleline.hpp"
 #include "genlib/simplematrix.hpp"
 
@@ -62,8 +63,14 @@ class ShapeMap : public AttributeMap {
     //
     // quick grab for shapes
     genlib::ColumnMatrix<std::vector<ShapeRef>> m_pixelShapes; // i rows of j columns
+    // the bounding boxes of the shapes by key, kept with the pixels above. Unlike the pixels
+    // each shape is held once whatever its size
+    genlib::RTree m_shapeTree;
     //
     std::map<int, SalaShape> m_shapes;
+    // the shapes in key order, so that they may be found by index directly. Kept in step with
+    // m_shapes, which must only be changed through insertShape, eraseShape and clearShapes
+    std::vector<std::map<int, SalaShape>::iterator> m_shapeIndex;
     //
     //
     // for graph functionality
@@ -87,9 +94,16 @@ class ShapeMap : public AttributeMap {
     [[maybe_unused]] unsigned _padding0 : 2 * 8;
     [[maybe_unused]] unsigned _padding1 : 4 * 8;
 
+  protected:
+    std::map<int, SalaShape>::iterator insertShape(int shapeRef, SalaShape shape);
+    void eraseShape(std::map<int, SalaShape>::iterator shapeIter);
+    void indexShapes();
+
   public:
     void moveData(ShapeMap &other) {
         m_shapes = std::move(other.m_shapes);
+        indexShapes();
+        other.m_shapeIndex.clear();
         m_connectors = std::move(other.m_connectors);
         m_links = std::move(other.m_links);
         m_unlinks = std::move(other.m_unlinks);
@@ -113,13 +127,15 @@ class ShapeMap : public AttributeMap {
     ShapeMap(ShapeMap &&other)
         : AttributeMap(std::move(other.m_name), std::move(other.m_attributes),
                        std::move(other.m_attribHandle), std::move(other.m_layers)),
-          m_pixelShapes(std::move(other.m_pixelShapes)), m_shapes(), m_connectors(), m_tolerance(0),
-          m_links(), m_unlinks(), m_mapinfodata(), _padding0(0), _padding1(0) {
+          m_pixelShapes(std::move(other.m_pixelShapes)), m_shapeTree(std::move(other.m_shapeTree)),
+          m_shapes(), m_shapeIndex(), m_connectors(), m_tolerance(0), m_links(), m_unlinks(),
+          m_mapinfodata(), _padding0(0), _padding1(0) {
         moveData(other);
     }
     ShapeMap &operator=(ShapeMap &&other) {
         m_name = std::move(other.m_name);
         m_pixelShapes = std::move(other.m_pixelShapes);
+        m_shapeTree = std::move(other.m_shapeTree);
         m_attributes = std::move(other.m_attributes);
         m_attribHandle = std::move(other.m_attribHandle);
         m_layers = std::move(other.m_layers);
@@ -138,7 +154,7 @@ class ShapeMap : public AttributeMap {
     // that still use them are the connections of the axial/segment maps and the point
     // in polygon functions.
     const std::map<int, SalaShape>::const_iterator getShapeRefFromIndex(size_t index) const {
-        return genlib::getMapAtIndex(m_shapes, index);
+        return m_shapeIndex[index];
     }
     AttributeRow &getAttributeRowFromShapeIndex(size_t index) {
         return m_attributes->getRow(AttributeKey(getShapeRefFromIndex(index)->first));
@@ -148,18 +164,21 @@ class ShapeMap : public AttributeMap {
     }
 
     void clearAll();
+    void clearShapes();
     // num shapes total
     size_t getShapeCount() const { return m_shapes.size(); }
     // num shapes for this object (note, request by object rowid
     // -- on interrogation, this is what you will usually receive)
     size_t getShapeCount(size_t rowid) const {
-        return genlib::getMapAtIndex(m_shapes, rowid)->second.points.size();
+        return m_shapeIndex[rowid]->second.points.size();
     }
     //
-    int getIndex(size_t rowid) const { return genlib::getMapAtIndex(m_shapes, rowid)->first; }
+    int getIndex(size_t rowid) const { return m_shapeIndex[rowid]->first; }
     //
     // add shape tools
-    void makePolyPixels(int shaperef);
+    void makePolyPixels(int shaperef, bool addToShapeTree = true);
+    // (re)index all shapes, packing the shape tree in one go
+    void makeAllPolyPixels();
     void shapePixelBorder(std::map<int, int> &relations, int shaperef, int side, PixelRef currpix,
                           PixelRef minpix, bool first);
     // remove shape tools
@@ -233,16 +252,27 @@ class ShapeMap : public AttributeMap {
                                        double tolerance = 0.0) const;
     std::vector<size_t> polyInPolyList(int polyref, double tolerance = 0.0) const;
     std::vector<size_t> shapeInPolyList(const SalaShape &shape);
+    // as above for points, lines and polylines, which are tested without adding them to the map
+    std::vector<size_t> openShapeInPolyList(const SalaShape &shape) const;
     // helper to make actual test of point in shape:
     std::optional<size_t> testPointInPoly(const Point2f &p, const ShapeRef &shape) const;
     // also allow look for a close polyline:
     int getClosestOpenGeom(const Point2f &p) const;
     // this version simply finds the closest vertex to the point
     Point2f getClosestVertex(const Point2f &p) const;
+    // from the shape tree: keys of the shapes with bounding boxes in a region, sorted, and for
+    // many regions at once
+    std::vector<int> getShapeRefsInRegion(const Region4f &r) const;
+    std::vector<std::vector<int>> getShapeRefsInRegions(const std::vector<Region4f> &regions) const;
+    // key of the shape with its geometry closest to a point, a point inside a polygon being at
+    // distance 0, or -1 if there is none within maxdist (-1 for no limit)
+    int getClosestShapeRef(const Point2f &p, double maxdist = -1.0) const;
     // Connect a particular shape into the graph
     size_t connectIntersected(size_t rowid, bool linegraph);
     // Get the connections for a particular line
     std::vector<size_t> getLineConnections(int lineref, double tolerance);
+    // Get the connections for all lines at once
+    std::vector<std::vector<size_t>> getAllLineConnections(double tolerance) const;
     // Get arbitrary shape connections for a particular shape
     std::vector<size_t> getShapeConnections(int polyref, double tolerance) const;
     // Make all connections
@@ -275,7 +305,7 @@ class ShapeMap : public AttributeMap {
   public:
     // layer functionality
     bool isLayerVisible(size_t layerid) const { return m_layers.isLayerVisible(layerid); }
-    void setLayerVisible(size_t layerid, bool show) { m_layers.setLayerVisible(layerid, show); }
+    void setLayerVisible(size_t layerid, bool show);
 
   public:
     double getDisplayMinValue(size_t attributeIdx) const {
@@ -327,6 +357,7 @@ class ShapeMap : public AttributeMap {
     //
     // dangerous: accessor for the shapes themselves:
     const std::map<int, SalaShape> &getAllShapes() const { return m_shapes; }
+    // n.b., the shapes may be changed through this, but not added or removed (see m_shapeIndex)
     std::map<int, SalaShape> &getAllShapes() { return m_shapes; }
     // required for PixelBase, have to implement your own version of pixelate
     PixelRef pixelate(const Point2f &p, bool constrain = true, int = 1) const override;
@@ -337,6 +368,8 @@ class ShapeMap : public AttributeMap {
     bool readPart2(std::istream &stream);
     bool readPart3(std::istream &stream);
     virtual std::tuple<bool, bool, bool, int> read(std::istream &stream);
+    // move past what read would read, without reading it in, giving the name and type of the map
+    static std::tuple<std::string, int> skip(std::istream &stream);
 
     bool writeNameType(std::ostream &stream) const;
     bool writePart2(std::ostream &stream) const;
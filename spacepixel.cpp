@@ -11,6 +11,7 @@
 #include "genlib/readwritehelpers.hpp"
 #include "genlib/stringutils.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <set>
@@ -247,42 +248,43 @@ bool SpacePixel::intersect(const Line4f &l, double tolerance) {
     return false;
 }
 
-bool SpacePixel::intersect_exclude(const Line4f &l, double tolerance) {
-    m_test++; // note loops! (but vary rarely: inevitabley, lines will have been
-              // marked before it loops)
-
+// unlike intersect, this keeps track of the lines already tested itself rather than marking
+// them, so that many lines may be tested against the same SpacePixel at once
+bool SpacePixel::intersect_exclude(const Line4f &l, double tolerance) const {
     PixelRefVector list = pixelateLine(l);
+    std::vector<int> testedlines;
 
     for (size_t i = 0; i < list.size(); i++) {
         auto &pixelLines =
             m_pixelLines(static_cast<size_t>(list[i].y), static_cast<size_t>(list[i].x));
         for (int lineref : pixelLines) {
+            auto tested = std::lower_bound(testedlines.begin(), testedlines.end(), lineref);
+            if (tested != testedlines.end() && *tested == lineref) {
+                continue;
+            }
             const auto &lineIt = m_lines.find(lineref);
             if (lineIt == m_lines.end()) {
                 throw genlib::RuntimeException("Line " + std::to_string(lineref) +
                                                " not found when looking for intersections");
             }
-            LineTest &linetest = lineIt->second;
-            if (linetest.test != m_test) {
-                if (linetest.line.Region4f::intersects(l, tolerance)) {
-                    if (linetest.line.Line4f::intersects(l, tolerance)) {
-                        if (linetest.line.start() != l.start() &&
-                            linetest.line.start() != l.end() && linetest.line.end() != l.start() &&
-                            linetest.line.end() != l.end()) {
-                            return true;
-                        }
+            const LineTest &linetest = lineIt->second;
+            if (linetest.line.Region4f::intersects(l, tolerance)) {
+                if (linetest.line.Line4f::intersects(l, tolerance)) {
+                    if (linetest.line.start() != l.start() && linetest.line.start() != l.end() &&
+                        linetest.line.end() != l.start() && linetest.line.end() != l.end()) {
+                        return true;
                     }
                 }
-                linetest.test = m_test;
             }
+            testedlines.insert(tested, lineref);
         }
     }
 
     return false;
 }
 
-void SpacePixel::cutLine(Line4f &l, short dir, Communicator *comm) {
-    m_test++;
+void SpacePixel::cutLine(Line4f &l, short dir, Communicator *comm) const {
+    std::vector<int> testedlines;
 
     double tolerance = l.length() * 1e-9;
 
@@ -313,8 +315,9 @@ void SpacePixel::cutLine(Line4f &l, short dir, Communicator *comm) {
                 if (comm)
                     comm->logWarning("cut line exception -- missing line?");
             }
-            LineTest &linetest = lineIt->second;
-            if (linetest.test != m_test) {
+            const LineTest &linetest = lineIt->second;
+            auto tested = std::lower_bound(testedlines.begin(), testedlines.end(), lineref);
+            if (tested == testedlines.end() || *tested != lineref) {
                 if (linetest.line.Region4f::intersects(l, tolerance * linetest.line.length())) {
                     switch (linetest.line.Line4f::intersects_distinguish(
                         l, tolerance * linetest.line.length())) {
@@ -382,7 +385,7 @@ void SpacePixel::cutLine(Line4f &l, short dir, Communicator *comm) {
                         break;
                     }
                 }
-                linetest.test = m_test;
+                testedlines.insert(tested, lineref);
             }
         }
         if (loc.size()) {
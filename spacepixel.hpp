@@ -105,9 +105,9 @@ class SpacePixel : public PixelBase {
     int addLineDynamic(const Line4f &l);
 
     bool intersect(const Line4f &l, double tolerance = 0.0);
-    bool intersect_exclude(const Line4f &l, double tolerance = 0.0);
+    bool intersect_exclude(const Line4f &l, double tolerance = 0.0) const;
 
-    void cutLine(Line4f &l, short dir, Communicator *comm = nullptr);
+    void cutLine(Line4f &l, short dir, Communicator *comm = nullptr) const;
 
     const Region4f &getRegion() const { return static_cast<const Region4f &>(m_region); }
 
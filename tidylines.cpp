@@ -7,8 +7,51 @@
 
 #include "tolerances.hpp"
 
+#include <algorithm>
+
 // helper -- a little class to tidy up a set of lines
 
+namespace {
+    // if the two lines are collinear and overlap, extends the later line j to cover the earlier
+    // line i and returns true, as line i is to be removed
+    bool mergeOverlap(const Line4f &lineI, Line4f &lineJ, double maxdim) {
+        LineAxis axisI = (lineI.width() >= lineI.height()) ? LineAxis::XAXIS : LineAxis::YAXIS;
+        LineAxis axisJ = (lineJ.width() >= lineJ.height()) ? LineAxis::XAXIS : LineAxis::YAXIS;
+        LineAxis axisReverse = (axisI == LineAxis::XAXIS) ? LineAxis::YAXIS : LineAxis::XAXIS;
+        if (axisI == axisJ &&
+            fabs(lineI.grad(axisReverse) - lineJ.grad(axisReverse)) < TOLERANCE_A &&
+            fabs(lineI.constant(axisReverse) - lineJ.constant(axisReverse)) <
+                (TOLERANCE_B * maxdim)) {
+            // check for overlap and merge
+            int parity = (axisI == LineAxis::XAXIS) ? 1 : lineI.sign();
+            if ((lineI.start()[axisI] * parity + TOLERANCE_B * maxdim) >
+                    (lineJ.start()[axisJ] * parity) &&
+                (lineI.start()[axisI] * parity) <
+                    (lineJ.end()[axisJ] * parity + TOLERANCE_B * maxdim)) {
+                if ((lineI.end()[axisI] * parity) > (lineJ.end()[axisJ] * parity)) {
+                    lineJ.bx() = lineI.bx();
+                    lineJ.by() = lineI.by();
+                }
+                return true;
+            }
+            if ((lineJ.start()[axisJ] * parity + TOLERANCE_B * maxdim) >
+                    (lineI.start()[axisI] * parity) &&
+                (lineJ.start()[axisJ] * parity) <
+                    (lineI.end()[axisI] * parity + TOLERANCE_B * maxdim)) {
+                bool endI = (lineI.end()[axisI] * parity) > (lineJ.end()[axisJ] * parity);
+                lineJ.ax() = lineI.ax();
+                lineJ.ay() = lineI.ay();
+                if (endI) {
+                    lineJ.bx() = lineI.bx();
+                    lineJ.by() = lineI.by();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
 void TidyLines::tidy(std::vector<Line4f> &lines, const Region4f &region) {
     m_region = region;
     double maxdim = std::max(m_region.width(), m_region.height());
@@ -26,68 +69,77 @@ void TidyLines::tidy(std::vector<Line4f> &lines, const Region4f &region) {
     }
     sortPixelLines();
 
-    std::vector<int> removelist;
-    for (size_t i = 0; i < lines.size(); i++) {
+    // Each line is merged into the later lines it overlaps, so a line may have been extended by
+    // earlier lines by the time it is merged itself. The later lines sharing a pixel with each
+    // line, and the merges each line would make if no earlier line had changed anything, are
+    // found in parallel. The merges are then made in order, and only the lines next to a line
+    // that has already been extended are checked again
+    struct LineMerges {
+        std::vector<int> candidates;
+        std::vector<std::pair<int, Line4f>> merges;
+        LineMerges() : candidates(), merges() {}
+    };
+    std::vector<LineMerges> lineMerges(lines.size());
+    auto n = static_cast<int>(lines.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+    for (int ii = 0; ii < n; ii++) {
+        auto i = static_cast<size_t>(ii);
         // n.b., as m_lines have just been made, note that what's in m_lines matches
         // whats in lines we will use this later!
-        m_test++;
-        m_lines[static_cast<int>(i)].test = m_test;
-        PixelRefVector list = pixelateLine(m_lines[static_cast<int>(i)].line);
+        std::vector<int> &candidates = lineMerges[i].candidates;
+        PixelRefVector list = pixelateLine(m_lines.at(ii).line);
         for (size_t a = 0; a < list.size(); a++) {
-            auto pixelLines =
+            const auto &pixelLines =
                 m_pixelLines(static_cast<size_t>(list[a].y), static_cast<size_t>(list[a].x));
             for (int j : pixelLines) {
+                if (j > ii) {
+                    candidates.push_back(j);
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        for (int j : candidates) {
+            const Line4f &lineJ = lines[static_cast<size_t>(j)];
+            if (lines[i].Region4f::intersects(lineJ, TOLERANCE_B * maxdim)) {
+                Line4f merged = lineJ;
+                if (mergeOverlap(lines[i], merged, maxdim)) {
+                    lineMerges[i].merges.emplace_back(j, merged);
+                }
+            }
+        }
+    }
+
+    std::vector<int> removelist;
+    std::vector<bool> extended(lines.size(), false);
+    for (size_t i = 0; i < lines.size(); i++) {
+        LineMerges &merges = lineMerges[i];
+        auto isExtended = [&extended](int j) { return extended[static_cast<size_t>(j)]; };
+        bool unchanged = !extended[i] && std::none_of(merges.candidates.begin(),
+                                                      merges.candidates.end(), isExtended);
+        if (unchanged) {
+            for (const auto &merge : merges.merges) {
+                lines[static_cast<size_t>(merge.first)] = merge.second;
+                extended[static_cast<size_t>(merge.first)] = true;
+            }
+            if (!merges.merges.empty()) {
+                removelist.push_back(static_cast<int>(i));
+            }
+        } else {
+            for (int j : merges.candidates) {
                 auto uj = static_cast<size_t>(j);
-                if (m_lines[j].test != m_test && j > static_cast<int>(i) &&
-                    lines[i].Region4f::intersects(lines[uj], TOLERANCE_B * maxdim)) {
-                    m_lines[j].test = m_test;
-                    LineAxis axisI =
-                        (lines[i].width() >= lines[i].height()) ? LineAxis::XAXIS : LineAxis::YAXIS;
-                    LineAxis axisJ = (lines[uj].width() >= lines[uj].height()) ? LineAxis::XAXIS
-                                                                               : LineAxis::YAXIS;
-                    LineAxis axisReverse =
-                        (axisI == LineAxis::XAXIS) ? LineAxis::YAXIS : LineAxis::XAXIS;
-                    if (axisI == axisJ &&
-                        fabs(lines[i].grad(axisReverse) - lines[uj].grad(axisReverse)) <
-                            TOLERANCE_A &&
-                        fabs(lines[i].constant(axisReverse) - lines[uj].constant(axisReverse)) <
-                            (TOLERANCE_B * maxdim)) {
-                        // check for overlap and merge
-                        int parity = (axisI == LineAxis::XAXIS) ? 1 : lines[i].sign();
-                        if ((lines[i].start()[axisI] * parity + TOLERANCE_B * maxdim) >
-                                (lines[uj].start()[axisJ] * parity) &&
-                            (lines[i].start()[axisI] * parity) <
-                                (lines[uj].end()[axisJ] * parity + TOLERANCE_B * maxdim)) {
-                            size_t end = ((lines[i].end()[axisI] * parity) >
-                                          (lines[uj].end()[axisJ] * parity))
-                                             ? i
-                                             : uj;
-                            lines[uj].bx() = lines[end].bx();
-                            lines[uj].by() = lines[end].by();
-                            removelist.push_back(static_cast<int>(i));
-                            continue; // <- don't do this any more, we've zapped it and
-                                      // replaced it with the later line
-                        }
-                        if ((lines[uj].start()[axisJ] * parity + TOLERANCE_B * maxdim) >
-                                (lines[i].start()[axisI] * parity) &&
-                            (lines[uj].start()[axisJ] * parity) <
-                                (lines[i].end()[axisI] * parity + TOLERANCE_B * maxdim)) {
-                            size_t end = ((lines[i].end()[axisI] * parity) >
-                                          (lines[uj].end()[axisJ] * parity))
-                                             ? i
-                                             : uj;
-                            lines[uj].ax() = lines[i].ax();
-                            lines[uj].ay() = lines[i].ay();
-                            lines[uj].bx() = lines[end].bx();
-                            lines[uj].by() = lines[end].by();
-                            removelist.push_back(static_cast<int>(i));
-                            continue; // <- don't do this any more, we've zapped it and
-                                      // replaced it with the later line
-                        }
-                    }
+                if (lines[i].Region4f::intersects(lines[uj], TOLERANCE_B * maxdim) &&
+                    mergeOverlap(lines[i], lines[uj], maxdim)) {
+                    extended[uj] = true;
+                    // we've zapped it and replaced it with the later line
+                    removelist.push_back(static_cast<int>(i));
                 }
             }
         }
+        merges = LineMerges();
     }
 
     // comes out sorted, remove duplicates just in case
@@ -126,23 +178,38 @@ void TidyLines::quicktidy(std::map<int, std::pair<Line4f, int>> &lines, const Re
     }
     sortPixelLines();
 
-    // and chop duplicate lines:
-    std::vector<int> removelist;
-    int i = -1;
+    // and chop duplicate lines, each checked independently of the others:
+    std::vector<const std::pair<const int, std::pair<Line4f, int>> *> lineList;
     for (const auto &line : lines) {
-        i++;
+        lineList.push_back(&line);
+    }
+    std::vector<char> duplicate(lineList.size(), 0);
+    auto n = static_cast<int>(lineList.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static)
+#endif
+    for (int i = 0; i < n; i++) {
+        const auto &line = *lineList[static_cast<size_t>(i)];
         PixelRef start = pixelate(line.second.first.start());
-        auto &pixelLines = m_pixelLines(static_cast<size_t>(start.y), static_cast<size_t>(start.x));
+        const auto &pixelLines =
+            m_pixelLines(static_cast<size_t>(start.y), static_cast<size_t>(start.x));
+        const Line4f &lineI = m_lines.at(i).line;
         for (int k : pixelLines) {
-            if (k > static_cast<int>(i) &&
-                m_lines[i].line.start().approxeq(m_lines[k].line.start(), tolerance)) {
-                if (m_lines[i].line.end().approxeq(m_lines[k].line.end(), tolerance)) {
-                    removelist.push_back(line.first);
+            if (k > i && lineI.start().approxeq(m_lines.at(k).line.start(), tolerance)) {
+                if (lineI.end().approxeq(m_lines.at(k).line.end(), tolerance)) {
+                    duplicate[static_cast<size_t>(i)] = 1;
                     break;
                 }
             }
         }
     }
+    std::vector<int> removelist;
+    for (size_t i = 0; i < lineList.size(); i++) {
+        if (duplicate[i]) {
+            removelist.push_back(lineList[i]->first);
+        }
+    }
     for (int remove : removelist) {
         lines.erase(remove);
     }
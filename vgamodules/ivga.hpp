@@ -77,8 +77,8 @@ class IVGA : public IAnalysis {
     IVGA(const LatticeMap &map) : m_map(map) {}
 
     virtual void
-    copyResultToMap(const std::vector<std::string> &colNames,
-                    const genlib::RowMatrix<double> &colValues, LatticeMap &map,
+    copyResultToMap(const std::vector<std::string> &colNames, AnalysisResult &&result,
+                    LatticeMap &map,
                     std::optional<std::vector<AttributeColumnStats>> columnStats = std::nullopt) {
         AttributeTable &attributes = map.getAttributeTable();
 
@@ -91,13 +91,9 @@ class IVGA : public IAnalysis {
         for (; colNameIt != colNames.end(); colNameIt++, colIdxIt++) {
             *colIdxIt = attributes.getColumnIndex(*colNameIt);
         }
-        auto colValuesIt = colValues.begin();
-        auto rowIt = attributes.begin();
-        for (; rowIt != attributes.end(); rowIt++) {
-            colIdxIt = newColIndxs.begin();
-            for (; colIdxIt != newColIndxs.end(); colIdxIt++, colValuesIt++) {
-                rowIt->getRow().setValue(*colIdxIt, static_cast<float>(std::move(*colValuesIt)));
-            }
+        // move each column whole, the result holding one row for each row of the table
+        for (size_t c = 0; c < newColIndxs.size(); c++) {
+            attributes.setColumnValues(newColIndxs[c], result.takeColumnValues(c));
         }
         if (columnStats.has_value()) {
 
@@ -6,46 +6,87 @@
 
 #include "vgametricdepth.hpp"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 AnalysisResult VGAMetricDepth::run(Communicator *) {
 
     auto &attributes = m_map.getAttributeTable();
 
-    AnalysisResult result({Column::METRIC_STEP_SHORTEST_PATH_ANGLE,
-                           Column::METRIC_STEP_SHORTEST_PATH_LENGTH,
-                           Column::METRIC_STRAIGHT_LINE_DISTANCE},
-                          static_cast<size_t>(m_map.getFilledPointCount()));
-
-    // n.b., insert columns sets values to -1 if the column already exists
-    auto pathAngleColIdx = result.getColumnIndex(Column::METRIC_STEP_SHORTEST_PATH_ANGLE);
-    auto pathLengthColIdx = result.getColumnIndex(Column::METRIC_STEP_SHORTEST_PATH_LENGTH);
-    std::optional<size_t> distColIdx = std::nullopt;
-    if (m_originRefs.size() == 1) {
-        // Note: Euclidean distance is currently only calculated from a single point
-        distColIdx = result.getColumnIndex(Column::METRIC_STRAIGHT_LINE_DISTANCE);
+    std::vector<std::string> colNames;
+    std::vector<const std::set<PixelRef> *> originSets;
+    // the unnamed set always has the distance column, left at -1 if there are several origins
+    std::vector<bool> hasDistCols;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        colNames.push_back(
+            getOriginSetColumn(Column::METRIC_STEP_SHORTEST_PATH_ANGLE, originSetName));
+        colNames.push_back(
+            getOriginSetColumn(Column::METRIC_STEP_SHORTEST_PATH_LENGTH, originSetName));
+        hasDistCols.push_back(originSetName.empty() || originRefs.size() == 1);
+        if (hasDistCols.back()) {
+            colNames.push_back(
+                getOriginSetColumn(Column::METRIC_STRAIGHT_LINE_DISTANCE, originSetName));
+        }
+        originSets.push_back(&originRefs);
     }
 
-    std::vector<AnalysisData> analysisData = getAnalysisData(attributes);
-    const auto refs = getRefVector(analysisData);
-    const auto graph = getGraph(analysisData, refs, true);
+    // n.b., insert columns sets values to -1 if the column already exists
+    AnalysisResult result(std::move(colNames), static_cast<size_t>(m_map.getFilledPointCount()));
 
     bool keepStats = true;
-    AnalysisColumn pathAngleCol, pathLengthCol, euclidDistCol;
+    // path angle, path length and euclidean distance for every set
+    std::vector<std::vector<AnalysisColumn>> traversalResults(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel default(shared) num_threads(std::max(1, std::min(n, omp_get_max_threads())))
+#endif
     {
-        auto traversalResult = traverse(analysisData, graph, refs, -1, m_originRefs, keepStats);
-        pathAngleCol = std::move(traversalResult[0]);
-        pathLengthCol = std::move(traversalResult[1]);
-        euclidDistCol = std::move(traversalResult[2]);
+        // the graph is built once per thread, and only the search state is cleared between sets
+        std::vector<AnalysisData> analysisData = getAnalysisData(attributes);
+        const auto refs = getRefVector(analysisData);
+        const auto graph = getGraph(analysisData, refs, true);
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+        for (int i = 0; i < n; i++) {
+            for (auto &ad : analysisData) {
+                ad.visitedFromBin = 0;
+                ad.dist = -1.0f;
+                ad.cumAngle = 0.0f;
+            }
+            traversalResults[static_cast<size_t>(i)] = traverse(
+                analysisData, graph, refs, -1, *originSets[static_cast<size_t>(i)], keepStats);
+        }
     }
 
-    for (size_t i = 0; i < analysisData.size(); i++) {
-        result.setValue(i, pathAngleColIdx, pathAngleCol.getValue(i));
-        result.setValue(i, pathLengthColIdx, pathLengthCol.getValue(i));
-        if (distColIdx.has_value()) {
-            result.setValue(i, *distColIdx, euclidDistCol.getValue(i));
+    std::vector<AttributeColumnStats> columnStats;
+    size_t colIdx = 0;
+    for (size_t s = 0; s < originSets.size(); s++) {
+        auto &pathAngleCol = traversalResults[s][0];
+        auto &pathLengthCol = traversalResults[s][1];
+        auto &euclidDistCol = traversalResults[s][2];
+        bool hasDistCol = hasDistCols[s];
+        // Note: Euclidean distance is currently only calculated from a single point
+        bool setDistCol = originSets[s]->size() == 1;
+        for (size_t i = 0; i < attributes.getNumRows(); i++) {
+            result.setValue(i, colIdx, pathAngleCol.getValue(i));
+            result.setValue(i, colIdx + 1, pathLengthCol.getValue(i));
+            if (setDistCol) {
+                result.setValue(i, colIdx + 2, euclidDistCol.getValue(i));
+            }
+        }
+        columnStats.push_back(pathAngleCol.getStats());
+        columnStats.push_back(pathLengthCol.getStats());
+        if (hasDistCol) {
+            columnStats.push_back(euclidDistCol.getStats());
         }
+        colIdx += hasDistCol ? 3 : 2;
     }
-    result.columnStats = {pathAngleCol.getStats(), pathLengthCol.getStats(),
-                          euclidDistCol.getStats()};
+    result.columnStats = std::move(columnStats);
 
     result.completed = true;
 
@@ -12,7 +12,8 @@
 
 class VGAMetricDepth : public IVGAMetric {
 
-    std::set<PixelRef> m_originRefs;
+    // named sets of origins, each given its own step depth columns
+    std::map<std::string, std::set<PixelRef>> m_originSets;
 
   public:
     struct Column {
@@ -24,7 +25,10 @@ class VGAMetricDepth : public IVGAMetric {
 
   public:
     VGAMetricDepth(const LatticeMap &map, std::set<PixelRef> originRefs)
-        : IVGAMetric(map), m_originRefs(std::move(originRefs)) {}
+        : IVGAMetric(map), m_originSets({{"", std::move(originRefs)}}) {}
+    // one search per set, run in parallel, sharing the graph within each thread
+    VGAMetricDepth(const LatticeMap &map, std::map<std::string, std::set<PixelRef>> originSets)
+        : IVGAMetric(map), m_originSets(std::move(originSets)) {}
     std::string getAnalysisName() const override { return "Metric Depth"; }
     AnalysisResult run(Communicator *) override;
 };
@@ -39,7 +39,8 @@ AnalysisResult VGAMetricShortestPathToMany::run(Communicator *) {
         }
     }
 
-    AnalysisResult result(std::move(colNames), attributes.getNumRows());
+    // four columns for each destination, kept in float as they only ever get set
+    AnalysisResult result(std::move(colNames), attributes.getNumRows(), -1.0f, true);
 
     std::map<PixelRef, std::vector<size_t>> columns;
     {
@@ -6,24 +6,54 @@
 
 #include "vgavisualglobaldepth.hpp"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 AnalysisResult VGAVisualGlobalDepth::run(Communicator *) {
 
     auto &attributes = m_map.getAttributeTable();
 
-    AnalysisResult result({Column::VISUAL_STEP_DEPTH}, attributes.getNumRows());
+    std::vector<std::string> colNames;
+    std::vector<const std::set<PixelRef> *> originSets;
+    for (auto &[originSetName, originRefs] : m_originSets) {
+        colNames.push_back(getOriginSetColumn(Column::VISUAL_STEP_DEPTH, originSetName));
+        originSets.push_back(&originRefs);
+    }
 
     // n.b., insert columns sets values to -1 if the column already exists
-    auto colIdx = result.getColumnIndex(Column::VISUAL_STEP_DEPTH);
-
-    std::vector<AnalysisData> analysisData = getAnalysisData(attributes);
-
-    const auto refs = getRefVector(analysisData);
-    const auto graph = getGraph(analysisData, refs, false);
-
-    auto sdCol = traverse(analysisData, graph, refs, -1.0f, m_originRefs)[0];
+    AnalysisResult result(std::move(colNames), attributes.getNumRows());
+
+    std::vector<AnalysisColumn> sdCols(originSets.size());
+
+    auto n = static_cast<int>(originSets.size());
+
+#if defined(_OPENMP)
+#pragma omp parallel default(shared) num_threads(std::max(1, std::min(n, omp_get_max_threads())))
+#endif
+    {
+        // the graph is built once per thread, and only the search marks are cleared between sets
+        std::vector<AnalysisData> analysisData = getAnalysisData(attributes);
+
+        const auto refs = getRefVector(analysisData);
+        const auto graph = getGraph(analysisData, refs, false);
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+        for (int i = 0; i < n; i++) {
+            for (auto &ad : analysisData) {
+                ad.visitedFromBin = 0;
+            }
+            sdCols[static_cast<size_t>(i)] = std::move(
+                traverse(analysisData, graph, refs, -1.0f, *originSets[static_cast<size_t>(i)])[0]);
+        }
+    }
 
-    for (size_t i = 0; i < analysisData.size(); i++) {
-        result.setValue(i, colIdx, sdCol.getValue(i));
+    for (size_t colIdx = 0; colIdx < sdCols.size(); colIdx++) {
+        for (size_t i = 0; i < attributes.getNumRows(); i++) {
+            result.setValue(i, colIdx, sdCols[colIdx].getValue(i));
+        }
     }
 
     result.completed = true;
@@ -13,7 +13,8 @@
 
 class VGAVisualGlobalDepth : public IVGAVisual {
 
-    std::set<PixelRef> m_originRefs;
+    // named sets of origins, each given its own step depth column
+    std::map<std::string, std::set<PixelRef>> m_originSets;
 
   public:
     struct Column {
@@ -23,7 +24,11 @@ class VGAVisualGlobalDepth : public IVGAVisual {
 
   public:
     VGAVisualGlobalDepth(const LatticeMap &map, std::set<PixelRef> originRefs)
-        : IVGAVisual(map), m_originRefs(std::move(originRefs)) {}
+        : IVGAVisual(map), m_originSets({{"", std::move(originRefs)}}) {}
+    // one search per set, run in parallel, sharing the graph within each thread
+    VGAVisualGlobalDepth(const LatticeMap &map,
+                         std::map<std::string, std::set<PixelRef>> originSets)
+        : IVGAVisual(map), m_originSets(std::move(originSets)) {}
     std::string getAnalysisName() const override { return "Global Visibility Depth"; }
     AnalysisResult run(Communicator *comm) override;
 };